@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+/**
+Monotonic buffer for the temporary tables of searches.
+Tables are taken by moving an offset forward, and given back all at once when the scope that took them ends,
+so that nested searches use it as a stack. Room is reserved when a game is set up : a search needing more
+adds a block, which is kept for the next searches.
+*/
+class Arena {
+  private:
+    struct Block {
+        std::unique_ptr<std::byte[]> memory;
+        size_t size;
+    };
+    std::vector<Block> blocks;
+    size_t block = 0;  // Block in use
+    size_t offset = 0; // First free byte of that block
+
+    void* takeBytes(size_t bytes, size_t alignment);
+
+  public:
+    Arena() = default;
+    Arena(const Arena &) : Arena() {} // Copies start empty, their owner reserves them again
+    Arena& operator=(const Arena &) = delete;
+
+    // Room for bytes taken at once without adding a block, only called while nothing is taken.
+    void reserve(size_t bytes);
+
+    // Table of count values, given back at the end of the innermost scope.
+    template <typename T>
+    std::span<T> take(size_t count, const T &value = T()) {
+        static_assert(std::is_trivially_destructible_v<T>, "Arena: tables are never destroyed");
+        T *values = static_cast<T *>(takeBytes(count * sizeof(T), alignof(T)));
+        std::uninitialized_fill_n(values, count, value);
+        return {values, count};
+    }
+
+    /**
+    Gives back every table taken since it was opened, when it ends.
+    */
+    class Scope {
+      private:
+        Arena &arena;
+        size_t block;
+        size_t offset;
+
+      public:
+        explicit Scope(Arena &arena) : arena(arena), block(arena.block), offset(arena.offset) {}
+        ~Scope() {
+            arena.block = block;
+            arena.offset = offset;
+        }
+        Scope(const Scope &) = delete;
+        Scope& operator=(const Scope &) = delete;
+    };
+};
@@ -1,9 +1,18 @@
 #pragma once
 
+#include "arena.hpp"
 #include "player.hpp"
 #include "tile.hpp"
-#include <utility>
+#include <array>
+#include <cstdint>
 #include <optional>
+#include <random>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
 
 /**
 Types of cells on the board.
@@ -18,6 +27,11 @@ enum CellType {
     BONUS_ROBBERY
 };
 
+inline const size_t NB_CELL_TYPES = BONUS_ROBBERY + 1;
+
+// Symbols of grass cells, each tile takes the first one its neighbours do not use.
+inline const std::array<std::string, 12> TILE_SYMBOLS = {"██", "██", "▒▒", "░░", "##", "[]", "@@", "&&", "$$", "++", "00", "OO"};
+
 /** 
 Representation of a cell on the board.
 Contains a reference to its type,  a pointer to the owning player if any, and a printing character.
@@ -39,33 +53,415 @@ struct PlacedTile {
   bool bStealable; // To protect starting tiles from robbery bonus
 };
 
+/**
+Cell storage of a board whose size is known at compile time.
+Cells are stored row by row in a fixed array, so that loops over the board have constant bounds.
+*/
+template <size_t N>
+struct FixedGrid {
+    static constexpr size_t size = N;
+    std::array<Cell, N * N> cells;
+
+    Cell& at(size_t x, size_t y) { return cells[x * N + y]; }
+    const Cell& at(size_t x, size_t y) const { return cells[x * N + y]; }
+};
+
+/**
+Cell storage of a board of any size, for custom and very large boards.
+*/
+struct DynamicGrid {
+    size_t size;
+    std::vector<Cell> cells;
+
+    DynamicGrid(size_t size) : size(size), cells(size * size) {}
+
+    Cell& at(size_t x, size_t y) { return cells[x * size + y]; }
+    const Cell& at(size_t x, size_t y) const { return cells[x * size + y]; }
+};
+
+// Board sizes built in, add a FixedGrid to support another size. Other sizes use the DynamicGrid, which must stay last.
+using BoardGrid = std::variant<FixedGrid<20>, FixedGrid<30>, DynamicGrid>;
+
+/**
+Partition of the cells of a board by type.
+Each type lists its cells in no particular order and each cell knows its place in its list,
+so that counting the cells of a type, changing the type of a cell and picking a cell of a type are O(1).
+*/
+class CellCensus {
+  private:
+    std::array<std::vector<uint32_t>, NB_CELL_TYPES> cellsOfType; // Cell indexes, x * size + y
+    std::vector<uint32_t> position;                               // Place of each cell in the list of its type
+
+  public:
+    // Every cell empty, each list has room for every cell.
+    void reset(size_t nbCells);
+    void reserve(size_t nbCells); // Room for every cell in each list, copies only have room for their cells
+
+    void move(uint32_t cell, CellType from, CellType to);
+
+    size_t count(CellType type) const { return cellsOfType[type].size(); }
+    uint32_t at(CellType type, size_t i) const { return cellsOfType[type][i]; }
+};
+
+/**
+Values kept for each player owning cells of a board.
+Entries are stored in place with room for every player of the game, so that adding and removing them does not allocate.
+Players are few, lookups compare pointers in order.
+*/
+template <typename Value>
+class PlayerMap {
+  private:
+    std::vector<std::pair<const Player *, Value>> entries;
+
+  public:
+    // No entry, with room for nbPlayers of them.
+    void reset(size_t nbPlayers) {
+        entries.clear();
+        reserve(nbPlayers);
+    }
+    void reserve(size_t nbPlayers) { entries.reserve(nbPlayers); }
+
+    Value* find(const Player *player) {
+        for (auto &entry : entries)
+            if (entry.first == player)
+                return &entry.second;
+        return nullptr;
+    }
+    const Value* find(const Player *player) const { return const_cast<PlayerMap *>(this)->find(player); }
+
+    // Entry of a player, added with a default value if missing.
+    Value& operator[](const Player *player) {
+        if (Value *value = find(player))
+            return *value;
+        entries.push_back({player, Value()});
+        return entries.back().second;
+    }
+
+    // The last entry takes the place of the removed one.
+    void erase(const Player *player) {
+        for (auto &entry : entries) {
+            if (entry.first == player) {
+                entry = entries.back();
+                entries.pop_back();
+                return;
+            }
+        }
+    }
+
+    void clear() { entries.clear(); }
+    size_t size() const { return entries.size(); }
+    auto begin() { return entries.begin(); }
+    auto end() { return entries.end(); }
+    auto begin() const { return entries.begin(); }
+    auto end() const { return entries.end(); }
+};
+
+/**
+Largest square of a territory.
+Contains its side length and the coordinates of its bottom right corner.
+*/
+struct Square {
+    size_t side;
+    std::pair<size_t, size_t> corner;
+};
+
+/**
+Connected part of a territory.
+Contains its number of cells and its bounding box, whose corners are included.
+*/
+struct Component {
+    size_t area;
+    std::pair<size_t, size_t> topLeft;
+    std::pair<size_t, size_t> bottomRight;
+};
+
+// Phases of a game for anchor statistics, by tenths of the board covered by grass.
+inline const size_t NB_ANCHOR_PHASES = 10;
+
+/**
+Anchors looked at by the placement searches during one phase of a game.
+Candidates are the anchors of placements covering a free cell next to the territory.
+*/
+struct AnchorStats {
+    uint64_t candidates = 0;
+    uint64_t pruned = 0; // Rejected from the summed-area table, without looking at their cells
+};
+
+/**
+Distance from a territory to an uncaptured bonus.
+It counts the steps from the closest cell of the territory, through cells that a tile could cover.
+*/
+struct BonusDistance {
+    std::pair<size_t, size_t> coords;
+    CellType type;
+    size_t distance;
+};
+
+/**
+Effect of stealing a placed tile on its owner, before the thief places it again.
+The sides are the owner's largest square with and without the tile.
+*/
+struct RobberyDelta {
+    size_t tileIndex;                 // In getPlacedTiles()
+    std::pair<size_t, size_t> target; // A cell of the tile, to rob it
+    const Player *victim;
+    size_t cells;                     // Grass the victim loses and the thief places again
+    size_t squareBefore;
+    size_t squareAfter;
+};
+
+/**
+Harm a stone on an empty cell would do to the opponents of the player placing it.
+It counts the opponent placements of the coming tiles that cover the cell, and the sides their square potential would lose.
+*/
+struct StoneImpact {
+    std::pair<size_t, size_t> coords;
+    size_t placements;
+    size_t squareLoss;
+};
+
+/**
+Bonus placed on the board at setup.
+Kept after capture so that the initial layout can be recorded.
+*/
+struct Bonus {
+    std::pair<size_t, size_t> coords;
+    CellType type;
+};
+
+// Board events, sent to observers once the change is done. Cell lists only live during the call.
+struct CellsCovered {        // A tile was placed
+    const Player *player;
+    size_t tileIndex;        // In getPlacedTiles()
+    std::span<const std::pair<size_t, size_t>> cells;
+};
+struct BonusCaptured {       // Cells covered just before are sent first
+    const Player *player;
+    std::pair<size_t, size_t> coords;
+    CellType bonus;
+};
+struct StonePlaced {
+    std::pair<size_t, size_t> coords;
+};
+struct StoneRemoved {
+    std::pair<size_t, size_t> coords;
+};
+struct TileStolen {          // The cells are empty again, the thief places the tile later
+    const Player *victim;
+    const Player *thief;
+    const Tile &tile;
+    std::span<const std::pair<size_t, size_t>> cells;
+};
+struct CellChanged {         // Any other change made with setCell(), such as restoring a snapshot
+    std::pair<size_t, size_t> coords;
+    CellType previousType;
+    const Player *previousOwner;
+    CellType type;
+    const Player *owner;
+};
+struct BoardReset {};        // Cleared and new bonuses laid out by setup()
+
+using BoardEvent = std::variant<CellsCovered, BonusCaptured, StonePlaced, StoneRemoved, TileStolen, CellChanged, BoardReset>;
+
+/**
+Base of the classes observing a board, with a handler doing nothing for each event.
+A derived class hides the handlers it needs : they are found at compile time and called without virtual dispatch,
+and a board without observers does not even build its events.
+*/
+template <typename Derived>
+class BoardObserver {
+  public:
+    void onCellsCovered(const CellsCovered &) {}
+    void onBonusCaptured(const BonusCaptured &) {}
+    void onStonePlaced(const StonePlaced &) {}
+    void onStoneRemoved(const StoneRemoved &) {}
+    void onTileStolen(const TileStolen &) {}
+    void onCellChanged(const CellChanged &) {}
+    void onBoardReset(const BoardReset &) {}
+
+    // Stored by Board::attach(), sends an event to the handler of Derived for its type.
+    static void dispatch(void *observer, const BoardEvent &event) {
+        Derived &self = *static_cast<Derived *>(observer);
+        std::visit([&self](const auto &e) {
+            using Event = std::decay_t<decltype(e)>;
+            if constexpr (std::is_same_v<Event, CellsCovered>)
+                self.onCellsCovered(e);
+            else if constexpr (std::is_same_v<Event, BonusCaptured>)
+                self.onBonusCaptured(e);
+            else if constexpr (std::is_same_v<Event, StonePlaced>)
+                self.onStonePlaced(e);
+            else if constexpr (std::is_same_v<Event, StoneRemoved>)
+                self.onStoneRemoved(e);
+            else if constexpr (std::is_same_v<Event, TileStolen>)
+                self.onTileStolen(e);
+            else if constexpr (std::is_same_v<Event, CellChanged>)
+                self.onCellChanged(e);
+            else
+                self.onBoardReset(e);
+        }, event);
+    }
+};
+
 // Representation of the game board.
 class Board {
   private:
     const size_t size;
-    Cell **grid; // Dynamic 2D array of Cells
+    size_t nbPlayers = 0; // Of the game set up, the room reserved for it follows
+    BoardGrid grid; // Fixed-size storage picked at runtime, kernels are instantiated per size
+    Cell *cells;    // First cell of grid, for direct access without dispatch
     std::vector<PlacedTile> placedTiles;
+    std::vector<Bonus> bonusLayout;
+
+    // Local indexes, so that each turn only looks around the cells it changes
+    std::vector<uint32_t> tileAt; // Index + 1 of the placed tile covering each cell, 0 if none
+    mutable PlayerMap<Square> squares;       // Largest square of each player, computed on demand
+    CellCensus census;                       // Cells of each type
+    std::vector<uint32_t> stealable;         // Indexes of the stealable placed tiles, in no particular order
+    std::vector<uint32_t> stealablePosition; // Place of each placed tile in stealable, NOT_STEALABLE if absent
+    PlayerMap<size_t> stealableCounts;       // Stealable tiles of each owner
+
+    // Territories, merged as cells are taken and split again around stolen tiles
+    std::vector<uint32_t> componentParent; // Union-find over cells, each root has an entry in components
+    std::vector<Component> components;     // Component of each root, by cell index
+    std::vector<uint32_t> nextRoot;        // Roots of a territory are linked through their cells, in no particular order
+    std::vector<uint32_t> previousRoot;    // NOT_ROOT for cells that are not roots
+    PlayerMap<uint32_t> firstRoot;         // Only players owning cells have an entry
+
+    // Distances from territories to bonuses, computed again on demand when a cell changes nearby
+    mutable std::vector<std::vector<std::pair<const Player *, uint16_t>>> bonusReach; // Per bonus of the layout
+    mutable std::vector<bool> bReachStale;
+    std::vector<std::vector<uint32_t>> bonusBuckets; // Bonuses in each bonusHorizon x bonusHorizon block
+
+    // Summed-area tables of one player over the window around its territory where its placements can be, entry (i + 1, j + 1)
+    // counting the cells up to (i, j) of the window. Allowed cells are free and not next to another player, frontier cells
+    // are allowed cells next to the territory. Rows from areaStaleFrom changed and are computed again when needed.
+    mutable std::vector<uint32_t> allowedArea;
+    mutable std::vector<uint32_t> frontierArea;
+    mutable const Player *areaPlayer = nullptr;
+    mutable std::pair<size_t, size_t> areaFrom{0, 0}; // First cell of the window
+    mutable std::pair<size_t, size_t> areaTo{0, 0};   // Cell after the last one of the window
+    mutable size_t areaStaleFrom = 0;
+    mutable std::array<AnchorStats, NB_ANCHOR_PHASES> anchorStats;
+
+    // Buffers of the searches, with room for every cell from setup() on so that searching does not allocate.
+    // Results are kept until the next search of the same kind, temporary tables are taken from scratch.
+    mutable std::vector<std::pair<size_t, size_t>> candidatesBuffer;
+    mutable std::vector<std::pair<size_t, size_t>> anchorsBuffer;
+    mutable std::vector<StoneImpact> impactsBuffer;
+    mutable std::vector<RobberyDelta> deltasBuffer;
+    mutable Arena scratch; // One search at a time, like the buffers
+
+    // Observers, each one with the dispatch function of its class. Copies of the board start without any.
+    struct Listener {
+        void *observer;
+        void (*dispatch)(void *, const BoardEvent &);
+    };
+    std::vector<Listener> listeners;
+
+    template <typename Event>
+    void emit(const Event &event) const {
+        BoardEvent boardEvent(event);
+        for (const Listener &listener : listeners)
+            listener.dispatch(listener.observer, boardEvent);
+    }
+
+    Cell* firstCell();
+    void reserveRoom(); // Room for everything a game adds, so that playing it does not allocate
+    void candidateAnchors(const Shape &shape, const Player &player, std::vector<std::pair<size_t, size_t>> &candidates) const;
+    void updateAreaTables(const Player &player) const; // Moves the window around the player's territory
+    void filterAnchors(const std::vector<std::pair<size_t, size_t>> &candidates, const Shape &shape, const Player &player,
+                       bool bFirstOnly, std::vector<std::pair<size_t, size_t>> &anchors) const; // In parallel on many candidates
+    Square largestSquareIn(const Player &player, size_t x0, size_t x1, size_t y0, size_t y1) const; // In parallel on large windows
+    void setType(std::pair<size_t, size_t> coords, CellType type); // Every change of type goes through the census
+    void indexTile(size_t index);
+    void addStealable(size_t index);
+    void removeStealable(size_t index);
+    bool captureBonus(std::pair<size_t, size_t> coords, Player *player); // If surrounded by the player
+    uint32_t findComponent(uint32_t cell);
+    void addRoot(uint32_t root, const Player *player);
+    void eraseRoot(uint32_t root, const Player *player); // Erased twice, it is only erased once
+    void addTerritoryCell(std::pair<size_t, size_t> coords, const Player *player);
+    void splitTerritory(std::span<const std::pair<size_t, size_t>> removed, const Player *player);
+    void markBonusesAround(std::pair<size_t, size_t> topLeft, std::pair<size_t, size_t> bottomRight);
+    void computeBonusReach(size_t bonus) const;
+    size_t captureBonusesAround(std::pair<size_t, size_t> coords, const Shape &shape, Player *player,
+                                std::span<Bonus> captured); // Returns the number of captured bonuses
+    void updateSquare(std::pair<size_t, size_t> coords, const Shape &shape, const Player &player);
+    size_t squareSideWithout(const Player &player, size_t tile, size_t x0, size_t x1, size_t y0, size_t y1) const; // As if a placed tile was gone
+    void addPotentialLoss(const Player &player, std::span<uint32_t> loss) const; // Side lost by a stone on each cell
 
   public:
-    Board(size_t nbPlayers) : size(nbPlayers < 5 ? 20 : 30), grid(nullptr) { setup(nbPlayers); }
-    ~Board();
+    static constexpr size_t minSize = 5;
+    static constexpr size_t maxSize = 65535;
+    static constexpr size_t bonusHorizon = 16; // Bonuses farther from a territory have no distance
+
+    Board(size_t nbPlayers, uint64_t seed);
+    Board(size_t size, size_t nbPlayers, uint64_t seed); // Custom size, between minSize and maxSize
+    Board(const Board &other);
+    Board& operator=(const Board &) = delete;
+
+    // Size of the board for a number of players : 20 up to 4 players, 30 up to 9, then about 100 cells per player.
+    static size_t defaultSize(size_t nbPlayers);
 
     size_t getSize() const { return size; };
     const std::vector<PlacedTile>& getPlacedTiles() const { return placedTiles; }
-    Cell& getCell(std::pair<size_t, size_t> coords) { return grid[coords.first][coords.second]; }
-    const Cell& getCell(std::pair<size_t, size_t> coords) const { return grid[coords.first][coords.second]; }
+    const std::vector<Bonus>& getBonusLayout() const { return bonusLayout; }
+    Cell& getCell(std::pair<size_t, size_t> coords) { return cells[coords.first * size + coords.second]; } // Change types with setCell()
+    const Cell& getCell(std::pair<size_t, size_t> coords) const { return cells[coords.first * size + coords.second]; }
     void setCell(std::pair<size_t, size_t> coords, CellType type, Player *owner);
 
-    void setup(size_t nbPlayers);
+    void setup(size_t nbPlayers, uint64_t seed); // The same seed always gives the same bonus layout
+
+    // Send every change of the board to an observer deriving from BoardObserver, until it is detached.
+    template <typename Observer>
+    void attach(Observer &observer) { listeners.push_back({&observer, &Observer::dispatch}); }
+    void detach(const void *observer);
+    bool isObserved() const { return !listeners.empty(); }
 
-    void placeBonus(CellType bonusType);
+    void placeBonus(CellType bonusType, std::mt19937 &gen);
 
     bool canPlaceTile(std::pair<size_t, size_t> coords, const Tile &tile, const Player &player, bool bIsStartingTile) const;
+    bool canPlaceShape(std::pair<size_t, size_t> coords, const Shape &shape, const Player &player, bool bIsStartingTile) const; // Same check on an already oriented shape
     bool canPlaceTileAnywhere(const Tile &tile, const Player &player) const;
+    std::vector<std::pair<size_t, size_t>> legalAnchors(const Shape &shape, const Player &player) const; // Every coordinates where an oriented shape can be placed
+    std::span<const std::pair<size_t, size_t>> searchAnchors(const Shape &shape, const Player &player) const; // Same, kept until the next anchor search
     void placeTile(std::pair<size_t, size_t> coords, const Tile &tile, Player *player, bool bStealable);
+    void restorePlacedTiles(std::vector<PlacedTile> tiles); // Cells are restored with setCell()
+    void reassignOwners(const Player *from, Player *to, size_t nbPlayers); // Owners from[i] become to[i], once players are copied
+
+    // Placed tile covering a cell, if any.
+    const PlacedTile* tileAtCell(std::pair<size_t, size_t> coords) const;
+
+    // Live census of the board, kept up to date by every change so that eligibility checks are O(1).
+    size_t countCells(CellType type) const { return census.count(type); }
+    const std::array<AnchorStats, NB_ANCHOR_PHASES>& getAnchorStats() const { return anchorStats; }
+    std::pair<size_t, size_t> cellOfType(CellType type, size_t i) const; // i-th cell of a type, in no particular order
+    std::optional<std::pair<size_t, size_t>> sampleCell(CellType type, std::mt19937 &gen) const;
+    size_t countStealable(const Player &thief) const; // Stealable tiles of the other players
+    std::optional<std::pair<size_t, size_t>> sampleStealable(const Player &thief, std::mt19937 &gen) const; // A cell of one of them
 
     void checkBonusCapture(Player *player);
 
+    // Territory analytics, kept up to date as cells change.
+    std::vector<Component> territoryComponents(const Player &player) const; // Largest first, then in row order
+    Component territory(const Player &player) const;                         // All components together, area 0 if none
+    std::vector<BonusDistance> bonusDistances(const Player &player) const;   // Uncaptured bonuses within bonusHorizon, closest first
+
+    // Largest square made of a player's cells, the first one in row order on ties.
+    // It is kept up to date around placed tiles, and computed again after a robbery or a direct cell change.
+    Square largestSquare(const Player &player) const;
+
+    // Every empty cell in row order, with what a stone there would take from the opponents of a player, given the coming tiles.
+    // The square potential of a player is its largest square of own or free cells that holds an own cell, within bonusHorizon of its territory.
+    // Kept until the next call.
+    std::span<const StoneImpact> stoneImpacts(const Player &player, std::span<const Tile> tiles) const;
+
+    // Every tile a player can steal, in placing order. Each one is evaluated around its own cells. Kept until the next call.
+    std::span<const RobberyDelta> robberyDeltas(const Player &thief) const;
+
+    // Temporary tables of searches on this board, see Arena. Searches on a board run one at a time.
+    Arena& getScratch() const { return scratch; }
+
     std::optional<Tile> stealTile(std::pair<size_t,size_t> target, Player* newOwner);
 
     void display() const;
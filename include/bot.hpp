@@ -0,0 +1,67 @@
+#pragma once
+
+#include "board.hpp"
+#include "deadline.hpp"
+#include "decision.hpp"
+#include "tile.hpp"
+#include <optional>
+#include <span>
+#include <utility>
+
+class Game;
+class OpeningBook;
+
+/**
+Weights of the placement heuristic used by bots.
+Each one scales a feature computed from the cells covered by a candidate placement.
+*/
+struct BotWeights {
+    double squarePotential = 1.0; // Own cells around the covered cells, favours compact territories
+    double frontier = 0.25;       // Empty cells next to the covered cells, room to grow
+    double bonusProximity = 0.5;  // Covered cells next to an uncaptured bonus
+    double blocking = 0.3;        // Covered cells close to an opponent territory
+};
+
+/**
+Placement considered by a bot.
+Contains the oriented tile, its coordinates and its heuristic score.
+*/
+struct Placement {
+    Tile tile;
+    std::pair<size_t, size_t> coords;
+    double score;
+};
+
+/**
+Player that answers every pending decision of a game by itself.
+Placements are chosen greedily with a weighted heuristic, the bot keeps no state between
+decisions so it can take over a seat at any point of a game.
+*/
+class Bot {
+  private:
+    BotWeights weights;
+    const OpeningBook *book = nullptr; // Starting tile locations looked up before searching, if any
+    static constexpr size_t couponNodes = 20000; // Positions searched for the placements of the last coupons
+
+    double evaluate(const Board &board, const Shape &shape, std::pair<size_t, size_t> coords, const Player &player) const;
+    std::pair<size_t, size_t> chooseStartingLocation(const Board &board, const Player &player) const;
+    std::pair<size_t, size_t> chooseStoneLocation(const Board &board, const Player &player, std::span<const Tile> tiles) const;
+    std::pair<size_t, size_t> chooseRobberyTarget(const Board &board, const Player &player) const;
+    int chooseExchange(const Game &game, const Player &player, const Deadline &deadline) const;
+
+  public:
+    Bot(const BotWeights &weights = BotWeights()) : weights(weights) {}
+
+    const BotWeights& getWeights() const { return weights; }
+
+    // The book must outlive the bot, it is shared by every bot it is set on.
+    void setOpeningBook(const OpeningBook *openingBook) { book = openingBook; }
+
+    // Best placement of a tile, in its current orientation or in any of them.
+    // Past the deadline, the best placement found so far, if any was found.
+    std::optional<Placement> bestPlacement(const Board &board, const Tile &tile, const Player &player, bool bAnyOrientation,
+                                           const Deadline &deadline = Deadline()) const;
+
+    // Decision for the game's pending decision. Searches are cut short at the deadline, the decision is still legal.
+    Decision decide(const Game &game, const Deadline &deadline = Deadline()) const;
+};
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <chrono>
+
+/**
+Time by which a search must answer.
+Searches check it now and then, and answer with the best they found so far once it passed.
+A default deadline never passes.
+*/
+class Deadline {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+  private:
+    Clock::time_point limit = Clock::time_point::max();
+
+  public:
+    Deadline() = default;
+    explicit Deadline(Clock::time_point limit) : limit(limit) {}
+
+    // Deadline a budget from now.
+    static Deadline in(Clock::duration budget) { return Deadline(Clock::now() + budget); }
+
+    bool isSet() const { return limit != Clock::time_point::max(); }
+    bool passed() const { return isSet() && Clock::now() >= limit; }
+};
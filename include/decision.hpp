@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+
+/**
+Types of decisions a Game can wait for.
+Each one matches a single prompt of the terminal front-end.
+*/
+enum DecisionType {
+    CHOOSE_NAME,         // text : player name
+    CHOOSE_COLOR,        // choice : index in the available colors, 1 to max
+    PLACE_STARTING_TILE, // coords : starting tile location
+    TAKE_OR_EXCHANGE,    // choice : 1 take tile, 2 use an exchange coupon
+    EXCHANGE_KIND,       // choice : 0 back, 1 exchange a tile from the queue, 2 remove a stone
+    EXCHANGE_TILE,       // choice : 0 cancel, 1 to max tile index in the queue
+    REMOVE_STONE,        // coords : stone to remove
+    ORIENT_TILE,         // choice : 1 place tile, 2 rotate tile, 3 flip tile
+    PLACE_TILE,          // coords : tile location
+    PLACE_STONE,         // coords : stone bonus location
+    ROB_TILE,            // coords : any cell of the tile to steal
+    PLACE_COUPON_TILE,   // coords : 1x1 tile location for a remaining coupon
+    GAME_OVER            // Nothing left to decide
+};
+
+/**
+Decision the game is currently waiting for.
+Contains the type of decision, the index of the player who has to take it,
+and the valid range for choice decisions.
+*/
+struct PendingDecision {
+    DecisionType type;
+    size_t playerIndex;
+    int min = 0;
+    int max = 0;
+};
+
+/**
+Decision submitted by a front-end.
+Only the field matching the decision type is read.
+*/
+struct Decision {
+    DecisionType type;
+    int choice = 0;
+    std::pair<size_t, size_t> coords = {0, 0};
+    std::string text = "";
+};
+
+/**
+Outcome of a submitted decision.
+A rejected decision leaves the game untouched, message then explains why.
+An accepted decision may come with informative messages about what happened.
+The message is kept by the game until its next submit.
+*/
+struct SubmitResult {
+    bool bAccepted;
+    std::string_view message = "";
+};
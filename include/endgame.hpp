@@ -0,0 +1,33 @@
+#pragma once
+
+#include "board.hpp"
+#include "deadline.hpp"
+#include "player.hpp"
+#include <cstddef>
+#include <span>
+#include <utility>
+
+/**
+Placements of a player's remaining coupons, and the final score they lead to.
+The score is the one compared by Game::determineWinner() : largest square, then grass inside it.
+*/
+struct CouponPlan {
+    std::span<const std::pair<size_t, size_t>> placements; // 1x1 tiles, in an order where each one is legal
+    size_t square = 0;
+    size_t grass = 0;
+    size_t nodes = 0;      // Positions searched
+    bool bOptimal = true;  // False if the search stopped at maxNodes or at the deadline
+};
+
+/**
+Best placements of the 1x1 tiles of a player's coupons at the end of the game.
+Captured exchange bonuses give more coupons on the way, as in the game. The search is a branch and bound
+over the sets of placed cells : each set is searched once whatever the order it is reached in, and a branch
+stops once no square left within reach of its coupons can beat the best placements found.
+Its tables are taken from the board's scratch arena, the placements live as long as the caller's Arena::Scope.
+*/
+CouponPlan solveCoupons(const Board &board, const Player &player, size_t coupons, size_t maxNodes = 1000000,
+                        const Deadline &deadline = Deadline());
+
+// Scratch bytes a search takes on a board of this size, reserved by Board::setup().
+size_t couponSearchBytes(size_t boardSize);
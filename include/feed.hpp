@@ -0,0 +1,76 @@
+#pragma once
+
+#include "board.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Game;
+
+// Line sent to many connections, encoded once and shared by all of them.
+using SharedLine = std::shared_ptr<const std::string>;
+
+/**
+Updates of a game for its spectators.
+Changed cells are collected from the board's events, so an update costs the cells it holds and not the size
+of the board. Each update is encoded once as a shared line. Every keyframeInterval updates, the whole game is
+encoded again as a keyframe, from which late spectators catch up.
+
+Lines (ending with a newline) :
+    KEY <table> <sequence> <size> <cells> <symbols> <queue> <counters>
+    DELTA <table> <sequence> <queue> <counters> <row>,<column>,<cell><symbol>...
+Cells use the codes of the BOARD line. Symbols are '.' for none, 'A' + i for TILE_SYMBOLS[i], and 'e', 's' or 'r'
+for a captured bonus. The queue lists the ids of the next tiles separated by '.', counters list the coupons,
+stone and robbery bonuses of each player as c.s.r separated by ','. Both are '-' when empty.
+*/
+class SpectatorFeed : public BoardObserver<SpectatorFeed> {
+  private:
+    uint32_t table;
+    Game &game;
+    std::vector<uint32_t> changed; // Cells changed since the last update, x * size + y
+    std::vector<bool> bChanged;
+    uint64_t sequence = 0;
+    SharedLine keyframe;
+    std::vector<SharedLine> deltas; // Since the keyframe
+
+    void mark(std::pair<size_t, size_t> coords);
+    std::string queueHead() const;
+    std::string counters() const;
+    SharedLine encodeKeyframe() const;
+
+  public:
+    static constexpr size_t keyframeInterval = 32;
+
+    SpectatorFeed(uint32_t table, Game &game); // Observes the game's board until destroyed
+    ~SpectatorFeed();
+    SpectatorFeed(const SpectatorFeed &) = delete;
+    SpectatorFeed& operator=(const SpectatorFeed &) = delete;
+
+    // Cells changed since the last update, in the order they first changed.
+    const std::vector<uint32_t>& changedCells() const { return changed; }
+
+    // Encode what changed since the last update as a DELTA line.
+    SharedLine update();
+
+    // Lines a new spectator needs : the last keyframe and the deltas after it.
+    std::vector<SharedLine> catchUp() const;
+
+    void onCellsCovered(const CellsCovered &event);
+    void onBonusCaptured(const BonusCaptured &event);
+    void onStonePlaced(const StonePlaced &event);
+    void onStoneRemoved(const StoneRemoved &event);
+    void onTileStolen(const TileStolen &event);
+    void onCellChanged(const CellChanged &event);
+    void onBoardReset(const BoardReset &event);
+};
+
+// Characters per cell code : one up to 26 players, two above so that every seat stays a pair of letters.
+size_t cellCodeWidth(size_t nbPlayers);
+
+// Append the code of a cell, grass cells use the owner's seat from 'a' ("aa" above 26 players).
+void appendCellCode(std::string &out, const Cell &cell, const Game &game);
+
+// Single character of the symbol of a cell, see SpectatorFeed.
+char symbolCode(const Cell &cell);
@@ -1,12 +1,27 @@
 #pragma once
 
 #include "board.hpp"
+#include "decision.hpp"
 #include "player.hpp"
+#include "record.hpp"
+#include "snapshot.hpp"
 #include "tile_queue.hpp"
+#include <cstdint>
+#include <initializer_list>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
 #include <vector>
 
+/**
+Representation of a game of Laying Grass.
+The game is an explicit state machine : it never blocks on input, it exposes the decision it is
+waiting for with pendingDecision() and moves forward when a front-end calls submit().
+*/
 class Game {
   private:
+    uint64_t seed;
     Board board;
     TileQueue tileQueue;
     size_t nbPlayers;
@@ -14,20 +29,93 @@ class Game {
     size_t currentRound = 0;
     static const size_t maxRounds = 9;
 
+    // Turn state
+    PendingDecision pending;
+    size_t currentPlayer = 0;
+    std::optional<Tile> currentTile; // Tile being exchanged or placed, if any
+    bool bStealable = true;          // Whether the tile being placed can be robbed later
+    bool bDisplayQueue = true;       // Whether the tile being placed comes from the queue
+
+    // Setup state
+    std::set<PlayerColor> availableColors;
+    std::string pendingName;
+
+    // Informative messages gathered while handling a decision, or why it was rejected.
+    // Room for the longest ones is reserved once every player is seated.
+    std::string notices;
+
+    // Recording, entries of the game in progress are written once it is over
+    RecordWriter *recorder = nullptr;
+    std::vector<RecordEntry> record;
+
+    bool bHints = false; // Whether the terminal front-end suggests the best coupon placements
+
+    void notify(std::initializer_list<std::string_view> pieces); // One message, made of the pieces
+    SubmitResult reject(std::initializer_list<std::string_view> pieces);
+    void wait(DecisionType type, int min = 0, int max = 0);
+    void reserveNotices(); // Once every player is seated
+
+    // Transitions
+    void beginTurn();
+    void beginPlacing(const Tile &tile, bool bStealable, bool bDisplayQueue);
+    void resolveBonuses();
+    void endTurn();
+    void beginCouponPhase();
+
+    // Decision handlers, named after the game step they drive
+    SubmitResult setup(const Decision &decision);
+    SubmitResult playTurn(const Decision &decision);
+    SubmitResult placingTile(const Decision &decision);
+    SubmitResult applyStoneBonus(const Decision &decision);
+    SubmitResult applyRobberyBonus(const Decision &decision);
+    SubmitResult exchangeRemainingCoupons(const Decision &decision);
+
+    // Terminal front-end helpers
+    void prompt() const;
+    Decision readDecision() const;
+
   public:
+    static constexpr size_t minPlayers = 2;
+    static constexpr size_t maxPlayers = 255;
+
     Game(size_t nbPlayers);
+    Game(size_t nbPlayers, uint64_t seed); // The same seed always gives the same board and tile queue
+    Game(size_t nbPlayers, uint64_t seed, size_t boardSize);
+    Game(const Snapshot &snapshot);        // Resume a saved game where it stopped
+    Game(const Game &other);               // Independent copy with its own players, not attached to a recorder
+    Game& operator=(const Game &) = delete;
 
-    void setup();
+    const PendingDecision& pendingDecision() const { return pending; }
+    SubmitResult submit(const Decision &decision);
+    bool isOver() const { return pending.type == GAME_OVER; }
 
-    void display(Player &player, Tile &tile, bool bDisplayQueue) const;
-    void placingTile(Player &player, Tile &tile, bool bStealable, bool bDisplayQueue);
+    const Board& getBoard() const { return board; }
+    const TileQueue& getTileQueue() const { return tileQueue; }
+    size_t getNbPlayers() const { return nbPlayers; }
+    const std::vector<Player>& getPlayers() const { return players; }
+    const std::set<PlayerColor>& getAvailableColors() const { return availableColors; }
+    const std::optional<Tile>& getCurrentTile() const { return currentTile; }
+    size_t getCurrentRound() const { return currentRound; }
+    uint64_t getSeed() const { return seed; }
 
-    void play();
-    void playTurn(Player &player);
+    // Send the changes of the board to an observer, see Board::attach().
+    template <typename Observer>
+    void attachBoardObserver(Observer &observer) { board.attach(observer); }
+    void detachBoardObserver(const void *observer) { board.detach(observer); }
+
+    // Record every accepted decision, the game is written to the recorder once over.
+    void setRecorder(RecordWriter *newRecorder) { recorder = newRecorder; record.reserve(256); }
 
-    void applyStoneBonus(Player &player);
-    void applyRobberyBonus(Player &player);
+    // Save the full game state, including recorded decisions, replacing the file at once.
+    void save(const std::string &path) const;
+
+    // Suggest the placements of the last coupons found by solveCoupons() in the terminal front-end.
+    void setHints(bool bEnabled) { bHints = bEnabled; }
+
+    void display(const Player &player, const Tile &tile, bool bDisplayQueue) const;
+
+    // Terminal front-end : feeds decisions read from standard input until the game is over.
+    void play();
 
-    void exchangeRemainingCoupons(Player &player);
     const Player& determineWinner() const;
-};
\ No newline at end of file
+};
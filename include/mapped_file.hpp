@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+Read-only view of a whole file mapped in memory.
+Where mapping is not available, the file is read into memory instead.
+*/
+class MappedFile {
+  private:
+    const char *data = nullptr;
+    size_t size = 0;
+    bool bMapped = false;
+    std::vector<char> fallback;
+
+  public:
+    MappedFile(const std::string &path);
+    ~MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    MappedFile& operator=(const MappedFile &) = delete;
+
+    const char* getData() const { return data; }
+    size_t getSize() const { return size; }
+};
+
+// Rename a fully written temporary file over path, so that readers see either file whole. False if it failed.
+bool replaceFile(const std::string &temporary, const std::string &path);
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "board.hpp"
+#include "mapped_file.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+Header of an opening book file.
+The header is followed by nbEntries BookEntry sorted by key. All fields are little-endian, as written by the host.
+*/
+struct BookHeader {
+    char magic[4]; // "LGB1"
+    uint16_t version;
+    uint16_t reserved;
+    uint32_t nbEntries;
+    uint32_t padding;
+};
+
+/**
+Starting tile location of a position, in the frame of its canonical symmetry.
+*/
+struct BookEntry {
+    uint64_t key;
+    uint16_t x;
+    uint16_t y;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(BookHeader) == 16, "BookHeader layout changed");
+static_assert(sizeof(BookEntry) == 16, "BookEntry layout changed");
+
+inline const uint16_t BOOK_VERSION = 1;
+
+/**
+Key of a starting position, the same for the 8 rotations and reflections of the board.
+The position is the board size, bonuses, stones and the grass of other players. The key is the smallest one
+of the 8 symmetric boards, and symmetry maps the board onto that one.
+*/
+struct BookKey {
+    uint64_t key;
+    uint8_t symmetry; // Transposed if bit 2, then rows reversed if bit 0, then columns reversed if bit 1
+};
+
+BookKey bookKey(const Board &board, const Player &player);
+
+// Coordinates of a cell once the board is mapped by a symmetry, and back.
+std::pair<size_t, size_t> applySymmetry(uint8_t symmetry, std::pair<size_t, size_t> coords, size_t size);
+std::pair<size_t, size_t> invertSymmetry(uint8_t symmetry, std::pair<size_t, size_t> coords, size_t size);
+
+// Write entries as a book, sorted by key. Later entries of a key replace earlier ones.
+void writeOpeningBook(const std::string &path, std::vector<BookEntry> entries);
+
+/**
+Starting tile locations computed in advance, read from a memory-mapped file.
+A lookup hashes the position and searches the sorted entries in place, nothing is loaded.
+Lookups may come from several threads at once.
+*/
+class OpeningBook {
+  private:
+    MappedFile file;
+    const BookEntry *entries = nullptr;
+    size_t nbEntries = 0;
+    mutable std::atomic<size_t> nbHits{0};
+    mutable std::atomic<size_t> nbMisses{0};
+
+  public:
+    OpeningBook(const std::string &path); // Throws if the file is not a book
+
+    // Location of the player's starting tile, if the position is in the book and the location is legal.
+    std::optional<std::pair<size_t, size_t>> lookup(const Board &board, const Player &player) const;
+
+    // Every entry, sorted by key.
+    std::vector<BookEntry> getEntries() const { return {entries, entries + nbEntries}; }
+
+    size_t getNbEntries() const { return nbEntries; }
+    size_t getNbHits() const { return nbHits; }
+    size_t getNbMisses() const { return nbMisses; }
+};
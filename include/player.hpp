@@ -16,6 +16,8 @@ class Player {
   public:
     Player(const std::string &name, PlayerColor color)
         : name(name), color(color), coupons(1), stoneBonus(0), robberyBonus(0) {}
+    Player(const std::string &name, PlayerColor color, size_t coupons, size_t stoneBonus, size_t robberyBonus)
+        : name(name), color(color), coupons(coupons), stoneBonus(stoneBonus), robberyBonus(robberyBonus) {}
 
     const std::string& getName() const { return name; } // Returns a constant reference to the player's name
     PlayerColor getColor() const { return color; } // Returns the player's color by value
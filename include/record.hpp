@@ -0,0 +1,131 @@
+#pragma once
+
+#include "decision.hpp"
+#include "mapped_file.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+class Game;
+
+// Tile identifier of entries taken while no tile is in hand.
+inline const uint8_t RECORD_NO_TILE = 254;
+
+/**
+Header of a recorded game.
+A record is the header, followed by nbPlayers RecordPlayer, nbBonuses RecordBonus and nbEntries
+RecordEntry, padded to a multiple of 8 bytes. Records are appended one after the other in a file.
+All fields are little-endian, as written by the host.
+*/
+struct RecordHeader {
+    char magic[4];       // "LGR1"
+    uint16_t version;
+    uint16_t boardSize;
+    uint64_t seed;       // Seed of the board and the tile queue
+    uint32_t nbEntries;
+    uint16_t nbBonuses;
+    uint8_t nbPlayers;
+    uint8_t reserved;
+    uint32_t recordSize; // Size of the whole record in bytes, header included
+    uint32_t padding;
+};
+
+/**
+Player of a recorded game, in seat order.
+*/
+struct RecordPlayer {
+    char name[15]; // Truncated, null-terminated if shorter
+    uint8_t color;
+};
+
+/**
+Bonus of the initial board layout.
+*/
+struct RecordBonus {
+    uint16_t x;
+    uint16_t y;
+    uint8_t type; // CellType
+    uint8_t padding[3];
+};
+
+/**
+Decision accepted during a recorded game.
+The tile fields describe the tile in hand when the decision was taken.
+*/
+struct RecordEntry {
+    uint8_t type;        // DecisionType
+    uint8_t player;
+    uint8_t tileId;      // Index in TILE_SHAPES, STARTING_TILE_ID or RECORD_NO_TILE
+    uint8_t orientation; // Quarter turns in the low 2 bits, flip in bit 2
+    int16_t choice;      // Menu choice, exchange index
+    uint16_t x;          // Anchor, stone or robbery target
+    uint16_t y;
+    uint16_t reserved;
+};
+
+static_assert(sizeof(RecordHeader) == 32, "RecordHeader layout changed");
+static_assert(sizeof(RecordPlayer) == 16, "RecordPlayer layout changed");
+static_assert(sizeof(RecordBonus) == 8, "RecordBonus layout changed");
+static_assert(sizeof(RecordEntry) == 12, "RecordEntry layout changed");
+
+inline const uint16_t RECORD_VERSION = 2;
+
+// Decision stored by an entry.
+inline Decision toDecision(const RecordEntry &entry) {
+    return Decision{static_cast<DecisionType>(entry.type), entry.choice, {entry.x, entry.y}};
+}
+
+/**
+Append-only writer of game records.
+Games keep their entries in memory while they are played, a finished game is written with a
+single buffered write so that recording a move costs no more than a vector append.
+*/
+class RecordWriter {
+  private:
+    std::FILE *file;
+    std::vector<char> buffer; // stdio buffer
+    std::vector<char> staging;
+
+  public:
+    RecordWriter(const std::string &path); // Appends to the file, creating it if needed
+    ~RecordWriter();
+    RecordWriter(const RecordWriter &) = delete;
+    RecordWriter& operator=(const RecordWriter &) = delete;
+
+    // Append the record of a finished game.
+    void write(const Game &game, const std::vector<RecordEntry> &entries);
+
+    void flush();
+};
+
+/**
+View of one record inside a mapped file.
+Pointers refer to the reader's mapping and are valid as long as the reader lives.
+*/
+struct RecordView {
+    const RecordHeader *header;
+    const RecordPlayer *players;
+    const RecordBonus *bonuses;
+    const RecordEntry *entries;
+};
+
+/**
+Zero-copy reader of a record file.
+The file is mapped in memory and records are iterated in place, nothing is parsed or copied.
+*/
+class RecordReader {
+  private:
+    MappedFile file;
+    size_t offset = 0;
+
+  public:
+    RecordReader(const std::string &path) : file(path) {}
+
+    // Next record of the file, false once the end is reached. Throws on a corrupted record.
+    bool next(RecordView &view);
+
+    // Go back to the first record.
+    void rewind() { offset = 0; }
+};
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "board.hpp"
+#include "spsc_ring.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+class Game;
+
+/**
+Compact change sent from the game thread to the output thread.
+CELL events keep the output thread's copy of the board, the others are written to the log,
+and FRAME asks for the board to be drawn as it is once every event before it is applied.
+*/
+struct RenderEvent {
+    enum Kind : uint8_t { RESET, PLAYER, CELL, COVER, CAPTURE, STONE, STEAL, FRAME };
+    static constexpr uint16_t NO_PLAYER = UINT16_MAX;
+    static constexpr uint16_t LOG_ONLY = 1;  // FRAME written to the log but not drawn, the board being out of sync
+    static constexpr uint16_t DRAW_ONLY = 2; // FRAME drawn again once the board is back in sync, already in the log
+
+    Kind kind;
+    uint8_t type;    // CellType of CELL and CAPTURE, PlayerColor of PLAYER, DecisionType of FRAME, 1 if STONE is placed
+    uint16_t player; // Index of the player involved
+    uint16_t other;  // Victim of STEAL, LOG_ONLY or DRAW_ONLY for FRAME
+    uint32_t x;      // Row of a cell, size of RESET, round of FRAME
+    uint32_t y;      // Column of a cell, cells of COVER and STEAL
+};
+
+/**
+Output thread drawing a game and writing its log, fed through a single-producer single-consumer ring.
+The game thread only copies small events into the ring, so it never waits for the terminal or the disk. When the
+ring is full, it drops cells and frames and sends the whole board again at the next frame once the ring drained,
+and only keeps the colors of the players and the events of the log in order on its own side. When the output
+thread falls behind, it applies every pending event and only draws the last frame.
+*/
+class RenderPipeline : public BoardObserver<RenderPipeline> {
+  private:
+    // Game thread
+    const Game *game = nullptr;
+    std::vector<bool> bAnnounced;      // Players whose color was sent
+    std::vector<RenderEvent> overflow; // Events waiting for room in the ring, oldest first
+    SpscRing<RenderEvent> ring;
+    bool bResync = false;  // Cells were dropped, the board must be sent again
+    bool bSyncing = false; // The board is being sent again, its events are all kept
+    std::optional<RenderEvent> lastFrame;
+    bool bFrameOwed = false; // The last frame was not drawn
+    size_t nbDropped = 0;    // Frames dropped with the cells
+
+    // Output thread
+    std::ostream *screen; // Frames are only counted without one
+    std::ostream *log;
+    size_t size = 0;
+    std::vector<std::pair<uint8_t, uint16_t>> cells; // Type and owner index of each cell
+    std::vector<PlayerColor> colors;
+    size_t nbFrames = 0;
+    size_t nbSkipped = 0; // Frames replaced by a later one before being drawn
+
+    std::thread output;
+    std::atomic<bool> bStopping{false};
+    std::atomic<bool> bIdle{false};       // Output thread about to wait for events
+    std::atomic<uint32_t> wakeups{0};
+
+    void handOver(); // Move the events of overflow into the ring, as many as fit
+    void publish(const RenderEvent &event);
+    void skipFrame(const RenderEvent &frame);
+    void resync(const std::optional<RenderEvent> &frame);
+    void publishBoard();
+    uint16_t indexOf(const Player *player);
+    void publishCell(std::pair<size_t, size_t> coords, CellType type, const Player *owner);
+    void run();
+    void apply(const RenderEvent &event);
+    void draw(const RenderEvent &frame) const;
+
+  public:
+    RenderPipeline(std::ostream *screen, std::ostream *log = nullptr, size_t capacity = 4096); // Capacity is a power of two
+    ~RenderPipeline();
+    RenderPipeline(const RenderPipeline &) = delete;
+    RenderPipeline& operator=(const RenderPipeline &) = delete;
+
+    // Follow the changes of a game's board from now on, starting with a copy of it. Call from the game thread.
+    void watch(Game &watched);
+
+    // Ask for a frame of the game as it is now. Call from the game thread.
+    void frame();
+
+    // Draw what is left and stop the output thread. The counts below are final once closed.
+    void close();
+
+    size_t getNbFrames() const { return nbFrames; }
+    size_t getNbSkipped() const { return nbSkipped + nbDropped; }
+
+    void onCellsCovered(const CellsCovered &event);
+    void onBonusCaptured(const BonusCaptured &event);
+    void onStonePlaced(const StonePlaced &event);
+    void onStoneRemoved(const StoneRemoved &event);
+    void onTileStolen(const TileStolen &event);
+    void onCellChanged(const CellChanged &event);
+    void onBoardReset(const BoardReset &event);
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "game.hpp"
+#include "record.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// Game of a record right after its players chose their names and colors. Throws if the record does not match.
+std::unique_ptr<Game> replayStart(const RecordView &view);
+
+/**
+Cursor over a recorded game, able to move to any decision.
+The game is replayed from its seed, and a copy of it is kept every interval decisions as a keyframe.
+Keyframes are made the first time the cursor goes past them, so that a later seek only replays the
+decisions after the keyframe before its target, stepping backward included.
+*/
+class ReplayCursor {
+  private:
+    RecordView view;
+    size_t interval;
+    std::vector<std::unique_ptr<const Game>> keyframes; // keyframes[i] is the game before entry i * interval
+    std::unique_ptr<Game> game;
+    uint32_t position = 0; // Entries applied to game
+    std::function<void(Game &)> follow; // Attaches the observer to a restored game
+    const void *observer = nullptr;
+
+    void stepForward();
+
+  public:
+    ReplayCursor(const RecordView &view, size_t interval = 32); // Throws if the record does not match
+    ReplayCursor(const ReplayCursor &) = delete;
+    ReplayCursor& operator=(const ReplayCursor &) = delete;
+
+    // Send the changes of the board to an observer deriving from BoardObserver, one at most, until it is detached.
+    // Restoring a keyframe replaces the game : the observer follows it and gets a BoardReset.
+    template <typename Observer>
+    void attachBoardObserver(Observer &newObserver) {
+        detachBoardObserver();
+        observer = &newObserver;
+        follow = [&newObserver](Game &restored) {
+            restored.attachBoardObserver(newObserver);
+            newObserver.onBoardReset(BoardReset{});
+        };
+        game->attachBoardObserver(newObserver);
+    }
+    void detachBoardObserver();
+
+    const Game& getGame() const { return *game; }
+    uint32_t getPosition() const { return position; }
+    uint32_t getNbEntries() const { return view.header->nbEntries; }
+    size_t getNbKeyframes() const { return keyframes.size(); }
+
+    // Entry applied last, nullptr at the start.
+    const RecordEntry* lastEntry() const { return position > 0 ? &view.entries[position - 1] : nullptr; }
+
+    // Move to the game after the first target entries, at most the number of entries.
+    void seek(uint32_t target);
+
+    // Move one entry forward or backward, false when already at the end or the start.
+    bool next();
+    bool previous();
+};
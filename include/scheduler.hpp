@@ -0,0 +1,217 @@
+#pragma once
+
+#include "bot.hpp"
+#include "deadline.hpp"
+#include "decision.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+class Game;
+class DecisionPool;
+
+/**
+Coroutine driving one game.
+It starts suspended, a Scheduler resumes it whenever the decision it waits for is available.
+*/
+class GameTask {
+  public:
+    struct promise_type {
+        std::exception_ptr exception;
+
+        GameTask get_return_object() { return GameTask(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { exception = std::current_exception(); }
+    };
+
+  private:
+    std::coroutine_handle<promise_type> handle;
+
+  public:
+    GameTask() = default;
+    explicit GameTask(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+    GameTask(GameTask &&other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+    GameTask& operator=(GameTask &&other) noexcept;
+    GameTask(const GameTask &) = delete;
+    GameTask& operator=(const GameTask &) = delete;
+    ~GameTask();
+
+    std::coroutine_handle<> getHandle() const { return handle; }
+    bool done() const { return !handle || handle.done(); }
+
+    // Rethrow the exception that ended the coroutine, if any.
+    void rethrow() const;
+};
+
+/**
+Single-thread run queue multiplexing every live game.
+Suspended games cost nothing but their coroutine frame : no thread and no stack per game.
+Bot decisions are taken on the scheduler thread, or on a DecisionPool whose workers hand the games back
+through an inbox. Either way, each one gets the scheduler's budget, if any.
+*/
+class Scheduler {
+  private:
+    std::vector<std::coroutine_handle<>> ready; // Resumed from the front, room is reserved by start
+    size_t nbStarted = 0;
+    DecisionPool *pool = nullptr;
+    Deadline::Clock::duration budget = Deadline::Clock::duration::zero(); // None when zero
+    size_t nbAway = 0; // Games waiting for the pool
+
+    // Games handed back by other threads
+    std::mutex inboxMutex;
+    std::condition_variable inboxReady;
+    std::vector<std::coroutine_handle<>> inbox;
+    std::function<void()> wakeup;
+
+    void collect();
+
+  public:
+    // Queue a coroutine to be resumed.
+    void post(std::coroutine_handle<> handle) { ready.push_back(handle); }
+
+    // Queue a coroutine to be resumed from another thread, then call the wake-up function.
+    void postFromThread(std::coroutine_handle<> handle);
+
+    // Queue a game for its first resumption.
+    void start(const GameTask &task);
+
+    bool hasReady() const { return !ready.empty(); }
+
+    // Resume every coroutine that was ready when called, returns how many were resumed.
+    size_t runReady();
+
+    // Resume coroutines until none is ready and no decision is left on the pool.
+    void run();
+
+    // Take bot decisions on a pool, which must outlive the games, or on the scheduler thread if null.
+    void setDecisionPool(DecisionPool *newPool) { pool = newPool; }
+    DecisionPool* getDecisionPool() const { return pool; }
+
+    // Time given to each bot decision, searches are cut short past it. Zero lets them run to the end.
+    void setBudget(Deadline::Clock::duration newBudget) { budget = newBudget; }
+    Deadline deadlineFrom(Deadline::Clock::time_point start) const { return budget > budget.zero() ? Deadline(start + budget) : Deadline(); }
+
+    // Called from other threads once a game is handed back, for schedulers sleeping elsewhere than in run().
+    void setWakeup(std::function<void()> newWakeup) { wakeup = std::move(newWakeup); }
+
+    // Count a game sent to the pool, run() waits for it.
+    void sendAway() { ++nbAway; }
+};
+
+/**
+Worker threads taking bot decisions for schedulers.
+Each worker has its own queue, decisions are spread over them in turn. A worker takes the oldest decision of its
+queue, which is also the one due first, and steals the oldest one of another queue once its own is empty.
+Each decision comes with a deadline counted from when it was asked for : a decision that waited is given less
+time, and a late one only searches for a legal answer, so the time of a move stays bounded however many games
+are waiting.
+*/
+class DecisionPool {
+  public:
+    struct Job {
+        const Bot *bot;
+        const Game *game;
+        Deadline deadline;
+        std::optional<Decision> *decision; // Set before the game is handed back
+        std::coroutine_handle<> handle;
+        Scheduler *scheduler;
+    };
+
+  private:
+    // Jobs from head on are waiting. Taken ones stay before it until the back needs room.
+    struct Queue {
+        std::mutex mutex;
+        std::vector<Job> jobs;
+        size_t head = 0;
+    };
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<size_t> nextQueue{0};
+    std::atomic<size_t> nbQueued{0};
+    std::atomic<size_t> nbStolen{0};
+    std::atomic<size_t> nbLate{0}; // Decisions whose deadline passed before they started
+
+    std::mutex idleMutex;
+    std::condition_variable wake;
+    bool bStopping = false;
+
+    bool take(size_t index, Job &job);
+    void work(size_t index);
+
+  public:
+    DecisionPool(size_t nbWorkers, size_t capacity = 0); // Room for capacity decisions at once before queues grow
+    ~DecisionPool();
+    DecisionPool(const DecisionPool &) = delete;
+    DecisionPool& operator=(const DecisionPool &) = delete;
+
+    void submit(const Job &job);
+
+    size_t getNbWorkers() const { return workers.size(); }
+    size_t getNbStolen() const { return nbStolen; }
+    size_t getNbLate() const { return nbLate; }
+};
+
+/**
+Player slot of a game driven by a Scheduler.
+A seat either waits for decisions delivered from outside (a remote or terminal player),
+or answers by itself with a Bot.
+*/
+class Seat {
+  private:
+    Scheduler &scheduler;
+    std::optional<Bot> bot;
+    std::coroutine_handle<> waiting;
+    const Game *waitingGame = nullptr;
+    std::optional<Decision> decision;
+    Deadline::Clock::time_point requested; // When the bot was asked
+    std::vector<double> latencies;         // Of each bot decision in microseconds, until the game resumes
+
+  public:
+    Seat(Scheduler &scheduler) : scheduler(scheduler) {}
+    Seat(Scheduler &scheduler, const Bot &bot);
+
+    bool isBot() const { return bot.has_value(); }
+    bool isWaiting() const { return static_cast<bool>(waiting); }
+
+    // Let a bot play this seat from now on, answering the current decision if one is awaited.
+    void setBot(const Bot &newBot);
+
+    // Hand over a decision to the game waiting for this seat.
+    void deliver(const Decision &newDecision);
+
+    const std::vector<double>& getLatencies() const { return latencies; }
+
+    struct Awaiter {
+        Seat &seat;
+        const Game &game;
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle);
+        Decision await_resume();
+    };
+
+    // Awaitable decision of this seat for the game's pending decision.
+    // Bots answer right away but still yield, so that one game never starves the others.
+    Awaiter decide(const Game &game) { return Awaiter{*this, game}; }
+};
+
+// Called after each submitted decision with the seat index that took it and the result.
+using SubmitCallback = std::function<void(size_t, const SubmitResult &)>;
+
+/**
+Coroutine playing a game to the end, awaiting each decision from the seat it belongs to.
+Seats must outlive the task. A rejected bot decision throws, other rejections are reported to
+the callback and the seat is asked again.
+*/
+GameTask playGame(Game &game, std::vector<Seat *> seats, SubmitCallback onSubmit = nullptr);
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "feed.hpp"
+#include "game.hpp"
+#include "scheduler.hpp"
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+Connection of a client to the server.
+Contains its socket descriptor, its pending input and output lines, and the tables it joined or watches.
+Output lines are shared with the other connections they are sent to.
+*/
+struct Connection {
+    int fd;
+    std::string in;
+    std::deque<SharedLine> out;
+    size_t outOffset = 0; // Bytes of the first output line already written
+    std::vector<uint32_t> tables;
+    bool bWaitingWritable = false;
+    bool bClosing = false;
+};
+
+/**
+Game hosted by the server.
+Contains the game, the seats it awaits decisions from and the coroutine driving it,
+the connection seated at each seat, every connection receiving its updates, and the feed of its spectators.
+*/
+struct Table {
+    std::unique_ptr<Game> game;
+    std::unique_ptr<SpectatorFeed> feed; // Observes game, destroyed first
+    std::vector<std::unique_ptr<Seat>> seats;
+    GameTask task;
+    std::vector<int> seatConnections; // Connection descriptor per seat, -1 if free or played by a bot
+    std::vector<int> members;
+    std::vector<int> spectators;
+};
+
+/**
+Server hosting many independent games in one process.
+A single epoll event loop reads line-framed commands from every connection. Each game runs as a
+coroutine on the server's scheduler, awaiting decisions from remote players or bots, so no
+thread ever blocks on a player.
+
+Commands (client to server) :
+    NEW <players>              -> GAME <table>
+    JOIN <table> [seat]        -> JOINED <table> <seat>, then BOARD and PENDING
+    WATCH <table>              -> WATCHING <table>, then KEY and the DELTA lines after it
+    BOT <table> [seat]         -> OK <table>
+    DECIDE <table> <value>     -> OK <table> | ERR <table> <reason>
+    QUIT
+Updates (server to members of a table) :
+    PENDING <table> <seat> <decision> <min> <max>
+    TILE <table> <rows> <row>...
+    BOARD <table> <size> <cells>
+    CELLS <table> <row>,<column>,<cell>...   (members only)
+    KEY, DELTA                               (spectators only, see SpectatorFeed)
+    NOTICE <table> <message>
+    OVER <table> <seat> <name>
+Every update is encoded once and shared by the connections it is sent to.
+*/
+class Server {
+  private:
+    int listenFd = -1;
+    int epollFd = -1;
+    int wakeFd = -1; // Written by decision threads handing a game back
+    std::string unixPath;
+    std::unordered_map<int, Connection> connections;
+    std::unordered_map<uint32_t, Table> tables;
+    std::vector<uint32_t> finishedTables;
+    uint32_t nextTableId = 1;
+    Scheduler scheduler;
+    RecordWriter *recorder = nullptr;
+    std::string checkpointDirectory;
+
+    void watch(int fd, bool bWritable);
+    void acceptConnections();
+    void receive(Connection &connection);
+    void flush(Connection &connection);
+    void close(int fd);
+
+    void send(int fd, const std::string &line);
+    void share(int fd, const SharedLine &line);
+    void broadcast(const Table &table, const std::string &line); // To members and spectators
+    void publish(uint32_t id, Table &table, const std::string &notices);
+    void onSubmit(uint32_t id, size_t seat, const SubmitResult &result);
+    void dropFinishedTables();
+
+    Table& openTable(uint32_t id, std::unique_ptr<Game> game);
+    std::string checkpointPath(uint32_t id) const;
+    void checkpoint(uint32_t id, const Table &table);
+
+    void handleLine(Connection &connection, const std::string &line);
+    void createTable(Connection &connection, std::istringstream &args);
+    void joinTable(Connection &connection, std::istringstream &args);
+    void watchTable(Connection &connection, std::istringstream &args);
+    void addBot(Connection &connection, std::istringstream &args);
+    void decide(Connection &connection, std::istringstream &args);
+
+  public:
+    static constexpr size_t maxLineLength = 4096; // Longer commands close the connection
+
+    Server() = default;
+    ~Server();
+
+    // Listen on a Unix-domain socket at the given path.
+    void listenUnix(const std::string &path);
+
+    // Listen on the loopback interface at the given TCP port.
+    void listenTcp(uint16_t port);
+
+    // Record every game created from now on.
+    void setRecorder(RecordWriter *newRecorder) { recorder = newRecorder; }
+
+    // Save every game after each accepted decision in the given directory.
+    void setCheckpointDirectory(const std::string &directory) { checkpointDirectory = directory; }
+
+    // Take bot decisions on a pool, each within a budget (none when zero). The pool must be stopped before the server.
+    void setDecisionPool(DecisionPool *pool, Deadline::Clock::duration budget);
+
+    // Reopen the games saved in the checkpoint directory, with every seat free. Returns how many were resumed.
+    size_t resumeTables();
+
+    // Run the event loop until the process is stopped.
+    void run();
+};
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "mapped_file.hpp"
+#include "record.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Owner index of cells and tiles that belong to nobody.
+inline const uint8_t SNAPSHOT_NO_OWNER = 255;
+
+inline const uint16_t SNAPSHOT_VERSION = 3;
+
+/**
+Header of a game snapshot.
+It is followed by nbSeated SnapshotPlayer, boardSize * boardSize SnapshotCell in row order,
+nbPlacedTiles and nbQueueTiles SnapshotTile, and nbEntries RecordEntry of the game being recorded.
+Each section starts on a multiple of 8 bytes.
+*/
+struct SnapshotHeader {
+    char magic[4]; // "LGS1"
+    uint16_t version;
+    uint16_t boardSize;
+    uint64_t seed;
+
+    // Turn state
+    uint8_t currentRound;
+    uint8_t currentPlayer;
+    uint8_t pendingType; // DecisionType
+    uint8_t pendingPlayer;
+    int16_t pendingMin;
+    int16_t pendingMax;
+    uint8_t tileId;      // Tile in hand, RECORD_NO_TILE if none
+    uint8_t tileOrientation;
+    uint8_t flags;       // SNAPSHOT_STEALABLE, SNAPSHOT_DISPLAY_QUEUE
+    uint8_t nbPlayers;
+    uint16_t availableColors; // One bit per PlayerColor
+    uint16_t nbPlacedTiles;
+
+    uint16_t nbQueueTiles;
+    uint8_t nbSeated;     // Players created so far, fewer than nbPlayers during setup
+    uint8_t reserved;
+    uint32_t nbEntries;
+    char pendingName[32]; // Name of the player being created during setup
+    uint64_t size;        // Size of the whole snapshot in bytes, past 4 GiB on the largest boards
+    uint32_t checksum;    // Sum of every byte after the header
+    uint32_t padding;
+};
+
+inline const uint8_t SNAPSHOT_STEALABLE = 1;
+inline const uint8_t SNAPSHOT_DISPLAY_QUEUE = 2;
+
+/**
+Player of a snapshot, in seat order.
+*/
+struct SnapshotPlayer {
+    char name[32]; // Null-terminated if shorter
+    uint8_t color;
+    uint8_t padding;
+    uint16_t coupons;
+    uint16_t stoneBonus;
+    uint16_t robberyBonus;
+};
+
+/**
+Cell of a snapshot, with its printing symbol so that the board displays the same.
+*/
+struct SnapshotCell {
+    uint8_t type;     // CellType
+    uint8_t owner;    // Seat, or SNAPSHOT_NO_OWNER
+    char symbol[6];   // UTF-8, null-terminated if shorter
+};
+
+/**
+Tile of a snapshot, either placed on the board or waiting in the queue.
+Coordinates, owner and stealability only matter for placed tiles.
+*/
+struct SnapshotTile {
+    uint8_t id;
+    uint8_t orientation;
+    uint16_t x;
+    uint16_t y;
+    uint8_t owner;
+    uint8_t bStealable;
+};
+
+static_assert(sizeof(SnapshotHeader) == 88, "SnapshotHeader layout changed");
+static_assert(sizeof(SnapshotPlayer) == 40, "SnapshotPlayer layout changed");
+static_assert(sizeof(SnapshotCell) == 8, "SnapshotCell layout changed");
+static_assert(sizeof(SnapshotTile) == 8, "SnapshotTile layout changed");
+
+/**
+Offsets of the sections of a snapshot, computed from its header.
+*/
+struct SnapshotLayout {
+    size_t players;
+    size_t cells;
+    size_t placedTiles;
+    size_t queueTiles;
+    size_t entries;
+    size_t size;
+
+    SnapshotLayout(const SnapshotHeader &header);
+};
+
+// Sum of the bytes of a snapshot after its header.
+uint32_t snapshotChecksum(const char *data, size_t size);
+
+// Replace a snapshot file at once, so that a crash while saving keeps the previous one.
+void writeSnapshotFile(const std::string &path, const std::vector<char> &data);
+
+/**
+Snapshot file mapped in memory.
+Sections are read in place, a Game is restored from it with Game(const Snapshot &).
+*/
+class Snapshot {
+  private:
+    MappedFile file;
+    const SnapshotHeader *header;
+
+    template <typename T>
+    const T* section(size_t offset) const { return reinterpret_cast<const T *>(file.getData() + offset); }
+
+  public:
+    Snapshot(const std::string &path); // Throws if the file is not a valid snapshot
+
+    const SnapshotHeader& getHeader() const { return *header; }
+    const SnapshotPlayer* getPlayers() const { return section<SnapshotPlayer>(SnapshotLayout(*header).players); }
+    const SnapshotCell* getCells() const { return section<SnapshotCell>(SnapshotLayout(*header).cells); }
+    const SnapshotTile* getPlacedTiles() const { return section<SnapshotTile>(SnapshotLayout(*header).placedTiles); }
+    const SnapshotTile* getQueueTiles() const { return section<SnapshotTile>(SnapshotLayout(*header).queueTiles); }
+    const RecordEntry* getEntries() const { return section<RecordEntry>(SnapshotLayout(*header).entries); }
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+/**
+Lock-free queue between exactly one producer thread and one consumer thread.
+Its capacity is fixed, a push on a full ring fails instead of waiting. Each side keeps a copy of the
+other side's index and only reads the shared one when that copy says the ring is full or empty.
+*/
+template <typename T>
+class SpscRing {
+  private:
+    std::vector<T> slots;
+    size_t mask;
+
+    alignas(64) std::atomic<size_t> head{0}; // Next slot to pop, written by the consumer
+    size_t cachedTail = 0;                    // Consumer's copy of tail
+    alignas(64) std::atomic<size_t> tail{0}; // Next slot to push, written by the producer
+    size_t cachedHead = 0;                    // Producer's copy of head
+
+  public:
+    // Capacity must be a power of two.
+    SpscRing(size_t capacity) : slots(capacity), mask(capacity - 1) {
+        if (capacity == 0 || (capacity & mask) != 0)
+            throw std::invalid_argument("SpscRing: capacity must be a power of two");
+    }
+    SpscRing(const SpscRing &) = delete;
+    SpscRing& operator=(const SpscRing &) = delete;
+
+    size_t capacity() const { return slots.size(); }
+
+    // Producer side.
+    bool tryPush(const T &value) {
+        size_t position = tail.load(std::memory_order_relaxed);
+        if (position - cachedHead == slots.size()) {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (position - cachedHead == slots.size())
+                return false;
+        }
+        slots[position & mask] = value;
+        tail.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side.
+    bool tryPop(T &value) {
+        size_t position = head.load(std::memory_order_relaxed);
+        if (position == cachedTail) {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (position == cachedTail)
+                return false;
+        }
+        value = slots[position & mask];
+        head.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Either side, exact only when the other side is idle.
+    bool empty() const { return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire); }
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+Fixed set of worker threads running loops split into tasks.
+The calling thread works too, and parallelFor() only returns once every task is done.
+Loops run one at a time, and a loop started from inside a task runs on the calling thread.
+*/
+class ThreadPool {
+  private:
+    std::vector<std::thread> workers;
+    std::mutex loopMutex; // Held for the whole of a loop
+
+    // Loop in progress, guarded by mutex
+    std::mutex mutex;
+    std::condition_variable wake; // Workers wait for a loop
+    std::condition_variable done; // parallelFor waits for the workers
+    using Invoker = void (*)(const void *task, size_t i); // Calls the task of a loop, whatever its type
+    const void *task = nullptr;
+    Invoker invoke = nullptr;
+    size_t nbTasks = 0;
+    std::atomic<size_t> nextTask{0};
+    size_t nbBusy = 0;       // Workers inside the loop
+    uint64_t generation = 0; // Incremented for each loop
+    std::exception_ptr error;
+    bool bStopping = false;
+
+    void work();
+    void runTasks(const void *loopTask, Invoker loopInvoke, size_t loopSize);
+    void run(size_t count, const void *loopTask, Invoker loopInvoke);
+
+  public:
+    ThreadPool(size_t nbWorkers); // Threads besides the calling one
+    ~ThreadPool();
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool& operator=(const ThreadPool &) = delete;
+
+    size_t getNbThreads() const { return workers.size() + 1; }
+
+    // Call task(i) for i in [0, nbTasks), spread over the threads. Rethrows the first exception of a task.
+    // The task is called through a pointer, so that starting a loop does not allocate.
+    template <typename Task>
+    void parallelFor(size_t nbTasks, const Task &task) {
+        run(nbTasks, &task, [](const void *loopTask, size_t i) { (*static_cast<const Task *>(loopTask))(i); });
+    }
+
+    // Pool with one thread per core, or LAYINGRASS_THREADS threads, started on first use.
+    static ThreadPool& shared();
+};
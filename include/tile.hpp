@@ -3,18 +3,33 @@
 #include "tile_shapes.hpp"
 #include <vector>
 
+/**
+Tile of one of the predefined shapes, in one of its 8 orientations.
+Shapes are not stored in tiles : every orientation of every shape is computed once and shared,
+so tiles are small values that copy without allocating.
+*/
 class Tile {
   private:
-    Shape baseShape;
+    uint8_t id; // Index in TILE_SHAPES, or STARTING_TILE_ID
     int rotation = 0;
     bool flipped = false;
 
     static Shape rotateShape(const Shape &shape);
+    static const std::vector<Shape>& orientedShapes(); // Every orientation of every shape, at 8 * index + orientation
+
+    explicit Tile(uint8_t id) : id(id) {}
 
   public:
-    Tile(const Shape &shape) : baseShape(shape), rotation(0), flipped(false) {}
+    // Tile of a shape identifier, in an orientation given by getOrientation().
+    static Tile fromId(uint8_t id, uint8_t orientation = 0);
+
+    // Shape in the current orientation, shared by every tile with the same shape and orientation.
+    const Shape& getShape() const;
 
-    Shape getShape() const;
+    uint8_t getId() const { return id; }
+    int getRotation() const { return rotation; }
+    bool isFlipped() const { return flipped; }
+    uint8_t getOrientation() const { return static_cast<uint8_t>(rotation / 90 | flipped << 2); } // Quarter turns in the low 2 bits, flip in bit 2
 
     // Rotate the tile 90 degrees clockwise.
     void rotateClockwise() { rotation = (rotation + 90) % 360; }
@@ -2,29 +2,42 @@
 
 #include "tile.hpp"
 #include "tile_shapes.hpp"
-#include <deque>
+#include <algorithm>
+#include <cstdint>
+#include <span>
 #include <vector>
-#include <functional>
+#include <utility>
 
 class TileQueue {
   private:
-    std::deque<Tile> tiles; // Using a deque to access tiles by index
+    // Tiles from head on are in the queue. Drawn tiles stay before it until the back needs room,
+    // the storage has room for twice the tiles so that moving them to the back does not allocate.
+    std::vector<Tile> tiles;
+    size_t head = 0;
+
+    void reserveRoom();
+    void compact(); // Drops the drawn tiles once the storage is full
 
   public:
-    TileQueue(size_t nbPlayers);
+    TileQueue(size_t nbPlayers, uint64_t seed); // The same seed always gives the same order
+    TileQueue(std::vector<Tile> tiles);
+    TileQueue(const TileQueue &other); // With the same room as the original
+    TileQueue& operator=(const TileQueue &other) = default;
+
+    std::span<const Tile> getTiles() const { return std::span<const Tile>(tiles).subspan(head); }
 
     // Draw the next tile from the queue.
     Tile drawTile();
 
     // Put a Tile at the back of the TileQueue
-    void pushBack(const Tile &tile) { tiles.push_back(tile); }
+    void pushBack(const Tile &tile);
 
     // Draw a tile at a specific index and place every tile before that at the back of the queue.
     Tile exchangeTile(int index); // Using int for user interface
 
-    // Get constant references to the next n tiles without removing them from the queue.
-    std::vector<std::reference_wrapper<const Tile>> nextTiles(size_t n = 5) const; // Returns constant references without // exposing internal structure
+    // Get the next n tiles without removing them from the queue, valid until it changes.
+    std::span<const Tile> nextTiles(size_t n = 5) const { return getTiles().first(std::min(n, tiles.size() - head)); }
 
     // Print the next n tiles in the exchange queue.
-    void printExchangeQueue(const std::vector<std::reference_wrapper<const Tile>> &tiles) const;
+    void printExchangeQueue(std::span<const Tile> tiles) const;
 };
\ No newline at end of file
@@ -13,6 +13,9 @@ inline const Shape STARTING_TILE = {
     {1}
 };
 
+// Identifier of the starting tile, other tiles use their index in TILE_SHAPES.
+inline const uint8_t STARTING_TILE_ID = 255;
+
 /**
 96 predefined shapes for tiles, ordered by size (from 2x1 to 7x2).
 Each shape is represented as a 2D vector of unsigned 8-bit integers,
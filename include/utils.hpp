@@ -1,5 +1,6 @@
 #pragma once
 
+#include "decision.hpp"
 #include "player.hpp"
 #include <iostream>
 #include <utility>
@@ -17,6 +18,9 @@ struct Colorize {
 // Convert a PlayerColor to string
 std::string playerColorToString(PlayerColor color);
 
+// Convert a DecisionType to string
+std::string decisionTypeToString(DecisionType type);
+
 // Create a Colorize object for the given PlayerColor.
 Colorize colorize(PlayerColor color);
 
@@ -32,6 +36,16 @@ std::ostream &operator<<(std::ostream &os, const Colorize &c);
 // Convert A-z to 0-51
 int letterToIndex(char c);
 
+// Convert a letter or a 0-based number to an index, -1 if invalid
+int coordinateToIndex(const std::string &input);
+
+// Inputs refused by the terminal front-end so far, malformed or rejected by the game.
+size_t getNbInvalidInputs();
+void countInvalidInput();
+
+// Throws once standard input is exhausted, instead of asking again forever.
+void checkEndOfInput();
+
 // Get coordinate input from the user within specified bounds.
 std::pair<size_t, size_t> getCoordinatesInput(size_t max);
 
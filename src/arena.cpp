@@ -0,0 +1,31 @@
+#include "arena.hpp"
+#include <algorithm>
+
+static const size_t MIN_BLOCK_SIZE = 4096;
+
+void Arena::reserve(size_t bytes) {
+    if (!blocks.empty() && blocks.front().size >= bytes)
+        return;
+
+    blocks.clear();
+    blocks.push_back({std::unique_ptr<std::byte[]>(new std::byte[bytes]), bytes});
+    block = 0;
+    offset = 0;
+}
+
+void* Arena::takeBytes(size_t bytes, size_t alignment) {
+    // The rest of the current block, then the next ones. Blocks are aligned for any type.
+    for (; block < blocks.size(); ++block, offset = 0) {
+        size_t start = (offset + alignment - 1) / alignment * alignment;
+        if (start + bytes <= blocks[block].size) {
+            offset = start + bytes;
+            return blocks[block].memory.get() + start;
+        }
+    }
+
+    size_t size = std::max({bytes, MIN_BLOCK_SIZE, blocks.empty() ? 0 : 2 * blocks.back().size});
+    blocks.push_back({std::unique_ptr<std::byte[]>(new std::byte[size]), size});
+    block = blocks.size() - 1;
+    offset = bytes;
+    return blocks[block].memory.get();
+}
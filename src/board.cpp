@@ -1,74 +1,49 @@
 #include "board.hpp"
+#include "endgame.hpp"
+#include "thread_pool.hpp"
 #include "utils.hpp"
+#include <algorithm>
+#include <cmath>
+#include <queue>
 #include <random>
 #include <stdexcept>
 #include <iostream>
+#include <functional>
+#include <numeric>
 #include <array>
-#include <set>
-
-Board::~Board() {
-    for (size_t i = 0; i < size; ++i) {
-        delete[] grid[i];
-    }
-    delete[] grid;
+#include <atomic>
+#include <string>
+
+// Below these sizes, work stays on the calling thread where starting a parallel loop costs more than it saves
+static const size_t PARALLEL_MIN_CANDIDATES = 4096;
+static const size_t PARALLEL_MIN_CELLS = 256 * 256;
+static const size_t SQUARE_BLOCK = 64; // Side of the tiles of the parallel largest square
+
+static const uint32_t NOT_STEALABLE = UINT32_MAX;
+static const uint32_t NOT_ROOT = UINT32_MAX; // In nextRoot and previousRoot, for cells that are not roots
+static const uint32_t NO_ROOT = UINT32_MAX - 1; // Before the first root of a territory and after its last one
+
+// Tiles a game can place : a starting tile and 9 rounds per player, and a 1x1 tile for each coupon,
+// one per player and one per exchange bonus. Robberies place again the tiles they remove.
+static size_t maxPlacedTiles(size_t nbPlayers) {
+    return nbPlayers * 16;
 }
 
-void Board::setCell(std::pair<size_t, size_t> coords, CellType type, Player *owner) {
-    grid[coords.first][coords.second].type = type;
-    grid[coords.first][coords.second].owner = owner;
+// Scratch taken by the largest searches of a game. Stone impacts take six tables over the board, seven over the
+// window of an opponent and the cells of the coming tiles, robberies a profile of each victim, and the coupon search
+// a hash table of the positions it saw.
+static size_t scratchBytes(size_t size, size_t nbPlayers) {
+    size_t side = size + 1;
+    size_t stones = 48 * side * side + 32768;
+    size_t robberies = nbPlayers * (48 * side + 128) + 32 * side;
+    return std::max({stones, robberies, couponSearchBytes(size)}) + 4096; // And padding for alignment
 }
 
-void Board::setup(size_t nbPlayers) {
-    // Allocate grid
-    grid = new Cell *[size];
-    for (size_t i = 0; i < size; ++i) {
-        grid[i] = new Cell[size];
-        for (size_t j = 0; j < size; ++j) {
-            grid[i][j].type = EMPTY;
-            grid[i][j].owner = nullptr;
-        }
-    }
-
-    // Place bonuses on the board
-    size_t nbExchange = (nbPlayers * 3 + 1) / 2; // 1.5x per player (rounded up)
-    size_t nbStone = (nbPlayers + 1) / 2;        // 0.5x per player (rounded up)
-    size_t nbRobbery = nbPlayers;                // 1x per player
-
-    for (size_t i = 0; i < nbExchange; ++i)
-        placeBonus(BONUS_EXCHANGE);
-    for (size_t i = 0; i < nbStone; ++i)
-        placeBonus(BONUS_STONE);
-    for (size_t i = 0; i < nbRobbery; ++i)
-        placeBonus(BONUS_ROBBERY);
-}
-
-void Board::placeBonus(CellType bonusType) {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<size_t> dist( 1, size - 2); // Exclude edges from placement
-
-    const size_t MAX_ATTEMPTS = 100; // Prevent infinite loops
-    size_t attempts = 0;
-    size_t x, y;
-
-    do {
-        x = dist(gen);
-        y = dist(gen);
-
-        if (++attempts > MAX_ATTEMPTS)
-            throw std::runtime_error("Board::placeBonus failed: no valid empty cell found");
-    } while (grid[x][y].type != EMPTY ||
-             grid[x + 1][y].type != EMPTY ||
-             grid[x][y + 1].type != EMPTY ||
-             grid[x - 1][y].type != EMPTY ||
-             grid[x][y - 1].type != EMPTY);
-
-    grid[x][y].type = bonusType;
-}
-
-bool Board::canPlaceTile(std::pair<size_t, size_t> coords, const Tile &tile, const Player &player, bool bIsStartingTile) const {
-    Shape shape = tile.getShape();
+// --- Kernels, instantiated for each grid type so that the board size is a constant on FixedGrid ---
 
+template <typename Grid>
+static bool canPlaceShapeOn(const Grid &grid, std::pair<size_t, size_t> coords, const Shape &shape, const Player &player, bool bIsStartingTile) {
+    const size_t N = grid.size;
     const std::array<std::pair<int,int>,4> directions = {{{-1,0}, {1,0}, {0,-1}, {0,1}}};
     bool bTouchesOwnCell = false;
 
@@ -81,22 +56,24 @@ bool Board::canPlaceTile(std::pair<size_t, size_t> coords, const Tile &tile, con
             size_t y = coords.second + j;
 
             // Make sure tile is within board bounds
-            if (x >= size || y >= size)
+            if (x >= N || y >= N)
                 return false;
 
             // Make sure overlaping cell is not grass or stone
-            if (grid[x][y].type == GRASS || grid[x][y].type == STONE)
+            const Cell &cell = grid.at(x, y);
+            if (cell.type == GRASS || cell.type == STONE)
                 return false;
 
             // Checking orthogonal neighbours
             for (const auto &dir : directions) {
-                int newX = static_cast<int>(x) + dir.first;
-                int newY = static_cast<int>(y) + dir.second;
+                size_t newX = x + dir.first;
+                size_t newY = y + dir.second;
 
-                if (newX < 0 || newY < 0 || newX >= static_cast<int>(size) || newY >= static_cast<int>(size))
+                // Unsigned wrap-around makes negative coordinates out of bounds too
+                if (newX >= N || newY >= N)
                     continue;
 
-                const Player *owner = grid[newX][newY].owner;
+                const Player *owner = grid.at(newX, newY).owner;
 
                 if (owner) {
                     // Return false if touching another player's cell
@@ -115,21 +92,508 @@ bool Board::canPlaceTile(std::pair<size_t, size_t> coords, const Tile &tile, con
     return bIsStartingTile || bTouchesOwnCell;
 }
 
-bool Board::canPlaceTileAnywhere(const Tile &tile, const Player &player) const {
-    for (size_t x = 0; x < size; ++x) {
-        for (size_t y = 0; y < size; ++y) {
-            if (canPlaceTile({x, y}, tile, player, false))
-                return true;
+// Legal anchors among sorted candidates, stopping at the first one unless all are wanted.
+template <typename Grid>
+static void filterAnchorsOn(const Grid &grid, const std::vector<std::pair<size_t, size_t>> &candidates, const Shape &shape,
+                            const Player &player, std::vector<std::pair<size_t, size_t>> &anchors, bool bFirstOnly) {
+    for (std::pair<size_t, size_t> anchor : candidates) {
+        if (!canPlaceShapeOn(grid, anchor, shape, player, false))
+            continue;
+        anchors.push_back(anchor);
+        if (bFirstOnly)
+            return;
+    }
+}
+
+// Same as filterAnchorsOn, with the candidates split into row bands checked in parallel.
+// Every anchor is kept in order, only the first one found is kept otherwise.
+template <typename Grid>
+static void filterAnchorsInBands(const Grid &grid, const std::vector<std::pair<size_t, size_t>> &candidates, const Shape &shape,
+                                 const Player &player, std::vector<std::pair<size_t, size_t>> &anchors, bool bFirstOnly, Arena &arena) {
+    ThreadPool &pool = ThreadPool::shared();
+    size_t nbBands = pool.getNbThreads() * 4; // A few bands per thread to even out their costs
+    std::atomic<bool> bFound{false};
+
+    // Each band writes the anchors it finds over its own slice, tasks do not take from the arena
+    Arena::Scope scope(arena);
+    std::span<std::pair<size_t, size_t>> found = arena.take<std::pair<size_t, size_t>>(candidates.size());
+    std::span<size_t> nbFound = arena.take<size_t>(nbBands, 0);
+
+    // Candidates are sorted, so consecutive slices are bands of rows
+    pool.parallelFor(nbBands, [&](size_t band) {
+        size_t begin = candidates.size() * band / nbBands;
+        size_t end = candidates.size() * (band + 1) / nbBands;
+        for (size_t i = begin; i < end; ++i) {
+            if (bFirstOnly && bFound.load(std::memory_order_relaxed))
+                return;
+            if (!canPlaceShapeOn(grid, candidates[i], shape, player, false))
+                continue;
+            found[begin + nbFound[band]++] = candidates[i];
+            if (bFirstOnly) {
+                bFound = true;
+                return;
+            }
+        }
+    });
+
+    for (size_t band = 0; band < nbBands; ++band) {
+        size_t begin = candidates.size() * band / nbBands;
+        anchors.insert(anchors.end(), found.begin() + begin, found.begin() + begin + nbFound[band]);
+        if (bFirstOnly && !anchors.empty()) {
+            anchors.resize(1);
+            return;
         }
     }
-    return false;
+}
+
+// Buffer holding one row of the largest square table, fixed on FixedGrid and taken from the arena otherwise.
+template <typename Grid>
+struct SquareRow {
+    using Type = std::span<uint32_t>;
+    static Type make(Arena &arena, size_t width) { return arena.take<uint32_t>(width, 0); }
+};
+
+template <size_t N>
+struct SquareRow<FixedGrid<N>> {
+    using Type = std::array<uint16_t, N>;
+    static Type make(Arena &, size_t) { return Type{}; }
+};
+
+// Largest square of a player inside the window [x0, x1) x [y0, y1), the first one in row order on ties.
+template <typename Grid>
+static Square largestSquareOn(const Grid &grid, const Player &player, size_t x0, size_t x1, size_t y0, size_t y1, Arena &arena) {
+    // Two rows of the table : side of the largest square whose bottom right corner is (x, y)
+    Arena::Scope scope(arena);
+    auto previous = SquareRow<Grid>::make(arena, y1 - y0);
+    auto current = SquareRow<Grid>::make(arena, y1 - y0);
+    Square best = {0, {0, 0}};
+
+    for (size_t x = x0; x < x1; ++x) {
+        for (size_t y = y0; y < y1; ++y) {
+            size_t j = y - y0;
+            if (grid.at(x, y).owner != &player) {
+                current[j] = 0;
+                continue;
+            }
+
+            if (x == x0 || y == y0)
+                current[j] = 1;
+            else
+                current[j] = 1 + std::min({previous[j], current[j - 1], previous[j - 1]});
+
+            if (current[j] > best.side)
+                best = {current[j], {x, y}};
+        }
+        std::swap(previous, current);
+    }
+
+    return best;
+}
+
+// Same as largestSquareOn, computed in parallel on square tiles of the window.
+// Tiles on one anti-diagonal only depend on tiles of the previous ones, so diagonals run one after the other
+// with their tiles in parallel. Every cell gets the same value as the serial table, ties are broken the same way.
+template <typename Grid>
+static Square largestSquareWavefront(const Grid &grid, const Player &player, size_t x0, size_t x1, size_t y0, size_t y1, Arena &arena) {
+    const size_t height = x1 - x0;
+    const size_t width = y1 - y0;
+    const size_t nbBlockRows = (height + SQUARE_BLOCK - 1) / SQUARE_BLOCK;
+    const size_t nbBlockCols = (width + SQUARE_BLOCK - 1) / SQUARE_BLOCK;
+
+    Arena::Scope scope(arena);
+    std::span<uint32_t> table = arena.take<uint32_t>(height * width);
+    std::span<Square> blockBests = arena.take<Square>(nbBlockRows * nbBlockCols, Square{0, {0, 0}});
+
+    for (size_t diagonal = 0; diagonal < nbBlockRows + nbBlockCols - 1; ++diagonal) {
+        size_t firstRow = diagonal < nbBlockCols ? 0 : diagonal - nbBlockCols + 1;
+        size_t lastRow = std::min(diagonal, nbBlockRows - 1);
+
+        ThreadPool::shared().parallelFor(lastRow - firstRow + 1, [&](size_t k) {
+            size_t blockRow = firstRow + k;
+            size_t blockCol = diagonal - blockRow;
+            Square &best = blockBests[blockRow * nbBlockCols + blockCol];
+
+            size_t iEnd = std::min(height, (blockRow + 1) * SQUARE_BLOCK);
+            size_t jEnd = std::min(width, (blockCol + 1) * SQUARE_BLOCK);
+            for (size_t i = blockRow * SQUARE_BLOCK; i < iEnd; ++i) {
+                for (size_t j = blockCol * SQUARE_BLOCK; j < jEnd; ++j) {
+                    uint32_t &side = table[i * width + j];
+                    if (grid.at(x0 + i, y0 + j).owner != &player)
+                        side = 0;
+                    else if (i == 0 || j == 0)
+                        side = 1;
+                    else
+                        side = 1 + std::min({table[(i - 1) * width + j], table[i * width + j - 1], table[(i - 1) * width + j - 1]});
+
+                    if (side > best.side)
+                        best = {side, {x0 + i, y0 + j}};
+                }
+            }
+        });
+    }
+
+    // First in row order among the tiles' bests, as the serial scan would find it
+    Square best = {0, {0, 0}};
+    for (const Square &blockBest : blockBests)
+        if (blockBest.side > best.side || (blockBest.side == best.side && blockBest.side > 0 && blockBest.corner < best.corner))
+            best = blockBest;
+    return best;
+}
+
+// Construct the grid alternative of the requested size, the DynamicGrid if none is built in.
+template <size_t I = 0>
+static void emplaceGrid(BoardGrid &grid, size_t size) {
+    if constexpr (I + 1 < std::variant_size_v<BoardGrid>) {
+        if (std::variant_alternative_t<I, BoardGrid>::size == size) {
+            grid.emplace<I>();
+            return;
+        }
+        emplaceGrid<I + 1>(grid, size);
+    } else {
+        grid.emplace<DynamicGrid>(size);
+    }
+}
+
+// --- CellCensus ---
+
+void CellCensus::reset(size_t nbCells) {
+    for (auto &cells : cellsOfType)
+        cells.clear();
+    reserve(nbCells);
+
+    cellsOfType[EMPTY].resize(nbCells);
+    position.resize(nbCells);
+    for (size_t i = 0; i < nbCells; ++i) {
+        cellsOfType[EMPTY][i] = static_cast<uint32_t>(i);
+        position[i] = static_cast<uint32_t>(i);
+    }
+}
+
+void CellCensus::reserve(size_t nbCells) {
+    for (auto &cells : cellsOfType)
+        cells.reserve(nbCells);
+}
+
+void CellCensus::move(uint32_t cell, CellType from, CellType to) {
+    if (from == to)
+        return;
+
+    // The last cell of the old list takes the place of the moved one
+    std::vector<uint32_t> &oldCells = cellsOfType[from];
+    uint32_t last = oldCells.back();
+    oldCells[position[cell]] = last;
+    position[last] = position[cell];
+    oldCells.pop_back();
+
+    position[cell] = static_cast<uint32_t>(cellsOfType[to].size());
+    cellsOfType[to].push_back(cell);
+}
+
+// --- Board ---
+
+Board::Board(size_t nbPlayers, uint64_t seed) : Board(defaultSize(nbPlayers), nbPlayers, seed) {}
+
+Board::Board(size_t size, size_t nbPlayers, uint64_t seed) : size(size) {
+    if (size < minSize || size > maxSize)
+        throw std::out_of_range("Board: size must be between " + std::to_string(minSize) + " and " + std::to_string(maxSize));
+
+    emplaceGrid(grid, size);
+    cells = firstCell();
+    setup(nbPlayers, seed);
+}
+
+Board::Board(const Board &other)
+    : size(other.size), nbPlayers(other.nbPlayers), grid(other.grid), cells(nullptr), placedTiles(other.placedTiles), bonusLayout(other.bonusLayout),
+      tileAt(other.tileAt), census(other.census), stealable(other.stealable), stealablePosition(other.stealablePosition),
+      stealableCounts(other.stealableCounts), componentParent(other.componentParent), components(other.components),
+      nextRoot(other.nextRoot), previousRoot(other.previousRoot), firstRoot(other.firstRoot), bonusReach(other.bonusReach), bReachStale(other.bReachStale), bonusBuckets(other.bonusBuckets) {
+    // Squares are keyed by player, they are computed again for the copy's players
+    cells = firstCell();
+    // Copied vectors only have room for what they hold
+    reserveRoom();
+}
+
+size_t Board::defaultSize(size_t nbPlayers) {
+    if (nbPlayers < 5)
+        return 20;
+    if (nbPlayers < 10)
+        return 30;
+    return static_cast<size_t>(std::ceil(std::sqrt(100.0 * nbPlayers)));
+}
+
+Cell* Board::firstCell() {
+    return std::visit([](auto &fixedGrid) { return fixedGrid.cells.data(); }, grid);
+}
+
+void Board::setCell(std::pair<size_t, size_t> coords, CellType type, Player *owner) {
+    Cell &cell = getCell(coords);
+
+    // Territories changed outside of placeTile() get their square computed again
+    if (cell.owner)
+        squares.erase(cell.owner);
+    if (owner)
+        squares.erase(owner);
+
+    Player *previous = cell.owner;
+    CellType previousType = cell.type;
+    bool bChanged = cell.type != type || previous != owner;
+    setType(coords, type);
+    cell.owner = owner;
+
+    if (previous != owner) {
+        if (previous)
+            splitTerritory(std::span(&coords, 1), previous);
+        if (owner)
+            addTerritoryCell(coords, owner);
+    }
+    if (bChanged)
+        markBonusesAround(coords, coords);
+
+    if (!bChanged || listeners.empty())
+        return;
+    if (type == STONE && previousType != STONE)
+        emit(StonePlaced{coords});
+    else if (previousType == STONE && type == EMPTY && !owner)
+        emit(StoneRemoved{coords});
+    else
+        emit(CellChanged{coords, previousType, previous, type, owner});
+}
+
+void Board::setType(std::pair<size_t, size_t> coords, CellType type) {
+    Cell &cell = getCell(coords);
+    census.move(static_cast<uint32_t>(coords.first * size + coords.second), cell.type, type);
+    cell.type = type;
+
+    // Owners only change along with types, the cell and its neighbours are counted again
+    areaStaleFrom = std::min(areaStaleFrom, coords.first > 0 ? coords.first - 1 : 0);
+}
+
+void Board::setup(size_t nbPlayers, uint64_t seed) {
+    this->nbPlayers = nbPlayers;
+
+    // Clear grid
+    for (size_t i = 0; i < size * size; ++i)
+        cells[i] = Cell{EMPTY, nullptr};
+    placedTiles.clear();
+    bonusLayout.clear();
+    tileAt.assign(size * size, 0);
+    squares.reset(nbPlayers);
+    census.reset(size * size);
+    stealable.clear();
+    stealablePosition.clear();
+    stealableCounts.reset(nbPlayers);
+    componentParent.resize(size * size);
+    std::iota(componentParent.begin(), componentParent.end(), 0);
+    components.assign(size * size, Component{});
+    nextRoot.assign(size * size, NOT_ROOT);
+    previousRoot.assign(size * size, NOT_ROOT);
+    firstRoot.reset(nbPlayers);
+    areaPlayer = nullptr;
+    size_t nbBuckets = (size + bonusHorizon - 1) / bonusHorizon;
+    bonusBuckets.assign(nbBuckets * nbBuckets, {});
+    bonusReach.clear();
+    bReachStale.clear();
+
+    // Place bonuses on the board
+    std::seed_seq seq{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32), 0u};
+    std::mt19937 gen(seq);
+
+    size_t nbExchange = (nbPlayers * 3 + 1) / 2; // 1.5x per player (rounded up)
+    size_t nbStone = (nbPlayers + 1) / 2;        // 0.5x per player (rounded up)
+    size_t nbRobbery = nbPlayers;                // 1x per player
+
+    for (size_t i = 0; i < nbExchange; ++i)
+        placeBonus(BONUS_EXCHANGE, gen);
+    for (size_t i = 0; i < nbStone; ++i)
+        placeBonus(BONUS_STONE, gen);
+    for (size_t i = 0; i < nbRobbery; ++i)
+        placeBonus(BONUS_ROBBERY, gen);
+    reserveRoom();
+
+    if (!listeners.empty())
+        emit(BoardReset{});
+}
+
+void Board::reserveRoom() {
+    size_t nbPlaced = std::min(size * size, maxPlacedTiles(nbPlayers));
+    placedTiles.reserve(nbPlaced);
+    squares.reserve(nbPlayers);
+    census.reserve(size * size);
+    stealable.reserve(nbPlaced);
+    stealablePosition.reserve(nbPlaced);
+    stealableCounts.reserve(nbPlayers);
+    firstRoot.reserve(nbPlayers);
+    for (auto &reach : bonusReach)
+        reach.reserve(nbPlayers);
+    allowedArea.reserve((size + 1) * (size + 1));
+    frontierArea.reserve((size + 1) * (size + 1));
+    candidatesBuffer.reserve(size * size);
+    anchorsBuffer.reserve(size * size);
+    impactsBuffer.reserve(size * size);
+    deltasBuffer.reserve(nbPlaced);
+    scratch.reserve(scratchBytes(size, nbPlayers));
+}
+
+void Board::detach(const void *observer) {
+    std::erase_if(listeners, [observer](const Listener &listener) { return listener.observer == observer; });
+}
+
+void Board::placeBonus(CellType bonusType, std::mt19937 &gen) {
+    std::uniform_int_distribution<size_t> dist( 1, size - 2); // Exclude edges from placement
+
+    const size_t MAX_ATTEMPTS = 100; // Prevent infinite loops
+    size_t attempts = 0;
+    size_t x, y;
+
+    do {
+        x = dist(gen);
+        y = dist(gen);
+
+        if (++attempts > MAX_ATTEMPTS)
+            throw std::runtime_error("Board::placeBonus failed: no valid empty cell found");
+    } while (getCell({x, y}).type != EMPTY ||
+             getCell({x + 1, y}).type != EMPTY ||
+             getCell({x, y + 1}).type != EMPTY ||
+             getCell({x - 1, y}).type != EMPTY ||
+             getCell({x, y - 1}).type != EMPTY);
+
+    setType({x, y}, bonusType);
+    bonusLayout.push_back({{x, y}, bonusType});
+
+    size_t nbBuckets = (size + bonusHorizon - 1) / bonusHorizon;
+    bonusBuckets[(x / bonusHorizon) * nbBuckets + y / bonusHorizon].push_back(static_cast<uint32_t>(bonusLayout.size() - 1));
+    bonusReach.emplace_back();
+    bReachStale.push_back(true);
+}
+
+bool Board::canPlaceTile(std::pair<size_t, size_t> coords, const Tile &tile, const Player &player, bool bIsStartingTile) const {
+    return canPlaceShape(coords, tile.getShape(), player, bIsStartingTile);
+}
+
+bool Board::canPlaceShape(std::pair<size_t, size_t> coords, const Shape &shape, const Player &player, bool bIsStartingTile) const {
+    return std::visit([&](const auto &fixedGrid) { return canPlaceShapeOn(fixedGrid, coords, shape, player, bIsStartingTile); }, grid);
+}
+
+void Board::candidateAnchors(const Shape &shape, const Player &player, std::vector<std::pair<size_t, size_t>> &candidates) const {
+    candidates.clear();
+    if (!firstRoot.find(&player))
+        return;
+    updateAreaTables(player);
+
+    size_t nbShapeCells = 0;
+    for (const auto &row : shape)
+        nbShapeCells += static_cast<size_t>(std::count(row.begin(), row.end(), 1));
+
+    // Cells of the window in the box of an anchor, from the corners of a summed-area table
+    const size_t width = areaTo.second - areaFrom.second + 1;
+    auto countIn = [&](const std::vector<uint32_t> &area, size_t i0, size_t j0) {
+        size_t i1 = i0 + shape.size(), j1 = j0 + shape[0].size();
+        return area[i1 * width + j1] - area[i0 * width + j1] - area[i1 * width + j0] + area[i0 * width + j0];
+    };
+
+    // A placement covers a free cell next to the territory and as many allowed cells as the shape has, so its box must hold
+    // a frontier cell and enough allowed cells. Shapes fill their box, placements keep it on the board and in the window.
+    size_t nbAnchors = 0;
+    for (size_t x = areaFrom.first; x + shape.size() <= areaTo.first; ++x) {
+        for (size_t y = areaFrom.second; y + shape[0].size() <= areaTo.second; ++y) {
+            ++nbAnchors;
+            size_t i = x - areaFrom.first, j = y - areaFrom.second;
+            if (countIn(frontierArea, i, j) > 0 && countIn(allowedArea, i, j) >= nbShapeCells)
+                candidates.push_back({x, y}); // In the order of a scan of the whole board
+        }
+    }
+
+    AnchorStats &stats = anchorStats[std::min(NB_ANCHOR_PHASES - 1, census.count(GRASS) * NB_ANCHOR_PHASES / (size * size))];
+    stats.candidates += nbAnchors;
+    stats.pruned += nbAnchors - candidates.size();
+}
+
+void Board::updateAreaTables(const Player &player) const {
+    // Placements cover a cell next to the territory, so they stay within the largest tile side of it
+    static const size_t margin = [] {
+        size_t side = 0;
+        for (const Shape &shape : TILE_SHAPES)
+            side = std::max({side, shape.size(), shape[0].size()});
+        return side + 1;
+    }();
+    Component own = territory(player);
+    std::pair<size_t, size_t> from = {own.topLeft.first > margin ? own.topLeft.first - margin : 0,
+                                      own.topLeft.second > margin ? own.topLeft.second - margin : 0};
+    std::pair<size_t, size_t> to = {std::min(size, own.bottomRight.first + 1 + margin), std::min(size, own.bottomRight.second + 1 + margin)};
+
+    // The first row and column of the tables stay at zero
+    const size_t width = to.second - from.second + 1;
+    if (areaPlayer != &player || from != areaFrom || to != areaTo) {
+        areaPlayer = &player;
+        areaFrom = from;
+        areaTo = to;
+        allowedArea.assign((to.first - from.first + 1) * width, 0);
+        frontierArea.assign((to.first - from.first + 1) * width, 0);
+        areaStaleFrom = from.first;
+    }
+
+    const std::array<std::pair<int,int>,4> directions = {{{-1,0}, {1,0}, {0,-1}, {0,1}}};
+    for (size_t x = std::max(areaStaleFrom, from.first); x < to.first; ++x) {
+        uint32_t allowedRow = 0, frontierRow = 0;
+        for (size_t y = from.second; y < to.second; ++y) {
+            const Cell &cell = cells[x * size + y];
+            bool bAllowed = cell.type != GRASS && cell.type != STONE;
+            bool bNextToOwn = false;
+            for (size_t d = 0; d < directions.size() && bAllowed; ++d) {
+                size_t newX = x + directions[d].first;
+                size_t newY = y + directions[d].second;
+                if (newX < size && newY < size) {
+                    const Player *owner = cells[newX * size + newY].owner;
+                    bAllowed = !owner || owner == &player;
+                    bNextToOwn = bNextToOwn || owner == &player;
+                }
+            }
+            allowedRow += bAllowed;
+            frontierRow += bAllowed && bNextToOwn;
+            size_t i = x - from.first, j = y - from.second;
+            allowedArea[(i + 1) * width + j + 1] = allowedArea[i * width + j + 1] + allowedRow;
+            frontierArea[(i + 1) * width + j + 1] = frontierArea[i * width + j + 1] + frontierRow;
+        }
+    }
+    areaStaleFrom = size;
+}
+
+void Board::filterAnchors(const std::vector<std::pair<size_t, size_t>> &candidates, const Shape &shape, const Player &player,
+                          bool bFirstOnly, std::vector<std::pair<size_t, size_t>> &anchors) const {
+    anchors.clear();
+    bool bParallel = candidates.size() >= PARALLEL_MIN_CANDIDATES && ThreadPool::shared().getNbThreads() > 1;
+
+    std::visit([&](const auto &fixedGrid) {
+        if (bParallel)
+            filterAnchorsInBands(fixedGrid, candidates, shape, player, anchors, bFirstOnly, scratch);
+        else
+            filterAnchorsOn(fixedGrid, candidates, shape, player, anchors, bFirstOnly);
+    }, grid);
+}
+
+bool Board::canPlaceTileAnywhere(const Tile &tile, const Player &player) const {
+    const Shape &shape = tile.getShape();
+    candidateAnchors(shape, player, candidatesBuffer);
+    filterAnchors(candidatesBuffer, shape, player, true, anchorsBuffer);
+    return !anchorsBuffer.empty();
+}
+
+std::vector<std::pair<size_t, size_t>> Board::legalAnchors(const Shape &shape, const Player &player) const {
+    std::span<const std::pair<size_t, size_t>> anchors = searchAnchors(shape, player);
+    return {anchors.begin(), anchors.end()};
+}
+
+std::span<const std::pair<size_t, size_t>> Board::searchAnchors(const Shape &shape, const Player &player) const {
+    candidateAnchors(shape, player, candidatesBuffer);
+    filterAnchors(candidatesBuffer, shape, player, false, anchorsBuffer);
+    return anchorsBuffer;
 }
 
 void Board::placeTile(std::pair<size_t, size_t> coords, const Tile &tile, Player *player, bool bStealable) {
-    Shape shape = tile.getShape();
+    const Shape &shape = tile.getShape();
 
-    const std::array<std::string, 12> symbols = {"██", "██", "▒▒", "░░", "##", "[]", "@@", "&&", "$$", "++", "00", "OO"};
-    std::set<std::string> neighbourSymbols;
+    // Symbols used next to the tile, as bits of their indexes in TILE_SYMBOLS
+    uint32_t neighbourSymbols = 0;
 
     const std::array<std::pair<int,int>,4> directions = {{{-1,0}, {1,0}, {0,-1}, {0,1}}};
 
@@ -149,20 +613,22 @@ void Board::placeTile(std::pair<size_t, size_t> coords, const Tile &tile, Player
                 if (newX < 0 || newY < 0 || newX >= static_cast<int>(size) || newY >= static_cast<int>(size))
                     continue;
 
-                Cell &neighbourCell = grid[newX][newY];
+                Cell &neighbourCell = getCell({static_cast<size_t>(newX), static_cast<size_t>(newY)});
 
-                // Fill neighbourChars set
+                // Mark every entry of the neighbour's symbol
                 if (neighbourCell.type == GRASS && !neighbourCell.printSymbol.empty())
-                    neighbourSymbols.insert(neighbourCell.printSymbol);
+                    for (size_t s = 0; s < TILE_SYMBOLS.size(); ++s)
+                        if (TILE_SYMBOLS[s] == neighbourCell.printSymbol)
+                            neighbourSymbols |= 1u << s;
             }
         }
     }
 
     // Chose available character for printing
-    std::string availableSymbol = "██";
-    for (std::string s : symbols) {
-        if (neighbourSymbols.find(s) == neighbourSymbols.end()) {
-            availableSymbol = s;
+    const std::string *availableSymbol = &TILE_SYMBOLS[0];
+    for (size_t s = 0; s < TILE_SYMBOLS.size(); ++s) {
+        if (!(neighbourSymbols >> s & 1)) {
+            availableSymbol = &TILE_SYMBOLS[s];
             break;
         }
     }
@@ -174,127 +640,943 @@ void Board::placeTile(std::pair<size_t, size_t> coords, const Tile &tile, Player
             if (!shape[i][j])
                 continue;
 
-            Cell &cell = grid[coords.first + i][coords.second + j];
-            cell.type = GRASS;
+            Cell &cell = getCell({coords.first + i, coords.second + j});
+            setType({coords.first + i, coords.second + j}, GRASS);
             cell.owner = player;
-            cell.printSymbol = availableSymbol;
+            cell.printSymbol = *availableSymbol;
+            addTerritoryCell({coords.first + i, coords.second + j}, player);
         }
     }
 
-    checkBonusCapture(player);
+    Arena::Scope scope(scratch);
+    std::span<Bonus> captured = scratch.take<Bonus>(shape.size() * shape[0].size() * 4);
+    captured = captured.first(captureBonusesAround(coords, shape, player, captured));
+    markBonusesAround(coords, {coords.first + shape.size() - 1, coords.second + shape[0].size() - 1});
     placedTiles.push_back({tile, coords, player, bStealable});
+    stealablePosition.push_back(NOT_STEALABLE);
+    indexTile(placedTiles.size() - 1);
+    if (bStealable)
+        addStealable(placedTiles.size() - 1);
+    updateSquare(coords, shape, *player);
+
+    if (listeners.empty())
+        return;
+    std::span<std::pair<size_t, size_t>> covered = scratch.take<std::pair<size_t, size_t>>(shape.size() * shape[0].size());
+    size_t nbCovered = 0;
+    for (size_t i = 0; i < shape.size(); ++i)
+        for (size_t j = 0; j < shape[i].size(); ++j)
+            if (shape[i][j])
+                covered[nbCovered++] = {coords.first + i, coords.second + j};
+    emit(CellsCovered{player, placedTiles.size() - 1, covered.first(nbCovered)});
+    for (const Bonus &bonus : captured)
+        emit(BonusCaptured{player, bonus.coords, bonus.type});
 }
 
-void Board::checkBonusCapture(Player *player) {
+void Board::indexTile(size_t index) {
+    const PlacedTile &placedTile = placedTiles[index];
+    const Shape &shape = placedTile.tile.getShape();
+
+    for (size_t i = 0; i < shape.size(); ++i)
+        for (size_t j = 0; j < shape[i].size(); ++j)
+            if (shape[i][j])
+                tileAt[(placedTile.coords.first + i) * size + placedTile.coords.second + j] = static_cast<uint32_t>(index + 1);
+}
+
+void Board::restorePlacedTiles(std::vector<PlacedTile> tiles) {
+    placedTiles = std::move(tiles);
+    tileAt.assign(size * size, 0);
+    stealable.clear();
+    stealablePosition.assign(placedTiles.size(), NOT_STEALABLE);
+    stealableCounts.clear();
+    for (size_t i = 0; i < placedTiles.size(); ++i) {
+        indexTile(i);
+        if (placedTiles[i].bStealable)
+            addStealable(i);
+    }
+    squares.clear();
+}
+
+void Board::reassignOwners(const Player *from, Player *to, size_t nbPlayers) {
+    auto owner = [&](const Player *player) -> Player * {
+        std::less<const Player *> before; // Players of other games are not ordered with operator<
+        if (!player || before(player, from) || !before(player, from + nbPlayers))
+            return const_cast<Player *>(player); // Nobody, or a player that is not copied
+        return to + (player - from);
+    };
+    auto rekey = [&](auto &map) {
+        for (auto &entry : map)
+            entry.first = owner(entry.first);
+    };
+
+    for (size_t i = 0; i < size * size; ++i)
+        cells[i].owner = owner(cells[i].owner);
+    for (PlacedTile &placed : placedTiles)
+        placed.owner = owner(placed.owner);
+    for (auto &reach : bonusReach)
+        for (auto &entry : reach)
+            entry.first = owner(entry.first);
+    rekey(squares);
+    rekey(stealableCounts);
+    rekey(firstRoot);
+    areaPlayer = nullptr;
+}
+
+void Board::addStealable(size_t index) {
+    stealablePosition[index] = static_cast<uint32_t>(stealable.size());
+    stealable.push_back(static_cast<uint32_t>(index));
+    ++stealableCounts[placedTiles[index].owner];
+}
+
+void Board::removeStealable(size_t index) {
+    uint32_t position = stealablePosition[index];
+    if (position == NOT_STEALABLE)
+        return;
+
+    // The last stealable tile takes the place of the removed one
+    uint32_t last = stealable.back();
+    stealable[position] = last;
+    stealablePosition[last] = position;
+    stealable.pop_back();
+    stealablePosition[index] = NOT_STEALABLE;
+
+    size_t *count = stealableCounts.find(placedTiles[index].owner);
+    if (--*count == 0)
+        stealableCounts.erase(placedTiles[index].owner);
+}
+
+const PlacedTile* Board::tileAtCell(std::pair<size_t, size_t> coords) const {
+    uint32_t index = tileAt[coords.first * size + coords.second];
+    return index ? &placedTiles[index - 1] : nullptr;
+}
+
+bool Board::captureBonus(std::pair<size_t, size_t> coords, Player *player) {
+    const std::array<std::pair<int,int>,4> directions = {{{-1,0}, {1,0}, {0,-1}, {0,1}}};
+    Cell &cell = getCell(coords);
+
+    for (const auto &around : directions) {
+        const Cell &neighbour = getCell({coords.first + around.first, coords.second + around.second});
+        if (neighbour.owner != player || neighbour.type != GRASS)
+            return false;
+    }
+
+    switch (cell.type) {
+        case BONUS_EXCHANGE:
+            player->addCoupon();
+            cell.printSymbol = "Ｅ";
+            break;
+        case BONUS_STONE:
+            player->addStoneBonus();
+            cell.printSymbol = "Ｓ";
+            break;
+        case BONUS_ROBBERY:
+            player->addRobberyBonus();
+            cell.printSymbol = "Ｒ";
+            break;
+        default:
+            break;
+    }
+
+    setType(coords, GRASS);
+    cell.owner = player;
+    addTerritoryCell(coords, player);
+    markBonusesAround(coords, coords);
+    return true;
+}
+
+uint32_t Board::findComponent(uint32_t cell) {
+    while (componentParent[cell] != cell) {
+        componentParent[cell] = componentParent[componentParent[cell]]; // Path halving
+        cell = componentParent[cell];
+    }
+    return cell;
+}
+
+void Board::addRoot(uint32_t root, const Player *player) {
+    uint32_t *first = firstRoot.find(player);
+    nextRoot[root] = first ? *first : NO_ROOT;
+    previousRoot[root] = NO_ROOT;
+    if (first) {
+        previousRoot[*first] = root;
+        *first = root;
+    } else {
+        firstRoot[player] = root;
+    }
+}
+
+void Board::eraseRoot(uint32_t root, const Player *player) {
+    if (previousRoot[root] == NOT_ROOT)
+        return;
+
+    uint32_t next = nextRoot[root];
+    uint32_t previous = previousRoot[root];
+    if (next != NO_ROOT)
+        previousRoot[next] = previous;
+    if (previous != NO_ROOT)
+        nextRoot[previous] = next;
+    else if (next != NO_ROOT)
+        *firstRoot.find(player) = next;
+    else
+        firstRoot.erase(player); // Last component of the territory
+    nextRoot[root] = NOT_ROOT;
+    previousRoot[root] = NOT_ROOT;
+}
+
+void Board::addTerritoryCell(std::pair<size_t, size_t> coords, const Player *player) {
+    const std::array<std::pair<int,int>,4> directions = {{{-1,0}, {1,0}, {0,-1}, {0,1}}};
+
+    uint32_t cell = static_cast<uint32_t>(coords.first * size + coords.second);
+    componentParent[cell] = cell;
+    components[cell] = {1, coords, coords};
+    addRoot(cell, player);
+
+    // Merge with the components of the neighbours, the smaller one into the larger one
+    for (const auto &dir : directions) {
+        size_t x = coords.first + dir.first;
+        size_t y = coords.second + dir.second;
+        if (x >= size || y >= size || getCell({x, y}).owner != player)
+            continue;
+
+        uint32_t root = findComponent(cell);
+        uint32_t other = findComponent(static_cast<uint32_t>(x * size + y));
+        if (root == other)
+            continue;
+        if (components[root].area < components[other].area)
+            std::swap(root, other);
+
+        Component &merged = components[root];
+        const Component &absorbed = components[other];
+        merged.area += absorbed.area;
+        merged.topLeft = {std::min(merged.topLeft.first, absorbed.topLeft.first), std::min(merged.topLeft.second, absorbed.topLeft.second)};
+        merged.bottomRight = {std::max(merged.bottomRight.first, absorbed.bottomRight.first),
+                              std::max(merged.bottomRight.second, absorbed.bottomRight.second)};
+
+        componentParent[other] = root;
+        eraseRoot(other, player);
+    }
+}
+
+void Board::splitTerritory(std::span<const std::pair<size_t, size_t>> removed, const Player *player) {
+    const std::array<std::pair<int,int>,4> directions = {{{-1,0}, {1,0}, {0,-1}, {0,1}}};
+    Arena::Scope scope(scratch);
+
+    // Removed cells no longer belong to the player, what is left of their components starts from their neighbours
+    std::span<uint32_t> seeds = scratch.take<uint32_t>(removed.size() * directions.size());
+    size_t nbSeeds = 0;
+    std::pair<size_t, size_t> from = {size, size}, to = {0, 0}; // Bounding box of the old components
+    for (std::pair<size_t, size_t> coords : removed) {
+        uint32_t root = findComponent(static_cast<uint32_t>(coords.first * size + coords.second));
+        const Component &old = components[root];
+        from = {std::min(from.first, old.topLeft.first), std::min(from.second, old.topLeft.second)};
+        to = {std::max(to.first, old.bottomRight.first), std::max(to.second, old.bottomRight.second)};
+        eraseRoot(root, player);
+        for (const auto &dir : directions) {
+            size_t x = coords.first + dir.first;
+            size_t y = coords.second + dir.second;
+            if (x < size && y < size && getCell({x, y}).owner == player)
+                seeds[nbSeeds++] = static_cast<uint32_t>(x * size + y);
+        }
+    }
+    for (std::pair<size_t, size_t> coords : removed)
+        componentParent[coords.first * size + coords.second] = static_cast<uint32_t>(coords.first * size + coords.second);
+    if (nbSeeds == 0)
+        return;
+
+    // Flood fill of the remaining cells, only the old components are visited
+    const size_t width = to.second - from.second + 1;
+    const size_t nbBoxCells = (to.first - from.first + 1) * width;
+    std::span<uint8_t> visited = scratch.take<uint8_t>(nbBoxCells, 0);
+    std::span<uint32_t> stack = scratch.take<uint32_t>(nbBoxCells); // Cells are pushed once
+    auto visit = [&](uint32_t cell) {
+        uint8_t &bSeen = visited[(cell / size - from.first) * width + cell % size - from.second];
+        bool bNew = !bSeen;
+        bSeen = 1;
+        return bNew;
+    };
+    for (uint32_t seed : seeds.first(nbSeeds)) {
+        if (!visit(seed))
+            continue;
+
+        std::pair<size_t, size_t> seedCoords = {seed / size, seed % size};
+        Component component = {0, seedCoords, seedCoords};
+        size_t nbStacked = 0;
+        stack[nbStacked++] = seed;
+        while (nbStacked > 0) {
+            uint32_t cell = stack[--nbStacked];
+            size_t x = cell / size;
+            size_t y = cell % size;
+
+            componentParent[cell] = seed;
+            ++component.area;
+            component.topLeft = {std::min(component.topLeft.first, x), std::min(component.topLeft.second, y)};
+            component.bottomRight = {std::max(component.bottomRight.first, x), std::max(component.bottomRight.second, y)};
+
+            for (const auto &dir : directions) {
+                size_t newX = x + dir.first;
+                size_t newY = y + dir.second;
+                uint32_t next = static_cast<uint32_t>(newX * size + newY);
+                if (newX < size && newY < size && getCell({newX, newY}).owner == player && visit(next))
+                    stack[nbStacked++] = next;
+            }
+        }
+
+        components[seed] = component;
+        addRoot(seed, player);
+    }
+}
+
+void Board::markBonusesAround(std::pair<size_t, size_t> topLeft, std::pair<size_t, size_t> bottomRight) {
+    // Only bonuses within bonusHorizon steps of a changed cell can see it
+    size_t nbBuckets = (size + bonusHorizon - 1) / bonusHorizon;
+    size_t firstRow = topLeft.first > bonusHorizon ? (topLeft.first - bonusHorizon) / bonusHorizon : 0;
+    size_t firstCol = topLeft.second > bonusHorizon ? (topLeft.second - bonusHorizon) / bonusHorizon : 0;
+    size_t lastRow = std::min(nbBuckets - 1, (bottomRight.first + bonusHorizon) / bonusHorizon);
+    size_t lastCol = std::min(nbBuckets - 1, (bottomRight.second + bonusHorizon) / bonusHorizon);
+
+    for (size_t row = firstRow; row <= lastRow; ++row) {
+        for (size_t col = firstCol; col <= lastCol; ++col) {
+            for (uint32_t bonus : bonusBuckets[row * nbBuckets + col]) {
+                std::pair<size_t, size_t> coords = bonusLayout[bonus].coords;
+                size_t dx = coords.first < topLeft.first ? topLeft.first - coords.first
+                            : coords.first > bottomRight.first ? coords.first - bottomRight.first : 0;
+                size_t dy = coords.second < topLeft.second ? topLeft.second - coords.second
+                            : coords.second > bottomRight.second ? coords.second - bottomRight.second : 0;
+                if (dx + dy <= bonusHorizon)
+                    bReachStale[bonus] = true;
+            }
+        }
+    }
+}
+
+void Board::computeBonusReach(size_t bonus) const {
     const std::array<std::pair<int,int>,4> directions = {{{-1,0}, {1,0}, {0,-1}, {0,1}}};
+    std::vector<std::pair<const Player *, uint16_t>> &reach = bonusReach[bonus];
+    reach.clear();
+    bReachStale[bonus] = false;
+
+    std::pair<size_t, size_t> origin = bonusLayout[bonus].coords;
+    if (getCell(origin).type != bonusLayout[bonus].type)
+        return; // Captured or covered
+
+    // Breadth-first search from the bonus through free cells, the first cell met of each territory is the closest
+    const size_t side = 2 * bonusHorizon + 1;
+    std::vector<bool> visited(side * side, false);
+    auto mark = [&](size_t x, size_t y) {
+        size_t i = (x + bonusHorizon - origin.first) * side + (y + bonusHorizon - origin.second);
+        bool bSeen = visited[i];
+        visited[i] = true;
+        return !bSeen;
+    };
+
+    std::queue<std::pair<std::pair<size_t, size_t>, size_t>> queue;
+    queue.push({origin, 0});
+    mark(origin.first, origin.second);
+
+    while (!queue.empty()) {
+        auto [coords, distance] = queue.front();
+        queue.pop();
+
+        for (const auto &dir : directions) {
+            size_t x = coords.first + dir.first;
+            size_t y = coords.second + dir.second;
+            if (x >= size || y >= size)
+                continue;
 
-    for (int x = 0; x < static_cast<int>(size); ++x) {
-        for (int y = 0; y < static_cast<int>(size); ++y) {
-            Cell &cell = grid[x][y];
+            const Cell &cell = getCell({x, y});
+            if (cell.owner) {
+                bool bKnown = std::any_of(reach.begin(), reach.end(), [&](const auto &entry) { return entry.first == cell.owner; });
+                if (!bKnown)
+                    reach.push_back({cell.owner, static_cast<uint16_t>(distance + 1)});
+            } else if (cell.type != STONE && cell.type != GRASS && distance + 1 < bonusHorizon && mark(x, y)) {
+                queue.push({{x, y}, distance + 1});
+            }
+        }
+    }
+}
 
-            if (cell.type != BONUS_EXCHANGE &&
-                cell.type != BONUS_STONE &&
-                cell.type != BONUS_ROBBERY)
+std::vector<Component> Board::territoryComponents(const Player &player) const {
+    std::vector<Component> result;
+    const uint32_t *first = firstRoot.find(&player);
+    for (uint32_t root = first ? *first : NO_ROOT; root != NO_ROOT; root = nextRoot[root])
+        result.push_back(components[root]);
+    std::sort(result.begin(), result.end(), [](const Component &a, const Component &b) {
+        return a.area != b.area ? a.area > b.area : a.topLeft < b.topLeft;
+    });
+    return result;
+}
+
+Component Board::territory(const Player &player) const {
+    Component total = {0, {size, size}, {0, 0}};
+    const uint32_t *first = firstRoot.find(&player);
+    if (!first)
+        return {0, {0, 0}, {0, 0}};
+
+    for (uint32_t root = *first; root != NO_ROOT; root = nextRoot[root]) {
+        const Component &component = components[root];
+        total.area += component.area;
+        total.topLeft = {std::min(total.topLeft.first, component.topLeft.first), std::min(total.topLeft.second, component.topLeft.second)};
+        total.bottomRight = {std::max(total.bottomRight.first, component.bottomRight.first),
+                             std::max(total.bottomRight.second, component.bottomRight.second)};
+    }
+    if (total.area == 0)
+        return {0, {0, 0}, {0, 0}};
+    return total;
+}
+
+std::vector<BonusDistance> Board::bonusDistances(const Player &player) const {
+    std::vector<BonusDistance> result;
+    for (size_t bonus = 0; bonus < bonusLayout.size(); ++bonus) {
+        if (bReachStale[bonus])
+            computeBonusReach(bonus);
+        for (const auto &[owner, distance] : bonusReach[bonus])
+            if (owner == &player)
+                result.push_back({bonusLayout[bonus].coords, bonusLayout[bonus].type, distance});
+    }
+    std::sort(result.begin(), result.end(), [](const BonusDistance &a, const BonusDistance &b) {
+        return a.distance != b.distance ? a.distance < b.distance : a.coords < b.coords;
+    });
+    return result;
+}
+
+size_t Board::captureBonusesAround(std::pair<size_t, size_t> coords, const Shape &shape, Player *player, std::span<Bonus> captured) {
+    const std::array<std::pair<int,int>,4> directions = {{{-1,0}, {1,0}, {0,-1}, {0,1}}};
+    size_t nbCaptured = 0;
+
+    // Only a bonus next to the new tile can have just been surrounded
+    for (size_t i = 0; i < shape.size(); ++i) {
+        for (size_t j = 0; j < shape[i].size(); ++j) {
+            if (!shape[i][j])
                 continue;
 
-            bool surrounded = true;
             for (const auto &dir : directions) {
-                int newX = x + dir.first;
-                int newY = y + dir.second;
+                size_t x = coords.first + i + dir.first;
+                size_t y = coords.second + j + dir.second;
 
-                if (newX < 0 || newY < 0 || newX >= static_cast<int>(size) || newY >= static_cast<int>(size)) {
-                    surrounded = false;
-                    break;
-                }
+                // Bonuses are never on edges
+                if (x < 1 || y < 1 || x >= size - 1 || y >= size - 1)
+                    continue;
 
-                Cell &neighbour = grid[newX][newY];
-                if (neighbour.owner != player || neighbour.type != GRASS) {
-                    surrounded = false;
-                    break;
-                }
+                CellType type = getCell({x, y}).type;
+                if ((type == BONUS_EXCHANGE || type == BONUS_STONE || type == BONUS_ROBBERY) && captureBonus({x, y}, player))
+                    captured[nbCaptured++] = {{x, y}, type};
             }
+        }
+    }
+    return nbCaptured;
+}
 
-            if (surrounded) {
-                switch (cell.type) {
-                    case BONUS_EXCHANGE:
-                        player->addCoupon();
-                        cell.printSymbol = "Ｅ";
-                        break;
-                    case BONUS_STONE:
-                        player->addStoneBonus();
-                        cell.printSymbol = "Ｓ";
-                        break;
-                    case BONUS_ROBBERY:
-                        player->addRobberyBonus();
-                        cell.printSymbol = "Ｒ";
-                        break;
-                    default:
-                        break;
-                }
+void Board::updateSquare(std::pair<size_t, size_t> coords, const Shape &shape, const Player &player) {
+    Square *square = squares.find(&player);
+    if (!square)
+        return;
+
+    // A new square of side s holds a cell of the tile or of a captured bonus, and the rest of it holds
+    // an older square of side at least (s - 9) / 2 : new squares fit in a margin of 2 * side + 10.
+    Square &best = *square;
+    size_t margin = 2 * best.side + 10;
+    size_t x0 = coords.first > margin ? coords.first - margin : 0;
+    size_t y0 = coords.second > margin ? coords.second - margin : 0;
+    size_t x1 = std::min(size, coords.first + shape.size() + margin);
+    size_t y1 = std::min(size, coords.second + shape[0].size() + margin);
+
+    Square local = largestSquareIn(player, x0, x1, y0, y1);
+    if (local.side > best.side || (local.side == best.side && local.side > 0 && local.corner < best.corner))
+        best = local;
+}
 
-                cell.type = GRASS;
-                cell.owner = player;
+void Board::checkBonusCapture(Player *player) {
+    // Uncaptured bonuses are still listed in the layout, and are never next to each other
+    for (const Bonus &bonus : bonusLayout) {
+        if (getCell(bonus.coords).type == bonus.type && captureBonus(bonus.coords, player)) {
+            squares.erase(player);
+            if (!listeners.empty())
+                emit(BonusCaptured{player, bonus.coords, bonus.type});
+        }
+    }
+}
+
+Square Board::largestSquareIn(const Player &player, size_t x0, size_t x1, size_t y0, size_t y1) const {
+    bool bParallel = (x1 - x0) * (y1 - y0) >= PARALLEL_MIN_CELLS && ThreadPool::shared().getNbThreads() > 1;
+
+    return std::visit([&](const auto &fixedGrid) {
+        if (bParallel)
+            return largestSquareWavefront(fixedGrid, player, x0, x1, y0, y1, scratch);
+        return largestSquareOn(fixedGrid, player, x0, x1, y0, y1, scratch);
+    }, grid);
+}
+
+Square Board::largestSquare(const Player &player) const {
+    if (const Square *known = squares.find(&player))
+        return *known;
+
+    // Only the territory's bounding box can hold its squares
+    Component box = territory(player);
+    Square square = {0, {0, 0}};
+    if (box.area > 0)
+        square = largestSquareIn(player, box.topLeft.first, box.bottomRight.first + 1, box.topLeft.second, box.bottomRight.second + 1);
+    squares[&player] = square;
+    return square;
+}
+
+/**
+Largest squares of a territory, by rows and columns of its bounding box.
+It gives the largest square whose corner lies outside of a rectangle, which a local change cannot shrink.
+Its tables are taken from an arena, and live as long as the scope that built it.
+*/
+struct SquareProfile {
+    size_t top = 0, left = 0, height = 0, width = 0;
+    std::span<size_t> above, below, before, after; // Largest side with its corner strictly above, below, before or after each row or column
+
+    SquareProfile() = default;
+    SquareProfile(const Board &board, const Player &player, const Component &territory, Arena &arena)
+        : top(territory.topLeft.first), left(territory.topLeft.second), height(territory.bottomRight.first - top + 1),
+          width(territory.bottomRight.second - left + 1), above(arena.take<size_t>(height + 1, 0)),
+          below(arena.take<size_t>(height + 1, 0)), before(arena.take<size_t>(width + 1, 0)), after(arena.take<size_t>(width + 1, 0)) {
+        Arena::Scope scope(arena);
+        std::span<size_t> previous = arena.take<size_t>(width, 0), current = arena.take<size_t>(width, 0);
+        std::span<size_t> rowMax = arena.take<size_t>(height, 0), columnMax = arena.take<size_t>(width, 0);
+        for (size_t i = 0; i < height; ++i) {
+            for (size_t j = 0; j < width; ++j) {
+                if (board.getCell({top + i, left + j}).owner != &player)
+                    current[j] = 0;
+                else if (i == 0 || j == 0)
+                    current[j] = 1;
+                else
+                    current[j] = 1 + std::min({previous[j], current[j - 1], previous[j - 1]});
+                rowMax[i] = std::max(rowMax[i], current[j]);
+                columnMax[j] = std::max(columnMax[j], current[j]);
             }
+            std::swap(previous, current);
         }
+
+        for (size_t i = 0; i < height; ++i)
+            above[i + 1] = std::max(above[i], rowMax[i]);
+        for (size_t i = height; i-- > 0;)
+            below[i] = std::max(below[i + 1], rowMax[i]);
+        for (size_t j = 0; j < width; ++j)
+            before[j + 1] = std::max(before[j], columnMax[j]);
+        for (size_t j = width; j-- > 0;)
+            after[j] = std::max(after[j + 1], columnMax[j]);
     }
+
+    // Largest side with its corner outside of rows [x0, x1] and columns [y0, y1], which end inside the bounding box.
+    size_t outside(size_t x0, size_t x1, size_t y0, size_t y1) const {
+        size_t lastRow = std::min(x1 - top + 1, height);
+        size_t lastColumn = std::min(y1 - left + 1, width);
+        return std::max({above[std::max(x0, top) - top], below[lastRow], before[std::max(y0, left) - left], after[lastColumn]});
+    }
+};
+
+size_t Board::squareSideWithout(const Player &player, size_t tile, size_t x0, size_t x1, size_t y0, size_t y1) const {
+    Arena::Scope scope(scratch);
+    std::span<size_t> previous = scratch.take<size_t>(y1 - y0, 0), current = scratch.take<size_t>(y1 - y0, 0);
+    size_t best = 0;
+
+    for (size_t x = x0; x < x1; ++x) {
+        for (size_t y = y0; y < y1; ++y) {
+            size_t j = y - y0;
+            if (cells[x * size + y].owner != &player || tileAt[x * size + y] == tile + 1)
+                current[j] = 0;
+            else if (x == x0 || y == y0)
+                current[j] = 1;
+            else
+                current[j] = 1 + std::min({previous[j], current[j - 1], previous[j - 1]});
+            best = std::max(best, current[j]);
+        }
+        std::swap(previous, current);
+    }
+    return best;
 }
 
-std::optional<Tile> Board::stealTile(std::pair<size_t, size_t> target, Player *newOwner) {
-    // Go through every tile in the board
-    for (auto it = placedTiles.begin(); it != placedTiles.end(); ++it) {
-        PlacedTile &placedTile = *it;
+std::span<const RobberyDelta> Board::robberyDeltas(const Player &thief) const {
+    std::vector<RobberyDelta> &deltas = deltasBuffer;
+    deltas.clear();
 
-        // Avoid starting tiles
-        if (!placedTile.bStealable)
-            continue;
+    // Built once per victim, only when needed
+    Arena::Scope scope(scratch);
+    std::span<std::pair<const Player *, SquareProfile>> profiles = scratch.take<std::pair<const Player *, SquareProfile>>(firstRoot.size());
+    size_t nbProfiles = 0;
 
-        // Avoid own tiles
-        if (placedTile.owner == newOwner)
+    for (uint32_t index : stealable) {
+        const PlacedTile &placed = placedTiles[index];
+        if (placed.owner == &thief)
             continue;
 
-        Shape shape = placedTile.tile.getShape();
-        size_t posX = placedTile.coords.first;
-        size_t posY = placedTile.coords.second;
+        const Shape &shape = placed.tile.getShape();
+        size_t x0 = placed.coords.first, y0 = placed.coords.second;
+        size_t x1 = x0 + shape.size() - 1, y1 = y0 + shape[0].size() - 1;
+        Square square = largestSquare(*placed.owner);
+        RobberyDelta delta = {index, placed.coords, placed.owner, 0, square.side, square.side};
 
-        // Go through every cell covered by that tile
+        // Only a square covering one of the tile's cells can shrink
+        size_t squareX = square.corner.first + 1 - square.side;
+        size_t squareY = square.corner.second + 1 - square.side;
+        bool bInSquare = false;
         for (size_t i = 0; i < shape.size(); ++i) {
             for (size_t j = 0; j < shape[i].size(); ++j) {
                 if (!shape[i][j])
                     continue;
+                if (delta.cells++ == 0)
+                    delta.target = {x0 + i, y0 + j};
+                bInSquare = bInSquare || (x0 + i >= squareX && x0 + i <= square.corner.first && y0 + j >= squareY && y0 + j <= square.corner.second);
+            }
+        }
 
-                if (posX + i == target.first && posY + j == target.second) {
-                    // Remove stolen tile from the board
-                    for (size_t i2 = 0; i2 < shape.size(); ++i2) {
-                        for (size_t j2 = 0; j2 < shape[i2].size(); ++j2) {
-                            if (!shape[i2][j2])
-                                continue;
+        if (bInSquare) {
+            // Squares whose corner is below or right of the tile, within one side of it, may lose cells.
+            // They all fit around the tile, any other one keeps its side.
+            auto profile = profiles.begin();
+            while (profile != profiles.begin() + nbProfiles && profile->first != placed.owner)
+                ++profile;
+            if (profile == profiles.begin() + nbProfiles) {
+                *profile = {placed.owner, SquareProfile(*this, *placed.owner, territory(*placed.owner), scratch)};
+                ++nbProfiles;
+            }
 
-                            Cell &cell = grid[posX + i2][posY + j2];
-                            cell.type = EMPTY;
-                            cell.owner = nullptr;
-                            cell.printSymbol = "";
-                        }
-                    }
+            size_t side = square.side;
+            size_t kept = profile->second.outside(x0, x1 + side - 1, y0, y1 + side - 1);
+            size_t around = squareSideWithout(*placed.owner, index, x0 + 1 > side ? x0 + 1 - side : 0, std::min(size, x1 + side),
+                                              y0 + 1 > side ? y0 + 1 - side : 0, std::min(size, y1 + side));
+            delta.squareAfter = std::max(kept, around);
+        }
+        deltas.push_back(delta);
+    }
+
+    std::sort(deltas.begin(), deltas.end(), [](const RobberyDelta &a, const RobberyDelta &b) { return a.tileIndex < b.tileIndex; });
+    return deltas;
+}
+
+void Board::addPotentialLoss(const Player &player, std::span<uint32_t> loss) const {
+    Component box = territory(player);
+    if (box.area == 0)
+        return;
+
+    size_t x0 = box.topLeft.first > bonusHorizon ? box.topLeft.first - bonusHorizon : 0;
+    size_t y0 = box.topLeft.second > bonusHorizon ? box.topLeft.second - bonusHorizon : 0;
+    size_t height = std::min(size, box.bottomRight.first + bonusHorizon + 1) - x0;
+    size_t width = std::min(size, box.bottomRight.second + bonusHorizon + 1) - y0;
+
+    // Own cells counted over rectangles, and free or own cells a square can be made of
+    Arena::Scope scope(scratch);
+    std::span<uint32_t> owned = scratch.take<uint32_t>((height + 1) * (width + 1), 0);
+    std::span<uint8_t> open = scratch.take<uint8_t>(height * width, 0);
+    for (size_t i = 0; i < height; ++i) {
+        for (size_t j = 0; j < width; ++j) {
+            const Cell &cell = cells[(x0 + i) * size + y0 + j];
+            bool bOwn = cell.owner == &player;
+            open[i * width + j] = bOwn || (cell.type != GRASS && cell.type != STONE);
+            owned[(i + 1) * (width + 1) + j + 1] = bOwn + owned[i * (width + 1) + j + 1] + owned[(i + 1) * (width + 1) + j] - owned[i * (width + 1) + j];
+        }
+    }
+    auto holdsOwn = [&](size_t i, size_t j, size_t side) { // Square of top left (i, j)
+        return owned[(i + side) * (width + 1) + j + side] - owned[i * (width + 1) + j + side] - owned[(i + side) * (width + 1) + j]
+                   + owned[i * (width + 1) + j] > 0;
+    };
+
+    // Largest open squares ending and starting on each cell, kept if they hold an own cell.
+    // A square missing a cell lies entirely above, below, left or right of it, so the best one left by a stone is
+    // the best of those four sides.
+    std::span<size_t> ending = scratch.take<size_t>(height * width, 0), starting = scratch.take<size_t>(height * width, 0);
+    std::span<size_t> above = scratch.take<size_t>(height + 1, 0), below = scratch.take<size_t>(height + 1, 0);
+    std::span<size_t> before = scratch.take<size_t>(width + 1, 0), after = scratch.take<size_t>(width + 1, 0);
+    for (size_t i = 0; i < height; ++i) {
+        for (size_t j = 0; j < width; ++j) {
+            size_t k = i * width + j;
+            if (open[k])
+                ending[k] = i == 0 || j == 0 ? 1 : 1 + std::min({ending[k - width], ending[k - 1], ending[k - width - 1]});
+        }
+    }
+    for (size_t i = height; i-- > 0;) {
+        for (size_t j = width; j-- > 0;) {
+            size_t k = i * width + j;
+            if (open[k])
+                starting[k] = i + 1 == height || j + 1 == width ? 1 : 1 + std::min({starting[k + width], starting[k + 1], starting[k + width + 1]});
+        }
+    }
 
-                    Tile stolenTile = placedTile.tile;
+    size_t best = 0;
+    for (size_t i = 0; i < height; ++i) {
+        for (size_t j = 0; j < width; ++j) {
+            size_t k = i * width + j;
+            size_t end = ending[k] && holdsOwn(i + 1 - ending[k], j + 1 - ending[k], ending[k]) ? ending[k] : 0;
+            size_t start = starting[k] && holdsOwn(i, j, starting[k]) ? starting[k] : 0;
+            best = std::max(best, end);
+            above[i + 1] = std::max(above[i + 1], end);  // Squares within rows up to i
+            below[i] = std::max(below[i], start);        // Squares within rows from i
+            before[j + 1] = std::max(before[j + 1], end);
+            after[j] = std::max(after[j], start);
+        }
+    }
+    for (size_t i = 0; i < height; ++i)
+        above[i + 1] = std::max(above[i + 1], above[i]);
+    for (size_t i = height; i-- > 0;)
+        below[i] = std::max(below[i], below[i + 1]);
+    for (size_t j = 0; j < width; ++j)
+        before[j + 1] = std::max(before[j + 1], before[j]);
+    for (size_t j = width; j-- > 0;)
+        after[j] = std::max(after[j], after[j + 1]);
+
+    for (size_t i = 0; i < height; ++i) {
+        for (size_t j = 0; j < width; ++j) {
+            size_t index = (x0 + i) * size + y0 + j;
+            if (cells[index].type == EMPTY)
+                loss[index] += static_cast<uint32_t>(best - std::max({above[i], below[i + 1], before[j], after[j + 1]}));
+        }
+    }
+}
 
-                    placedTiles.erase(it);
+std::span<const StoneImpact> Board::stoneImpacts(const Player &player, std::span<const Tile> tiles) const {
+    static const size_t maxShapeCells = [] {
+        size_t nbCells = 0;
+        for (const Shape &shape : TILE_SHAPES)
+            nbCells = std::max(nbCells, shape.size() * shape[0].size());
+        return nbCells;
+    }();
+    Arena::Scope scope(scratch);
+    std::span<uint32_t> placements = scratch.take<uint32_t>(size * size, 0), squareLoss = scratch.take<uint32_t>(size * size, 0);
+
+    // Cells of each orientation of the coming tiles, a tile drawn twice counts twice.
+    // Shape s covers shapeCells from shapeStarts[s] to shapeStarts[s + 1].
+    std::span<std::pair<size_t, size_t>> shapeCells = scratch.take<std::pair<size_t, size_t>>(tiles.size() * 8 * maxShapeCells);
+    std::span<size_t> shapeStarts = scratch.take<size_t>(tiles.size() * 8 + 1, 0);
+    size_t nbShapes = 0;
+    for (const Tile &tile : tiles) {
+        std::array<const Shape *, 8> orientations;
+        size_t nbOrientations = 0;
+        for (uint8_t orientation = 0; orientation < 8; ++orientation) {
+            const Shape &shape = Tile::fromId(tile.getId(), orientation).getShape();
+            if (std::none_of(orientations.begin(), orientations.begin() + nbOrientations, [&](const Shape *other) { return *other == shape; }))
+                orientations[nbOrientations++] = &shape;
+        }
+        for (const Shape *shape : std::span(orientations).first(nbOrientations)) {
+            size_t nbCells = shapeStarts[nbShapes];
+            for (size_t i = 0; i < shape->size(); ++i)
+                for (size_t j = 0; j < (*shape)[i].size(); ++j)
+                    if ((*shape)[i][j])
+                        shapeCells[nbCells++] = {i, j};
+            shapeStarts[++nbShapes] = nbCells;
+        }
+    }
 
-                    return stolenTile;
+    // A free cell can be covered by the only player owning cells around it, or by anyone if there is none.
+    // The cells next to a player's territory are where its placements start from.
+    const Player *const SHARED = reinterpret_cast<const Player *>(&cells); // Marks cells next to several players
+    const std::array<std::pair<int,int>,4> directions = {{{-1,0}, {1,0}, {0,-1}, {0,1}}};
+    std::span<const Player *> neighbour = scratch.take<const Player *>(size * size, nullptr);
+    std::span<uint8_t> bFree = scratch.take<uint8_t>(size * size, 0);
+    for (size_t x = 0; x < size; ++x) {
+        for (size_t y = 0; y < size; ++y) {
+            size_t index = x * size + y;
+            bFree[index] = cells[index].type != GRASS && cells[index].type != STONE;
+            for (const auto &dir : directions) {
+                size_t newX = x + dir.first;
+                size_t newY = y + dir.second;
+                const Player *owner = newX < size && newY < size ? cells[newX * size + newY].owner : nullptr;
+                if (owner && neighbour[index] && neighbour[index] != owner)
+                    neighbour[index] = SHARED;
+                else if (owner && !neighbour[index])
+                    neighbour[index] = owner;
+            }
+        }
+    }
+
+    // Opponents are the players owning cells, in the order of firstRoot. Their frontier cells are sorted by opponent,
+    // those of opponent k from frontierStarts[k] to frontierStarts[k + 1], in row order.
+    const Player *lastOwner = nullptr;
+    size_t lastIndex = 0;
+    auto opponentIndex = [&](const Player *owner) {
+        if (owner != lastOwner) {
+            lastOwner = owner;
+            lastIndex = static_cast<size_t>(std::find_if(firstRoot.begin(), firstRoot.end(), [&](const auto &entry) { return entry.first == owner; })
+                                            - firstRoot.begin());
+        }
+        return lastIndex;
+    };
+    auto onFrontier = [&](size_t index) { return bFree[index] && neighbour[index] && neighbour[index] != SHARED; };
+    std::span<size_t> frontierStarts = scratch.take<size_t>(firstRoot.size() + 1, 0);
+    for (size_t index = 0; index < size * size; ++index)
+        if (onFrontier(index))
+            ++frontierStarts[opponentIndex(neighbour[index]) + 1];
+    for (size_t k = 0; k < firstRoot.size(); ++k)
+        frontierStarts[k + 1] += frontierStarts[k];
+    std::span<uint32_t> frontiers = scratch.take<uint32_t>(frontierStarts.back());
+    std::span<size_t> nbSorted = scratch.take<size_t>(firstRoot.size(), 0);
+    for (size_t index = 0; index < size * size; ++index) {
+        if (onFrontier(index)) {
+            size_t k = opponentIndex(neighbour[index]);
+            frontiers[frontierStarts[k] + nbSorted[k]++] = static_cast<uint32_t>(index);
+        }
+    }
+
+    // A stone only removes the placements covering it
+    std::span<uint32_t> seen = scratch.take<uint32_t>(size * size, 0); // Anchors already tried for the current shape
+    uint32_t generation = 0;
+    for (size_t k = 0; k < firstRoot.size(); ++k) {
+        const Player *opponent = firstRoot.begin()[static_cast<std::ptrdiff_t>(k)].first;
+        if (opponent == &player)
+            continue;
+        auto allowed = [&](size_t index) { return bFree[index] && (!neighbour[index] || neighbour[index] == opponent); };
+
+        std::span<const uint32_t> frontier = frontiers.subspan(frontierStarts[k], frontierStarts[k + 1] - frontierStarts[k]);
+        for (size_t s = 0; s < nbShapes; ++s) {
+            std::span<const std::pair<size_t, size_t>> shape = shapeCells.subspan(shapeStarts[s], shapeStarts[s + 1] - shapeStarts[s]);
+            ++generation;
+            for (uint32_t start : frontier) {
+                size_t startX = start / size, startY = start % size;
+                for (auto [i, j] : shape) {
+                    if (startX < i || startY < j || seen[(startX - i) * size + startY - j] == generation)
+                        continue;
+                    size_t anchorX = startX - i, anchorY = startY - j;
+                    seen[anchorX * size + anchorY] = generation;
+
+                    bool bLegal = true;
+                    for (auto [k, l] : shape)
+                        bLegal = bLegal && anchorX + k < size && anchorY + l < size && allowed((anchorX + k) * size + anchorY + l);
+                    if (!bLegal)
+                        continue;
+
+                    for (auto [k, l] : shape)
+                        if (cells[(anchorX + k) * size + anchorY + l].type == EMPTY)
+                            ++placements[(anchorX + k) * size + anchorY + l];
                 }
             }
         }
+        addPotentialLoss(*opponent, squareLoss);
+    }
+
+    impactsBuffer.clear();
+    for (size_t index = 0; index < size * size; ++index)
+        if (cells[index].type == EMPTY)
+            impactsBuffer.push_back({{index / size, index % size}, placements[index], squareLoss[index]});
+    return impactsBuffer;
+}
+
+std::optional<Tile> Board::stealTile(std::pair<size_t, size_t> target, Player *newOwner) {
+    if (target.first >= size || target.second >= size)
+        return std::nullopt;
+
+    // Tile covering the target, it must be an enemy tile that can be stolen
+    uint32_t index = tileAt[target.first * size + target.second];
+    if (index == 0)
+        return std::nullopt;
+
+    auto it = placedTiles.begin() + (index - 1);
+    if (!it->bStealable || it->owner == newOwner)
+        return std::nullopt;
+
+    const Shape &shape = it->tile.getShape();
+    size_t posX = it->coords.first;
+    size_t posY = it->coords.second;
+
+    // Remove stolen tile from the board
+    Arena::Scope scope(scratch);
+    std::span<std::pair<size_t, size_t>> removed = scratch.take<std::pair<size_t, size_t>>(shape.size() * shape[0].size());
+    size_t nbRemoved = 0;
+    for (size_t i = 0; i < shape.size(); ++i) {
+        for (size_t j = 0; j < shape[i].size(); ++j) {
+            if (!shape[i][j])
+                continue;
+
+            removed[nbRemoved++] = {posX + i, posY + j};
+            Cell &cell = getCell({posX + i, posY + j});
+            setType({posX + i, posY + j}, EMPTY);
+            cell.owner = nullptr;
+            cell.printSymbol = "";
+            tileAt[(posX + i) * size + posY + j] = 0;
+        }
+    }
+
+    removed = removed.first(nbRemoved);
+    splitTerritory(removed, it->owner);
+    markBonusesAround({posX, posY}, {posX + shape.size() - 1, posY + shape[0].size() - 1});
+    squares.erase(it->owner);
+    removeStealable(index - 1);
+    Tile stolenTile = it->tile;
+    const Player *victim = it->owner;
+
+    // The last placed tile takes the place of the stolen one, only its cells and stealable entry change
+    size_t last = placedTiles.size() - 1;
+    if (index - 1 != last) {
+        placedTiles[index - 1] = placedTiles[last];
+        stealablePosition[index - 1] = stealablePosition[last];
+        if (stealablePosition[index - 1] != NOT_STEALABLE)
+            stealable[stealablePosition[index - 1]] = index - 1;
+        indexTile(index - 1);
+    }
+    placedTiles.pop_back();
+    stealablePosition.pop_back();
+
+    if (!listeners.empty())
+        emit(TileStolen{victim, newOwner, stolenTile, removed});
+    return stolenTile;
+}
+
+std::pair<size_t, size_t> Board::cellOfType(CellType type, size_t i) const {
+    uint32_t cell = census.at(type, i);
+    return {cell / size, cell % size};
+}
+
+std::optional<std::pair<size_t, size_t>> Board::sampleCell(CellType type, std::mt19937 &gen) const {
+    if (census.count(type) == 0)
+        return std::nullopt;
+    return cellOfType(type, std::uniform_int_distribution<size_t>(0, census.count(type) - 1)(gen));
+}
+
+size_t Board::countStealable(const Player &thief) const {
+    const size_t *own = stealableCounts.find(&thief);
+    return stealable.size() - (own ? *own : 0);
+}
+
+std::optional<std::pair<size_t, size_t>> Board::sampleStealable(const Player &thief, std::mt19937 &gen) const {
+    size_t count = countStealable(thief);
+    if (count == 0)
+        return std::nullopt;
+
+    // A few random picks among all stealable tiles almost always find another player's tile,
+    // the list is only walked when the thief owns most of them
+    std::uniform_int_distribution<size_t> dist(0, stealable.size() - 1);
+    const PlacedTile *chosen = nullptr;
+    for (size_t attempt = 0; attempt < 8 && !chosen; ++attempt) {
+        const PlacedTile &candidate = placedTiles[stealable[dist(gen)]];
+        if (candidate.owner != &thief)
+            chosen = &candidate;
+    }
+    if (!chosen) {
+        size_t k = std::uniform_int_distribution<size_t>(0, count - 1)(gen);
+        for (uint32_t index : stealable) {
+            if (placedTiles[index].owner != &thief && k-- == 0) {
+                chosen = &placedTiles[index];
+                break;
+            }
+        }
     }
 
-    // No tile found there
-    return std::nullopt;
+    // A cell the tile covers, its anchor may be an empty corner of its shape
+    const Shape &shape = chosen->tile.getShape();
+    for (size_t i = 0; i < shape.size(); ++i)
+        for (size_t j = 0; j < shape[i].size(); ++j)
+            if (shape[i][j])
+                return std::make_pair(chosen->coords.first + i, chosen->coords.second + j);
+    return chosen->coords;
 }
 
 // Display the board in the terminal.
 void Board::display() const {
     std::vector<std::string> labels;
+    std::vector<std::string> rowLabels;
+    size_t labelWidth = 2; // Full-width letters take two columns
+
+    // Past 52 rows there are no letters left, rows are numbered and columns show the last two digits
+    if (size > 52) {
+        labelWidth = std::to_string(size - 1).size();
+        for (size_t i = 0; i < size; ++i) {
+            std::string column = std::to_string(i % 100);
+            labels.push_back(std::string(2 - column.size(), '0') + column);
+            std::string row = std::to_string(i);
+            rowLabels.push_back(std::string(labelWidth - row.size(), ' ') + row);
+        }
+    }
 
-    for (size_t i = 0; i < size; ++i) {
+    for (size_t i = 0; i < size && size <= 52; ++i) {
         char32_t ch;
         if (i < 26)
             ch = 0xFF21 + i; // "Ａ" to "Ｚ"
@@ -320,24 +1602,27 @@ void Board::display() const {
         }
         labels.push_back(utf8);
     }
+    if (rowLabels.empty())
+        rowLabels = labels;
+    std::string margin(labelWidth + 3, ' ');
 
     // First row
-    std::cout << "     ";
+    std::cout << margin;
     for (const auto &label : labels)
         std::cout << label;
     std::cout << std::endl;
 
     // Separator row
-    std::cout << "   +-";
+    std::cout << std::string(labelWidth + 1, ' ') << "+-";
     for (size_t i = 0; i < size; ++i) 
         std::cout << "--";
     std::cout << "-+";
     std::cout << std::endl;
 
     for (size_t x = 0; x < size; ++x) {
-        std::cout << labels[x] << " | ";
+        std::cout << rowLabels[x] << " | ";
         for (size_t y = 0; y < size; ++y) {
-            const Cell &cell = grid[x][y];
+            const Cell &cell = getCell({x, y});
 
             switch (cell.type) {
             case EMPTY:
@@ -366,19 +1651,19 @@ void Board::display() const {
                 break;
             }
         }
-        std::cout << " | " << labels[x];
+        std::cout << " | " << rowLabels[x];
         std::cout << std::endl;
     }
 
     // Separator row
-    std::cout << "   +-";
+    std::cout << std::string(labelWidth + 1, ' ') << "+-";
     for (size_t i = 0; i < size; ++i) 
         std::cout << "--";
     std::cout << "-+";
     std::cout << std::endl;
 
     // Last row
-    std::cout << "     ";
+    std::cout << margin;
     for (const auto &label : labels)
         std::cout << label;
 
@@ -0,0 +1,321 @@
+#include "bot.hpp"
+#include "endgame.hpp"
+#include "game.hpp"
+#include "opening_book.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <limits>
+#include <string>
+
+// Every distinct orientation of a tile, starting with its current one, as given by Tile::getOrientation(). Returns their number.
+static size_t orientations(const Tile &tile, std::array<uint8_t, 8> &codes) {
+    size_t nbCodes = 0;
+
+    Tile oriented = tile;
+    for (int flip = 0; flip < 2; ++flip) {
+        for (int rotation = 0; rotation < 4; ++rotation) {
+            const Shape &shape = oriented.getShape();
+            auto sameShape = [&](uint8_t code) { return Tile::fromId(tile.getId(), code).getShape() == shape; };
+            if (std::none_of(codes.begin(), codes.begin() + nbCodes, sameShape))
+                codes[nbCodes++] = oriented.getOrientation();
+            oriented.rotateClockwise();
+        }
+        oriented.flipHorizontal();
+    }
+    return nbCodes;
+}
+
+static bool isBonus(CellType type) {
+    return type == BONUS_EXCHANGE || type == BONUS_STONE || type == BONUS_ROBBERY;
+}
+
+double Bot::evaluate(const Board &board, const Shape &shape, std::pair<size_t, size_t> coords, const Player &player) const {
+    const std::array<std::pair<int,int>,4> directions = {{{-1,0}, {1,0}, {0,-1}, {0,1}}};
+    const int size = static_cast<int>(board.getSize());
+
+    auto covers = [&](int x, int y) {
+        int i = x - static_cast<int>(coords.first);
+        int j = y - static_cast<int>(coords.second);
+        return i >= 0 && j >= 0 && i < static_cast<int>(shape.size()) && j < static_cast<int>(shape[0].size())
+               && shape[i][j];
+    };
+
+    double cells = 0, potential = 0, frontier = 0, bonus = 0, blocking = 0;
+
+    for (size_t i = 0; i < shape.size(); ++i) {
+        for (size_t j = 0; j < shape[i].size(); ++j) {
+            if (!shape[i][j])
+                continue;
+
+            int x = static_cast<int>(coords.first + i);
+            int y = static_cast<int>(coords.second + j);
+            ++cells;
+
+            // Own cells all around
+            for (int dx = -1; dx <= 1; ++dx) {
+                for (int dy = -1; dy <= 1; ++dy) {
+                    int newX = x + dx;
+                    int newY = y + dy;
+                    if (newX < 0 || newY < 0 || newX >= size || newY >= size)
+                        continue;
+                    if (board.getCell({newX, newY}).owner == &player)
+                        ++potential;
+                }
+            }
+
+            // Room to grow and bonuses to surround
+            for (const auto &dir : directions) {
+                int newX = x + dir.first;
+                int newY = y + dir.second;
+                if (newX < 0 || newY < 0 || newX >= size || newY >= size || covers(newX, newY))
+                    continue;
+
+                CellType type = board.getCell({newX, newY}).type;
+                if (type == EMPTY)
+                    ++frontier;
+                else if (isBonus(type))
+                    ++bonus;
+            }
+
+            // Contested cells, close to another territory
+            bool bContested = false;
+            for (int dx = -2; dx <= 2 && !bContested; ++dx) {
+                for (int dy = -2; dy <= 2; ++dy) {
+                    int newX = x + dx;
+                    int newY = y + dy;
+                    if (newX < 0 || newY < 0 || newX >= size || newY >= size)
+                        continue;
+
+                    const Player *owner = board.getCell({newX, newY}).owner;
+                    if (owner && owner != &player) {
+                        bContested = true;
+                        break;
+                    }
+                }
+            }
+            if (bContested)
+                ++blocking;
+        }
+    }
+
+    return cells
+           + weights.squarePotential * potential
+           + weights.frontier * frontier
+           + weights.bonusProximity * bonus
+           + weights.blocking * blocking;
+}
+
+std::optional<Placement> Bot::bestPlacement(const Board &board, const Tile &tile, const Player &player, bool bAnyOrientation,
+                                            const Deadline &deadline) const {
+    std::optional<Placement> best;
+    size_t nbEvaluated = 0;
+
+    std::array<uint8_t, 8> codes = {tile.getOrientation()};
+    size_t nbCodes = bAnyOrientation ? orientations(tile, codes) : 1;
+    for (uint8_t code : std::span(codes).first(nbCodes)) {
+        Tile candidate = Tile::fromId(tile.getId(), code);
+        const Shape &shape = candidate.getShape();
+
+        for (std::pair<size_t, size_t> anchor : board.searchAnchors(shape, player)) {
+            // The clock is only read every 16 placements, and once one was found
+            if (best && ++nbEvaluated % 16 == 0 && deadline.passed())
+                return best;
+
+            double score = evaluate(board, shape, anchor, player);
+            if (!best || score > best->score)
+                best = Placement{candidate, anchor, score};
+        }
+    }
+
+    return best;
+}
+
+std::pair<size_t, size_t> Bot::chooseStartingLocation(const Board &board, const Player &player) const {
+    const int size = static_cast<int>(board.getSize());
+    Tile startingTile = Tile::fromId(STARTING_TILE_ID);
+
+    const std::array<CellType, 3> bonusTypes = {BONUS_EXCHANGE, BONUS_STONE, BONUS_ROBBERY};
+
+    std::pair<size_t, size_t> best = {0, 0};
+    double bestScore = -std::numeric_limits<double>::infinity();
+
+    for (int x = 0; x < size; ++x) {
+        for (int y = 0; y < size; ++y) {
+            if (!board.canPlaceTile({x, y}, startingTile, player, true))
+                continue;
+
+            // Stay away from edges and opponents, close to bonuses
+            int edge = std::min({x, y, size - 1 - x, size - 1 - y});
+            int distance = size;
+            for (size_t i = 0; i < board.countCells(GRASS); ++i) {
+                std::pair<size_t, size_t> o = board.cellOfType(GRASS, i);
+                const Player *owner = board.getCell(o).owner;
+                if (owner && owner != &player)
+                    distance = std::min(distance, std::max(std::abs(static_cast<int>(o.first) - x), std::abs(static_cast<int>(o.second) - y)));
+            }
+            int nearBonuses = 0;
+            for (CellType type : bonusTypes) {
+                for (size_t i = 0; i < board.countCells(type); ++i) {
+                    std::pair<size_t, size_t> b = board.cellOfType(type, i);
+                    if (std::abs(static_cast<int>(b.first) - x) + std::abs(static_cast<int>(b.second) - y) <= 3)
+                        ++nearBonuses;
+                }
+            }
+
+            double score = std::min(edge, 4) + std::min(distance, 6) + 2 * weights.bonusProximity * nearBonuses;
+            if (score > bestScore) {
+                bestScore = score;
+                best = {static_cast<size_t>(x), static_cast<size_t>(y)};
+            }
+        }
+    }
+
+    return best;
+}
+
+std::pair<size_t, size_t> Bot::chooseStoneLocation(const Board &board, const Player &player, std::span<const Tile> tiles) const {
+    const size_t size = board.getSize();
+    std::optional<StoneImpact> best;
+    std::optional<StoneImpact> bestNearby; // Next to the player's own territory, only used if nothing else is left
+
+    // Cell taking the most square potential from opponents, then the most of their placements
+    auto better = [](const StoneImpact &impact, const std::optional<StoneImpact> &current) {
+        return !current || std::make_pair(impact.squareLoss, impact.placements) > std::make_pair(current->squareLoss, current->placements);
+    };
+
+    for (const StoneImpact &impact : board.stoneImpacts(player, tiles)) {
+        bool bNearby = false;
+        for (size_t x = impact.coords.first > 0 ? impact.coords.first - 1 : 0; x <= std::min(size - 1, impact.coords.first + 1); ++x)
+            for (size_t y = impact.coords.second > 0 ? impact.coords.second - 1 : 0; y <= std::min(size - 1, impact.coords.second + 1); ++y)
+                bNearby = bNearby || board.getCell({x, y}).owner == &player;
+
+        std::optional<StoneImpact> &current = bNearby ? bestNearby : best;
+        if (better(impact, current))
+            current = impact;
+    }
+
+    if (best)
+        return best->coords;
+    return bestNearby ? bestNearby->coords : std::pair<size_t, size_t>{0, 0};
+}
+
+std::pair<size_t, size_t> Bot::chooseRobberyTarget(const Board &board, const Player &player) const {
+    std::pair<size_t, size_t> best = {0, 0};
+    std::pair<size_t, size_t> bestValue = {0, 0};
+
+    // Tile that shrinks its owner's largest square the most, then the largest one
+    for (const RobberyDelta &delta : board.robberyDeltas(player)) {
+        std::pair<size_t, size_t> value = {delta.squareBefore - delta.squareAfter, delta.cells};
+        if (value > bestValue) {
+            bestValue = value;
+            best = delta.target;
+        }
+    }
+
+    return best;
+}
+
+int Bot::chooseExchange(const Game &game, const Player &player, const Deadline &deadline) const {
+    const Board &board = game.getBoard();
+    const double margin = 2.0; // Coupons are worth a 1x1 tile at the end of the game
+
+    std::optional<Placement> current = bestPlacement(board, *game.getCurrentTile(), player, true, deadline);
+    double bestScore = current ? current->score + margin : -std::numeric_limits<double>::infinity();
+    int bestIndex = 0;
+
+    // Out of time, the tile in hand is kept
+    auto nextTiles = game.getTileQueue().nextTiles();
+    for (size_t i = 0; i < nextTiles.size() && !deadline.passed(); ++i) {
+        std::optional<Placement> candidate = bestPlacement(board, nextTiles[i], player, true, deadline);
+        if (candidate && candidate->score > bestScore) {
+            bestScore = candidate->score;
+            bestIndex = static_cast<int>(i) + 1;
+        }
+    }
+
+    return bestIndex;
+}
+
+Decision Bot::decide(const Game &game, const Deadline &deadline) const {
+    const PendingDecision &pending = game.pendingDecision();
+    Decision decision{pending.type};
+
+    if (pending.type == CHOOSE_NAME) {
+        decision.text = "Bot " + std::to_string(pending.playerIndex + 1);
+        return decision;
+    }
+    if (pending.type == CHOOSE_COLOR) {
+        decision.choice = 1;
+        return decision;
+    }
+    if (pending.type == GAME_OVER)
+        return decision;
+
+    const Board &board = game.getBoard();
+    const Player &player = game.getPlayers()[pending.playerIndex];
+
+    switch (pending.type) {
+    case PLACE_STARTING_TILE:
+        if (std::optional<std::pair<size_t, size_t>> coords = book ? book->lookup(board, player) : std::nullopt)
+            decision.coords = *coords;
+        else
+            decision.coords = chooseStartingLocation(board, player);
+        break;
+    case TAKE_OR_EXCHANGE:
+        decision.choice = chooseExchange(game, player, deadline) > 0 ? 2 : 1;
+        break;
+    case EXCHANGE_KIND:
+        decision.choice = chooseExchange(game, player, deadline) > 0 ? 1 : 0;
+        break;
+    case EXCHANGE_TILE:
+        decision.choice = chooseExchange(game, player, deadline);
+        break;
+    case REMOVE_STONE:
+        if (board.countCells(STONE) > 0)
+            decision.coords = board.cellOfType(STONE, 0);
+        break;
+    case ORIENT_TILE: {
+        // Rotate and flip until the tile matches the best orientation
+        const Tile &tile = *game.getCurrentTile();
+        std::optional<Placement> best = bestPlacement(board, tile, player, true, deadline);
+
+        if (best && best->tile.isFlipped() != tile.isFlipped())
+            decision.choice = 3;
+        else if (best && best->tile.getRotation() != tile.getRotation())
+            decision.choice = 2;
+        else
+            decision.choice = 1;
+        break;
+    }
+    case PLACE_TILE: {
+        std::optional<Placement> best = bestPlacement(board, *game.getCurrentTile(), player, false, deadline);
+        if (best)
+            decision.coords = best->coords;
+        break;
+    }
+    case PLACE_STONE:
+        decision.coords = chooseStoneLocation(board, player, game.getTileQueue().nextTiles());
+        break;
+    case ROB_TILE:
+        decision.coords = chooseRobberyTarget(board, player);
+        break;
+    case PLACE_COUPON_TILE: {
+        // The last coupons decide the final square, so they are searched to the end when the search is small enough
+        Arena::Scope scope(board.getScratch());
+        CouponPlan plan = solveCoupons(board, player, player.getCoupons(), couponNodes, deadline);
+        if (!plan.placements.empty()) {
+            decision.coords = plan.placements.front();
+            break;
+        }
+        std::optional<Placement> best = bestPlacement(board, Tile::fromId(STARTING_TILE_ID), player, false, deadline);
+        if (best)
+            decision.coords = best->coords;
+        break;
+    }
+    default:
+        break;
+    }
+
+    return decision;
+}
@@ -0,0 +1,307 @@
+#include "endgame.hpp"
+#include <algorithm>
+#include <array>
+
+namespace {
+
+enum CouponCell : uint8_t { BLOCKED, OPEN, OWN };
+
+// Sets of placed cells already searched are remembered by a hash, in a table of fixed size. Once it is 3/4 full
+// new sets are not remembered : they may be searched again, which costs time but gives the same placements.
+const size_t SEEN_SLOTS = 32768;
+const size_t MAX_SEEN = SEEN_SLOTS / 4 * 3;
+
+// Key of a placed cell, the key of a set is the xor of its cells' keys whatever their order (splitmix64).
+uint64_t cellKey(size_t cell) {
+    uint64_t z = static_cast<uint64_t>(cell) + 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+/**
+Search state, on a window holding the whole territory and every cell the coupons can reach.
+Cells are indexed in the window, in row order.
+*/
+struct CouponSearch {
+    Arena &arena;
+    size_t x0, y0, height, width;
+    std::span<uint8_t> kind;             // CouponCell
+    std::span<CellType> type;            // Board type of open cells
+    std::span<uint8_t> bCapturedBonus;   // Own cells shown as a captured bonus, not counted as grass
+    std::span<size_t> placed;            // Cells placed so far, in order
+    size_t nbPlaced = 0;
+    uint64_t placedKey = 0;              // Key of the set of placed cells
+    std::span<uint64_t> seen;            // Keys of the sets of placed cells already searched, 0 for free slots
+    size_t nbSeen = 0;
+    std::span<size_t> captured;          // Bonuses captured by the placed cells, in order
+    size_t nbCaptured = 0;
+    std::span<std::pair<size_t, size_t>> bestPlacements;
+    size_t nbExchanges = 0;              // Open exchange bonuses, each may give one more coupon
+    size_t maxNodes;
+    Deadline deadline;
+    CouponPlan best;
+    bool bFound = false;
+
+    explicit CouponSearch(Arena &arena) : arena(arena) {}
+
+    std::array<int, 4> neighbours() const { return {-static_cast<int>(width), static_cast<int>(width), -1, 1}; }
+
+    bool inside(size_t cell, int offset) const {
+        size_t i = cell / width, j = cell % width;
+        if (offset == -1)
+            return j > 0;
+        if (offset == 1)
+            return j + 1 < width;
+        return offset < 0 ? i > 0 : i + 1 < height;
+    }
+
+    // Largest square of own cells, the first one in row order, and the grass counted by Game::determineWinner() :
+    // cells of the square, but for its last row and column, that are not captured bonuses.
+    std::pair<size_t, size_t> score() const {
+        Arena::Scope scope(arena);
+        std::span<size_t> previous = arena.take<size_t>(width, 0), current = arena.take<size_t>(width, 0);
+        size_t side = 0, cornerX = 0, cornerY = 0;
+        for (size_t i = 0; i < height; ++i) {
+            for (size_t j = 0; j < width; ++j) {
+                if (kind[i * width + j] != OWN)
+                    current[j] = 0;
+                else
+                    current[j] = i == 0 || j == 0 ? 1 : 1 + std::min({previous[j], current[j - 1], previous[j - 1]});
+                if (current[j] > side) {
+                    side = current[j];
+                    cornerX = i;
+                    cornerY = j;
+                }
+            }
+            std::swap(previous, current);
+        }
+
+        size_t grass = 0;
+        for (size_t i = cornerX + 1 - side; i < cornerX; ++i)
+            for (size_t j = cornerY + 1 - side; j < cornerY; ++j)
+                grass += !bCapturedBonus[i * width + j];
+        return {side, grass};
+    }
+
+    // Whether a square of the given side could still be completed : all of its cells own or open,
+    // and at most budget open cells to cover, bonuses being counted as captured for free.
+    bool reachable(size_t side, size_t budget) const {
+        if (side == 0)
+            return true;
+        if (side > height || side > width)
+            return false;
+
+        Arena::Scope scope(arena);
+        std::span<size_t> blocked = arena.take<size_t>((height + 1) * (width + 1), 0);
+        std::span<size_t> missing = arena.take<size_t>((height + 1) * (width + 1), 0);
+        for (size_t i = 0; i < height; ++i) {
+            for (size_t j = 0; j < width; ++j) {
+                size_t k = i * width + j;
+                size_t here = (i + 1) * (width + 1) + j + 1;
+                bool bMissing = kind[k] == OPEN && type[k] == EMPTY;
+                blocked[here] = (kind[k] == BLOCKED) + blocked[here - 1] + blocked[here - width - 1] - blocked[here - width - 2];
+                missing[here] = bMissing + missing[here - 1] + missing[here - width - 1] - missing[here - width - 2];
+            }
+        }
+        auto sum = [&](std::span<const size_t> table, size_t i, size_t j) {
+            return table[(i + side) * (width + 1) + j + side] - table[i * (width + 1) + j + side] - table[(i + side) * (width + 1) + j]
+                   + table[i * (width + 1) + j];
+        };
+
+        for (size_t i = 0; i + side <= height; ++i)
+            for (size_t j = 0; j + side <= width; ++j)
+                if (sum(blocked, i, j) == 0 && sum(missing, i, j) <= budget)
+                    return true;
+        return false;
+    }
+
+    // Own the cell and capture the bonuses it surrounds, returns the coupons gained. Captured cells are pushed on captured.
+    size_t place(size_t cell) {
+        kind[cell] = OWN;
+        bCapturedBonus[cell] = false; // A tile on a bonus cell covers it
+        placed[nbPlaced++] = cell;
+        placedKey ^= cellKey(cell);
+        size_t gained = 0;
+
+        for (int offset : neighbours()) {
+            if (!inside(cell, offset))
+                continue;
+            size_t bonus = cell + offset;
+            if (kind[bonus] != OPEN || type[bonus] == EMPTY)
+                continue;
+
+            bool bSurrounded = true;
+            for (int around : neighbours())
+                bSurrounded = bSurrounded && inside(bonus, around) && kind[bonus + around] == OWN;
+            if (!bSurrounded)
+                continue;
+
+            kind[bonus] = OWN;
+            bCapturedBonus[bonus] = true;
+            captured[nbCaptured++] = bonus;
+            if (type[bonus] == BONUS_EXCHANGE) {
+                ++gained;
+                --nbExchanges;
+            }
+        }
+        return gained;
+    }
+
+    // Gives back the last placed cell, and the bonuses captured since there were firstCaptured of them.
+    void undo(size_t firstCaptured) {
+        for (; nbCaptured > firstCaptured; --nbCaptured) {
+            size_t bonus = captured[nbCaptured - 1];
+            kind[bonus] = OPEN;
+            bCapturedBonus[bonus] = false;
+            if (type[bonus] == BONUS_EXCHANGE)
+                ++nbExchanges;
+        }
+        size_t cell = placed[--nbPlaced];
+        placedKey ^= cellKey(cell);
+        kind[cell] = OPEN;
+    }
+
+    // Free cell next to the territory, where a 1x1 tile is legal
+    bool isCandidate(size_t cell) const {
+        if (kind[cell] != OPEN)
+            return false;
+        for (int offset : neighbours())
+            if (inside(cell, offset) && kind[cell + offset] == OWN)
+                return true;
+        return false;
+    }
+
+    // False if the set of placed cells was already searched.
+    bool remember() {
+        uint64_t key = placedKey ? placedKey : 1;
+        size_t slot = key % SEEN_SLOTS;
+        for (; seen[slot] != 0; slot = (slot + 1) % SEEN_SLOTS)
+            if (seen[slot] == key)
+                return false;
+        if (nbSeen < MAX_SEEN) {
+            seen[slot] = key;
+            ++nbSeen;
+        }
+        return true;
+    }
+
+    void search(size_t coupons) {
+        // The clock is only read every 256 positions, once passed the search unwinds as it does at maxNodes
+        if (best.nodes >= maxNodes || (best.nodes % 256 == 255 && deadline.passed())) {
+            maxNodes = best.nodes;
+            best.bOptimal = false;
+            return;
+        }
+        ++best.nodes;
+
+        // Coupons left without room are lost, the game ends here
+        bool bCandidates = false;
+        for (size_t k = 0; k < kind.size() && coupons > 0 && !bCandidates; ++k)
+            bCandidates = isCandidate(k);
+        if (!bCandidates) {
+            std::pair<size_t, size_t> result = score();
+            if (!bFound || result > std::make_pair(best.square, best.grass)) {
+                bFound = true;
+                best.square = result.first;
+                best.grass = result.second;
+                for (size_t i = 0; i < nbPlaced; ++i)
+                    bestPlacements[i] = {x0 + placed[i] / width, y0 + placed[i] % width};
+                best.placements = bestPlacements.first(nbPlaced);
+            }
+            return;
+        }
+
+        // The same cells placed in another order give the same position
+        if (!remember())
+            return;
+
+        // Nothing within reach beats the best placements found
+        if (bFound) {
+            size_t budget = coupons + nbExchanges;
+            if (!reachable(best.square + 1, budget)
+                && (!reachable(best.square, budget) || (best.square - 1) * (best.square - 1) <= best.grass))
+                return;
+        }
+
+        // Candidates are found again after each branch, which leaves the cells as they were
+        for (size_t cell = 0; cell < kind.size(); ++cell) {
+            if (!isCandidate(cell))
+                continue;
+            size_t firstCaptured = nbCaptured;
+            size_t gained = place(cell);
+            search(coupons - 1 + gained);
+            undo(firstCaptured);
+        }
+    }
+};
+
+} // namespace
+
+CouponPlan solveCoupons(const Board &board, const Player &player, size_t coupons, size_t maxNodes, const Deadline &deadline) {
+    Component box = board.territory(player);
+    if (box.area == 0)
+        return {};
+
+    // Each placement reaches one cell further, and each exchange bonus may give one more placement
+    const size_t size = board.getSize();
+    size_t reach = coupons + board.countCells(BONUS_EXCHANGE) + 1;
+    Arena &arena = board.getScratch();
+    CouponSearch search(arena);
+    search.x0 = box.topLeft.first > reach ? box.topLeft.first - reach : 0;
+    search.y0 = box.topLeft.second > reach ? box.topLeft.second - reach : 0;
+    search.height = std::min(size, box.bottomRight.first + reach + 1) - search.x0;
+    search.width = std::min(size, box.bottomRight.second + reach + 1) - search.y0;
+
+    // Every placement and capture turns an open cell into an own one, the window bounds them
+    const size_t nbCells = search.height * search.width;
+    search.bestPlacements = arena.take<std::pair<size_t, size_t>>(nbCells);
+    Arena::Scope scope(arena);
+    search.kind = arena.take<uint8_t>(nbCells, BLOCKED);
+    search.type = arena.take<CellType>(nbCells, EMPTY);
+    search.bCapturedBonus = arena.take<uint8_t>(nbCells, 0);
+    search.placed = arena.take<size_t>(nbCells);
+    search.captured = arena.take<size_t>(nbCells);
+    search.seen = arena.take<uint64_t>(SEEN_SLOTS, 0);
+    search.maxNodes = maxNodes;
+    search.deadline = deadline;
+
+    const std::array<std::pair<int,int>,4> directions = {{{-1,0}, {1,0}, {0,-1}, {0,1}}};
+    for (size_t i = 0; i < search.height; ++i) {
+        for (size_t j = 0; j < search.width; ++j) {
+            size_t x = search.x0 + i, y = search.y0 + j, k = i * search.width + j;
+            const Cell &cell = board.getCell({x, y});
+            if (cell.owner == &player) {
+                search.kind[k] = OWN;
+                search.bCapturedBonus[k] = cell.printSymbol == "Ｅ" || cell.printSymbol == "Ｓ" || cell.printSymbol == "Ｒ";
+                continue;
+            }
+            if (cell.type == GRASS || cell.type == STONE)
+                continue;
+
+            // Cells next to another player can never be covered, nor surrounded
+            bool bOpen = true;
+            for (const auto &dir : directions) {
+                size_t newX = x + dir.first, newY = y + dir.second;
+                if (newX < size && newY < size && board.getCell({newX, newY}).owner && board.getCell({newX, newY}).owner != &player)
+                    bOpen = false;
+            }
+            if (!bOpen)
+                continue;
+
+            search.kind[k] = OPEN;
+            search.type[k] = cell.type;
+            search.nbExchanges += cell.type == BONUS_EXCHANGE;
+        }
+    }
+
+    search.search(coupons);
+    return search.best;
+}
+
+size_t couponSearchBytes(size_t boardSize) {
+    // The tables above on a window of the whole board, and the two of reachable()
+    size_t nbCells = boardSize * boardSize;
+    return SEEN_SLOTS * sizeof(uint64_t) + nbCells * (2 * sizeof(size_t) + 2 * sizeof(size_t) + sizeof(CellType) + 2)
+           + 2 * (boardSize + 1) * (boardSize + 1) * sizeof(size_t);
+}
@@ -0,0 +1,172 @@
+#include "feed.hpp"
+#include "game.hpp"
+#include <algorithm>
+
+size_t cellCodeWidth(size_t nbPlayers) {
+    return nbPlayers <= 26 ? 1 : 2;
+}
+
+void appendCellCode(std::string &out, const Cell &cell, const Game &game) {
+    bool bWide = cellCodeWidth(game.getNbPlayers()) == 2;
+
+    char code;
+    switch (cell.type) {
+        case EMPTY: code = '.'; break;
+        case STONE: code = '#'; break;
+        case BONUS_EXCHANGE: code = 'E'; break;
+        case BONUS_STONE: code = 'S'; break;
+        case BONUS_ROBBERY: code = 'R'; break;
+        case GRASS: {
+            size_t seat = static_cast<size_t>(cell.owner - game.getPlayers().data());
+            if (bWide)
+                out += static_cast<char>('a' + seat / 26);
+            out += static_cast<char>('a' + seat % 26);
+            return;
+        }
+        default: code = '?'; break;
+    }
+
+    // Other cells repeat their character to keep the width
+    out += code;
+    if (bWide)
+        out += code;
+}
+
+char symbolCode(const Cell &cell) {
+    if (cell.type != GRASS)
+        return '.';
+    if (cell.printSymbol == "Ｅ")
+        return 'e';
+    if (cell.printSymbol == "Ｓ")
+        return 's';
+    if (cell.printSymbol == "Ｒ")
+        return 'r';
+
+    auto it = std::find(TILE_SYMBOLS.begin(), TILE_SYMBOLS.end(), cell.printSymbol);
+    return it == TILE_SYMBOLS.end() ? '.' : static_cast<char>('A' + (it - TILE_SYMBOLS.begin()));
+}
+
+SpectatorFeed::SpectatorFeed(uint32_t table, Game &game) : table(table), game(game) {
+    size_t size = game.getBoard().getSize();
+    bChanged.assign(size * size, false);
+    keyframe = encodeKeyframe();
+    game.attachBoardObserver(*this);
+}
+
+SpectatorFeed::~SpectatorFeed() {
+    game.detachBoardObserver(this);
+}
+
+void SpectatorFeed::mark(std::pair<size_t, size_t> coords) {
+    uint32_t cell = static_cast<uint32_t>(coords.first * game.getBoard().getSize() + coords.second);
+    if (bChanged[cell])
+        return;
+    bChanged[cell] = true;
+    changed.push_back(cell);
+}
+
+std::string SpectatorFeed::queueHead() const {
+    std::string queue;
+    for (const Tile &tile : game.getTileQueue().nextTiles()) {
+        if (!queue.empty())
+            queue += '.';
+        queue += std::to_string(tile.getId());
+    }
+    return queue.empty() ? "-" : queue;
+}
+
+std::string SpectatorFeed::counters() const {
+    std::string line;
+    for (const Player &player : game.getPlayers()) {
+        if (!line.empty())
+            line += ',';
+        line += std::to_string(player.getCoupons()) + "." + std::to_string(player.getStoneBonus()) + "."
+                + std::to_string(player.getRobberyBonus());
+    }
+    return line.empty() ? "-" : line;
+}
+
+SharedLine SpectatorFeed::encodeKeyframe() const {
+    const Board &board = game.getBoard();
+    size_t size = board.getSize();
+    std::string cells, symbols;
+    cells.reserve(size * size * cellCodeWidth(game.getNbPlayers()));
+    symbols.reserve(size * size);
+    for (size_t x = 0; x < size; ++x) {
+        for (size_t y = 0; y < size; ++y) {
+            appendCellCode(cells, board.getCell({x, y}), game);
+            symbols.push_back(symbolCode(board.getCell({x, y})));
+        }
+    }
+
+    return std::make_shared<const std::string>("KEY " + std::to_string(table) + " " + std::to_string(sequence) + " " + std::to_string(size) + " "
+                                               + cells + " " + symbols + " " + queueHead() + " " + counters() + "\n");
+}
+
+SharedLine SpectatorFeed::update() {
+    const Board &board = game.getBoard();
+    size_t size = board.getSize();
+
+    std::string line = "DELTA " + std::to_string(table) + " " + std::to_string(++sequence) + " " + queueHead() + " " + counters();
+    for (uint32_t cell : changed) {
+        const Cell &current = board.getCell({cell / size, cell % size});
+        line += " " + std::to_string(cell / size) + "," + std::to_string(cell % size) + ",";
+        appendCellCode(line, current, game);
+        line += symbolCode(current);
+        bChanged[cell] = false;
+    }
+    changed.clear();
+    line += '\n';
+
+    SharedLine delta = std::make_shared<const std::string>(std::move(line));
+    deltas.push_back(delta);
+
+    // Spectators joining later start from here instead of replaying every delta
+    if (deltas.size() >= keyframeInterval) {
+        keyframe = encodeKeyframe();
+        deltas.clear();
+    }
+    return delta;
+}
+
+std::vector<SharedLine> SpectatorFeed::catchUp() const {
+    std::vector<SharedLine> lines{keyframe};
+    lines.insert(lines.end(), deltas.begin(), deltas.end());
+    return lines;
+}
+
+void SpectatorFeed::onCellsCovered(const CellsCovered &event) {
+    for (const auto &coords : event.cells)
+        mark(coords);
+}
+
+void SpectatorFeed::onBonusCaptured(const BonusCaptured &event) {
+    mark(event.coords);
+}
+
+void SpectatorFeed::onStonePlaced(const StonePlaced &event) {
+    mark(event.coords);
+}
+
+void SpectatorFeed::onStoneRemoved(const StoneRemoved &event) {
+    mark(event.coords);
+}
+
+void SpectatorFeed::onTileStolen(const TileStolen &event) {
+    for (const auto &coords : event.cells)
+        mark(coords);
+}
+
+void SpectatorFeed::onCellChanged(const CellChanged &event) {
+    mark(event.coords);
+}
+
+void SpectatorFeed::onBoardReset(const BoardReset &) {
+    // Every cell may have changed, the next update carries a keyframe's worth of cells
+    changed.clear();
+    size_t size = game.getBoard().getSize();
+    for (uint32_t cell = 0; cell < size * size; ++cell) {
+        bChanged[cell] = true;
+        changed.push_back(cell);
+    }
+}
@@ -1,367 +1,802 @@
 #include "game.hpp"
+#include "endgame.hpp"
 #include "utils.hpp"
 #include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <limits>
 #include <optional>
+#include <random>
 #include <set>
-#include <limits>
+#include <stdexcept>
 
-
-Game::Game(size_t nbPlayers)
-    : board(nbPlayers), tileQueue(nbPlayers), nbPlayers(nbPlayers), players(), currentRound(0) {
-    setup();
+static uint64_t randomSeed() {
+    std::random_device rd;
+    return (static_cast<uint64_t>(rd()) << 32) | rd();
 }
 
-void Game::setup() {
-    // Initialize players
-    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+static const std::set<PlayerColor> ALL_COLORS = { PURPLE, RED, GREEN, YELLOW, BLUE, MAGENTA, CYAN, TURQUOISE, ORANGE };
 
-    std::set<PlayerColor> availableColors = { PURPLE, RED, GREEN, YELLOW, BLUE, MAGENTA, CYAN, TURQUOISE, ORANGE };
-    players.reserve(nbPlayers);
+// Player count checked before any member is built from it.
+static size_t checkedPlayers(size_t nbPlayers) {
+    if (nbPlayers < Game::minPlayers || nbPlayers > Game::maxPlayers)
+        throw std::out_of_range("Number of players must be between " + std::to_string(Game::minPlayers) + " and "
+                                + std::to_string(Game::maxPlayers));
+    return nbPlayers;
+}
 
-    for (size_t i = 0; i < nbPlayers; ++i) {
-        clearTerminal();
-        
-        std::string name;
-        std::cout << "Player " << (i + 1) << " - Choose your name: ";
-        std::getline(std::cin, name);
+Game::Game(size_t nbPlayers) : Game(nbPlayers, randomSeed()) {}
 
-        std::cout << std::endl;
+Game::Game(size_t nbPlayers, uint64_t seed) : Game(nbPlayers, seed, Board::defaultSize(nbPlayers)) {}
 
-        std::cout << "Choose your color: " << std::endl;
-        size_t index = 1;
-        for (auto c : availableColors)
-            std::cout << index++ << ". " << colorize(c) << playerColorToString(c) << resetColor << std::endl;
+Game::Game(size_t nbPlayers, uint64_t seed, size_t boardSize)
+    : seed(seed), board(boardSize, checkedPlayers(nbPlayers), seed), tileQueue(nbPlayers, seed), nbPlayers(nbPlayers), players(),
+      currentRound(0) {
+    // Players are referenced by pointer from the board, their storage must never move
+    players.reserve(nbPlayers);
+    availableColors = ALL_COLORS;
 
-        int choiceColor = 0;
-        while (true) {
-            std::cin >> choiceColor;
-            if (choiceColor >= 1 && choiceColor <= static_cast<int>(availableColors.size()))
-                break;
-            std::cout << "Invalid choice. Try again.\n";
-        }
-        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    wait(CHOOSE_NAME);
+}
 
-        auto it = availableColors.begin();
-        std::advance(it, choiceColor - 1);
-        PlayerColor color = *it;
-        availableColors.erase(it);
+// Tile saved in a snapshot, whose shape must exist.
+static Tile savedTile(uint8_t id, uint8_t orientation) {
+    if (id != STARTING_TILE_ID && id >= TILE_SHAPES.size())
+        throw std::runtime_error("Game snapshot has an unknown tile");
+    return Tile::fromId(id, orientation);
+}
+
+// Tiles of the queue saved in a snapshot, in drawing order.
+static std::vector<Tile> restoreQueue(const Snapshot &snapshot) {
+    std::vector<Tile> tiles;
+    const SnapshotTile *queueTiles = snapshot.getQueueTiles();
+    for (size_t i = 0; i < snapshot.getHeader().nbQueueTiles; ++i)
+        tiles.push_back(savedTile(queueTiles[i].id, queueTiles[i].orientation));
+    return tiles;
+}
 
-        players.emplace_back(name, color);
+// Widest range of choices the game offers for a decision, none for decisions taking coordinates or text.
+static std::pair<int, int> choiceRange(DecisionType type, size_t nbColors, size_t nbQueued) {
+    switch (type) {
+    case CHOOSE_COLOR:
+        return {1, static_cast<int>(nbColors)};
+    case TAKE_OR_EXCHANGE:
+        return {1, 2};
+    case EXCHANGE_KIND:
+        return {0, 2};
+    case EXCHANGE_TILE:
+        return {0, static_cast<int>(std::min<size_t>(5, nbQueued))};
+    case ORIENT_TILE:
+        return {1, 3};
+    default:
+        return {0, 0};
     }
 }
 
-void Game::display(Player &player, Tile &tile, bool bDisplayQueue) const {
-    clearTerminal();
-    std::cout << colorize(player.getColor()) << player.getName() << resetColor << " - Round " << currentRound << ":" << std::endl
-              << std::endl;
+// Decisions about the tile drawn this turn.
+static bool needsTile(DecisionType type) {
+    return type == TAKE_OR_EXCHANGE || type == EXCHANGE_KIND || type == EXCHANGE_TILE || type == REMOVE_STONE
+           || type == ORIENT_TILE || type == PLACE_TILE;
+}
 
-    std::cout << "Current Tile:" << std::endl;
-    tile.print();
-    std::cout << std::endl;
+Game::Game(const Snapshot &snapshot)
+    : seed(snapshot.getHeader().seed),
+      board(snapshot.getHeader().boardSize, checkedPlayers(snapshot.getHeader().nbPlayers), seed),
+      tileQueue(restoreQueue(snapshot)),
+      nbPlayers(snapshot.getHeader().nbPlayers),
+      players(),
+      currentRound(snapshot.getHeader().currentRound) {
+    const SnapshotHeader &header = snapshot.getHeader();
+    if (header.boardSize != board.getSize() || header.nbSeated > nbPlayers)
+        throw std::runtime_error("Game snapshot has an invalid board size or player count");
+
+    // The checksum only catches accidents, every index read from the file is checked before use
+    if (header.pendingType > GAME_OVER)
+        throw std::runtime_error("Game snapshot has an invalid pending decision");
+    if (header.currentPlayer >= nbPlayers || header.pendingPlayer >= nbPlayers
+        || (header.pendingType > CHOOSE_COLOR && header.nbSeated != nbPlayers))
+        throw std::runtime_error("Game snapshot has an invalid current player");
 
-    if (bDisplayQueue) {
-        std::cout << "Next Tiles:" << std::endl;
-        auto nextTiles = tileQueue.nextTiles();
-        tileQueue.printExchangeQueue(nextTiles);
-        std::cout << std::endl;
+    players.reserve(nbPlayers);
+    const SnapshotPlayer *savedPlayers = snapshot.getPlayers();
+    for (size_t p = 0; p < header.nbSeated; ++p) {
+        const SnapshotPlayer &player = savedPlayers[p];
+        if (player.color > ORANGE)
+            throw std::runtime_error("Game snapshot has an invalid player color");
+        players.emplace_back(std::string(player.name, strnlen(player.name, sizeof(player.name))),
+                             static_cast<PlayerColor>(player.color),
+                             player.coupons, player.stoneBonus, player.robberyBonus);
+    }
+    if (players.size() == nbPlayers)
+        reserveNotices();
+
+    // Only seated players can own cells, setup snapshots have fewer of them
+    auto owner = [this](uint8_t index) -> Player * {
+        if (index == SNAPSHOT_NO_OWNER)
+            return nullptr;
+        if (index >= players.size())
+            throw std::runtime_error("Game snapshot has an invalid owner");
+        return &players[index];
+    };
+
+    const SnapshotCell *cells = snapshot.getCells();
+    for (size_t x = 0; x < board.getSize(); ++x) {
+        for (size_t y = 0; y < board.getSize(); ++y) {
+            const SnapshotCell &saved = cells[x * board.getSize() + y];
+            if (saved.type >= NB_CELL_TYPES)
+                throw std::runtime_error("Game snapshot has an invalid cell type");
+            board.setCell({x, y}, static_cast<CellType>(saved.type), owner(saved.owner));
+            board.getCell({x, y}).printSymbol.assign(saved.symbol, strnlen(saved.symbol, sizeof(saved.symbol)));
+        }
     }
 
-    board.display();
+    std::vector<PlacedTile> placedTiles;
+    placedTiles.reserve(header.nbPlacedTiles);
+    const SnapshotTile *savedTiles = snapshot.getPlacedTiles();
+    for (size_t i = 0; i < header.nbPlacedTiles; ++i) {
+        const SnapshotTile &saved = savedTiles[i];
+        Tile tile = savedTile(saved.id, saved.orientation);
+        if (saved.x + tile.getShape().size() > board.getSize() || saved.y + tile.getShape()[0].size() > board.getSize())
+            throw std::runtime_error("Game snapshot has a tile outside the board");
+        placedTiles.push_back({tile, {saved.x, saved.y}, owner(saved.owner), saved.bStealable != 0});
+    }
+    board.restorePlacedTiles(std::move(placedTiles));
+
+    for (int color = PURPLE; color <= ORANGE; ++color)
+        if (header.availableColors & (1u << color))
+            availableColors.insert(static_cast<PlayerColor>(color));
+
+    // Choices are only checked against the pending range, which indexes the colors and the queue
+    DecisionType type = static_cast<DecisionType>(header.pendingType);
+    auto [lowest, highest] = choiceRange(type, availableColors.size(), tileQueue.getTiles().size());
+    if (header.pendingMin < lowest || header.pendingMin > header.pendingMax || header.pendingMax > highest)
+        throw std::runtime_error("Game snapshot has an invalid choice range");
+    if (needsTile(type) && header.tileId == RECORD_NO_TILE)
+        throw std::runtime_error("Game snapshot has no tile for its pending decision");
+
+    pending = {type, header.pendingPlayer, header.pendingMin, header.pendingMax};
+    currentPlayer = header.currentPlayer;
+    if (header.tileId != RECORD_NO_TILE)
+        currentTile = savedTile(header.tileId, header.tileOrientation);
+    bStealable = header.flags & SNAPSHOT_STEALABLE;
+    bDisplayQueue = header.flags & SNAPSHOT_DISPLAY_QUEUE;
+    pendingName.assign(header.pendingName, strnlen(header.pendingName, sizeof(header.pendingName)));
+
+    record.assign(snapshot.getEntries(), snapshot.getEntries() + header.nbEntries);
 }
 
-void Game::placingTile(Player &player, Tile &tile, bool bStealable, bool bDisplayQueue) {
-    bool ready = false;
-    while(!ready) {
-        display(player, tile, bDisplayQueue);
+Game::Game(const Game &other)
+    : seed(other.seed), board(other.board), tileQueue(other.tileQueue), nbPlayers(other.nbPlayers), players(),
+      currentRound(other.currentRound), pending(other.pending), currentPlayer(other.currentPlayer), currentTile(other.currentTile),
+      bStealable(other.bStealable), bDisplayQueue(other.bDisplayQueue), availableColors(other.availableColors),
+      pendingName(other.pendingName), record(other.record) {
+    // Same reserved storage as the original, cells then point to the copied players
+    players.reserve(nbPlayers);
+    for (const Player &player : other.players)
+        players.push_back(player);
+    board.reassignOwners(other.players.data(), players.data(), players.size());
+    if (players.size() == nbPlayers)
+        reserveNotices();
+}
 
-        std::cout << "1 - Place Tile" << std::endl;
-        std::cout << "2 - Rotate Tile" << std::endl;
-        std::cout << "3 - Flip Tile" << std::endl;
+void Game::notify(std::initializer_list<std::string_view> pieces) {
+    if (!notices.empty())
+        notices += "\n";
+    for (std::string_view piece : pieces)
+        notices += piece;
+}
 
-        int choiceBuffer = getIntegerInputInRange("> ", 1, 3);
-
-        switch (choiceBuffer) {
-            case 1:
-                ready = true;
-                break;
-            case 2:
-                tile.rotateClockwise();
-                break;
-            case 3:
-                tile.flipHorizontal();
-                break;
-        }
+SubmitResult Game::reject(std::initializer_list<std::string_view> pieces) {
+    notices.clear();
+    notify(pieces);
+    return {false, notices};
+}
+
+void Game::reserveNotices() {
+    // Longest notices : a message for each player without room for its coupons, and one about the turn
+    size_t noticesSize = 256;
+    for (const Player &player : players)
+        noticesSize += player.getName().size() + 96;
+    notices.reserve(noticesSize);
+}
+
+void Game::wait(DecisionType type, int min, int max) {
+    pending = {type, currentPlayer, min, max};
+}
+
+SubmitResult Game::submit(const Decision &decision) {
+    if (decision.type != pending.type)
+        return {false, "Unexpected decision."};
+
+    notices.clear();
+
+    // Entry taken before the decision changes the tile in hand
+    RecordEntry entry{};
+    if (recorder) {
+        entry.type = static_cast<uint8_t>(decision.type);
+        entry.player = static_cast<uint8_t>(pending.playerIndex);
+        entry.tileId = currentTile ? currentTile->getId() : RECORD_NO_TILE;
+        entry.orientation = currentTile ? currentTile->getOrientation() : 0;
+        entry.choice = static_cast<int16_t>(decision.choice);
+        entry.x = static_cast<uint16_t>(decision.coords.first);
+        entry.y = static_cast<uint16_t>(decision.coords.second);
     }
 
-    display(player, tile, bDisplayQueue);
+    SubmitResult result;
+    switch (pending.type) {
+    case CHOOSE_NAME:
+    case CHOOSE_COLOR:
+        result = setup(decision);
+        break;
+    case PLACE_STARTING_TILE:
+    case TAKE_OR_EXCHANGE:
+    case EXCHANGE_KIND:
+    case EXCHANGE_TILE:
+    case REMOVE_STONE:
+        result = playTurn(decision);
+        break;
+    case ORIENT_TILE:
+    case PLACE_TILE:
+        result = placingTile(decision);
+        break;
+    case PLACE_STONE:
+        result = applyStoneBonus(decision);
+        break;
+    case ROB_TILE:
+        result = applyRobberyBonus(decision);
+        break;
+    case PLACE_COUPON_TILE:
+        result = exchangeRemainingCoupons(decision);
+        break;
+    default:
+        return {false, "The game is over."};
+    }
 
-    std::pair<size_t, size_t> coords = {0, 0};
-    while (true) {
-        coords = getCoordinatesInput(board.getSize());
-        bool canPlace = board.canPlaceTile(coords, tile, player, false);
-        if (canPlace)
-            break;
-        std::cout << "Cannot place starting tile at (" << coords.first << ", "
-                  << coords.second << "). Try again." << std::endl;
+    // Names and colors are part of the record header
+    if (recorder && result.bAccepted) {
+        if (decision.type != CHOOSE_NAME && decision.type != CHOOSE_COLOR)
+            record.push_back(entry);
+        if (isOver()) {
+            recorder->write(*this, record);
+            record.clear();
+        }
     }
 
-    board.placeTile(coords, tile, &player, bStealable);
-    display(player, tile, bDisplayQueue);
+    return result;
+}
 
-    size_t pendingStone = player.getStoneBonus();
-    while (pendingStone > 0) {
-        std::cout << "You have " << pendingStone << " pending stone bonus to use immediately." << std::endl;
-        applyStoneBonus(player);
-        pendingStone = player.getStoneBonus();
+// --- Snapshots ---
+
+void Game::save(const std::string &path) const {
+    const std::vector<PlacedTile> &placedTiles = board.getPlacedTiles();
+    std::span<const Tile> queueTiles = tileQueue.getTiles();
+    const size_t size = board.getSize();
+
+    auto seat = [this](const Player *player) {
+        return player ? static_cast<uint8_t>(player - players.data()) : SNAPSHOT_NO_OWNER;
+    };
+
+    SnapshotHeader header{};
+    std::memcpy(header.magic, "LGS1", 4);
+    header.version = SNAPSHOT_VERSION;
+    header.nbPlayers = static_cast<uint8_t>(nbPlayers);
+    header.boardSize = static_cast<uint16_t>(size);
+    header.seed = seed;
+    header.currentRound = static_cast<uint8_t>(currentRound);
+    header.currentPlayer = static_cast<uint8_t>(currentPlayer);
+    header.pendingType = static_cast<uint8_t>(pending.type);
+    header.pendingPlayer = static_cast<uint8_t>(pending.playerIndex);
+    header.pendingMin = static_cast<int16_t>(pending.min);
+    header.pendingMax = static_cast<int16_t>(pending.max);
+    header.tileId = currentTile ? currentTile->getId() : RECORD_NO_TILE;
+    header.tileOrientation = currentTile ? currentTile->getOrientation() : 0;
+    header.flags = (bStealable ? SNAPSHOT_STEALABLE : 0) | (bDisplayQueue ? SNAPSHOT_DISPLAY_QUEUE : 0);
+    for (PlayerColor color : availableColors)
+        header.availableColors |= static_cast<uint16_t>(1u << color);
+    header.nbPlacedTiles = static_cast<uint16_t>(placedTiles.size());
+    header.nbQueueTiles = static_cast<uint16_t>(queueTiles.size());
+    header.nbSeated = static_cast<uint8_t>(players.size());
+    header.nbEntries = static_cast<uint32_t>(record.size());
+    std::strncpy(header.pendingName, pendingName.c_str(), sizeof(header.pendingName) - 1);
+
+    SnapshotLayout layout(header);
+    header.size = layout.size;
+
+    std::vector<char> data(layout.size, 0);
+
+    SnapshotPlayer *savedPlayers = reinterpret_cast<SnapshotPlayer *>(data.data() + layout.players);
+    for (size_t p = 0; p < players.size(); ++p) {
+        std::strncpy(savedPlayers[p].name, players[p].getName().c_str(), sizeof(savedPlayers[p].name) - 1);
+        savedPlayers[p].color = static_cast<uint8_t>(players[p].getColor());
+        savedPlayers[p].coupons = static_cast<uint16_t>(players[p].getCoupons());
+        savedPlayers[p].stoneBonus = static_cast<uint16_t>(players[p].getStoneBonus());
+        savedPlayers[p].robberyBonus = static_cast<uint16_t>(players[p].getRobberyBonus());
     }
 
-    size_t pendingRobbery = player.getRobberyBonus();
-    while (pendingRobbery > 0) {
-        std::cout << "You have " << pendingRobbery << " pending robbery bonus to use immediately." << std::endl;
-        applyRobberyBonus(player);
-        pendingRobbery = player.getRobberyBonus();
+    SnapshotCell *cells = reinterpret_cast<SnapshotCell *>(data.data() + layout.cells);
+    for (size_t x = 0; x < size; ++x) {
+        for (size_t y = 0; y < size; ++y) {
+            const Cell &cell = board.getCell({x, y});
+            SnapshotCell &saved = cells[x * size + y];
+            saved.type = static_cast<uint8_t>(cell.type);
+            saved.owner = seat(cell.owner);
+            std::strncpy(saved.symbol, cell.printSymbol.c_str(), sizeof(saved.symbol));
+        }
     }
-}
 
-void Game::play() {
-    for (currentRound = 0; currentRound <= maxRounds; ++currentRound)
-        for (auto &player : players)
-            playTurn(player);
+    SnapshotTile *savedTiles = reinterpret_cast<SnapshotTile *>(data.data() + layout.placedTiles);
+    for (size_t i = 0; i < placedTiles.size(); ++i) {
+        const PlacedTile &placedTile = placedTiles[i];
+        savedTiles[i] = {placedTile.tile.getId(), placedTile.tile.getOrientation(),
+                         static_cast<uint16_t>(placedTile.coords.first), static_cast<uint16_t>(placedTile.coords.second),
+                         seat(placedTile.owner), static_cast<uint8_t>(placedTile.bStealable)};
+    }
 
-    for (auto &player : players)
-        exchangeRemainingCoupons(player);
+    SnapshotTile *savedQueue = reinterpret_cast<SnapshotTile *>(data.data() + layout.queueTiles);
+    for (size_t i = 0; i < queueTiles.size(); ++i)
+        savedQueue[i] = {queueTiles[i].getId(), queueTiles[i].getOrientation(), 0, 0, SNAPSHOT_NO_OWNER, 0};
 
-    const Player &winner = determineWinner();
+    if (!record.empty())
+        std::memcpy(data.data() + layout.entries, record.data(), record.size() * sizeof(RecordEntry));
 
-    clearTerminal();
-    board.display();
+    header.checksum = snapshotChecksum(data.data(), data.size());
+    std::memcpy(data.data(), &header, sizeof(header));
 
-    std::cout << colorize(winner.getColor()) << winner.getName() << resetColor << " wins the game." << std::endl;
-    std::cout << "Thank you for playing !"  << std::endl;
+    writeSnapshotFile(path, data);
 }
 
-void Game::playTurn(Player &player) {
-    clearTerminal();
+// --- Transitions ---
 
+void Game::beginTurn() {
     // Place starting tile in the first round
     if (currentRound == 0) {
-        board.display();
+        wait(PLACE_STARTING_TILE);
+        return;
+    }
 
-        Tile startingTile = Tile(STARTING_TILE);
+    currentTile = tileQueue.drawTile();
 
-        std::cout << colorize(player.getColor()) << player.getName() << resetColor << " - Starting location:" << std::endl
-                  << std::endl;
+    // Player can only use one coupon per turn, offer the choice if any is available
+    if (players[currentPlayer].getCoupons() > 0) {
+        wait(TAKE_OR_EXCHANGE, 1, 2);
+        return;
+    }
 
-        std::pair<size_t, size_t> coords = {0, 0};
-        while (true) {
-            coords = getCoordinatesInput(board.getSize());
-            bool canPlace = board.canPlaceTile(coords, startingTile, player, true);
-            if (canPlace)
-                break;
-            std::cout << "Cannot place starting tile at ("
-                      << coords.first << ", " << coords.second
-                      << "). Try again." << std::endl
-                      << std::endl;
-        }
+    beginPlacing(*currentTile, true, true);
+}
 
-        board.placeTile(coords, startingTile, &player, false);
+void Game::beginPlacing(const Tile &tile, bool bTileStealable, bool bTileFromQueue) {
+    if (!board.canPlaceTileAnywhere(tile, players[currentPlayer])) {
+        notify({"Tile cannot be placed anywhere, it is discarded."});
+        currentTile.reset();
+        resolveBonuses();
         return;
     }
 
-    // --- Turn logic goes here ---
-    Tile currentTile = tileQueue.drawTile();
+    currentTile = tile;
+    bStealable = bTileStealable;
+    bDisplayQueue = bTileFromQueue;
+    wait(ORIENT_TILE, 1, 3);
+}
 
-    display(player, currentTile, true);
+void Game::resolveBonuses() {
+    Player &player = players[currentPlayer];
 
-    // While player has exchange coupons, offer choice to use them
-    size_t exchangeCoupons = player.getCoupons();
-    bool bDone = false; // Player can only use one coupon per turn, and allows to exit loop if Take Tile
-    while (exchangeCoupons > 0 && !bDone) {
-        std::cout << "1 - Take Tile" << std::endl;
-        std::cout << "2 - Exchange (" << exchangeCoupons << " available)" << std::endl;
+    if (player.getStoneBonus() > 0) {
+        wait(PLACE_STONE);
+        return;
+    }
 
-        int choiceAction = getIntegerInputInRange("> ", 1, 2);
+    while (player.getRobberyBonus() > 0) {
+        // If no tile can be stolen, player can't use bonus but still loses it
+        player.useRobberyBonus();
 
-        std::cout << std::endl;
-
-        switch (choiceAction) {
-        case 1:
-            bDone = true;
-            break;
-        case 2: {
-            std::cout << "1 - Exchange a tile from the queue" << std::endl;
-            std::cout << "2 - Remove a stone from the board" << std::endl;
-            int choiceExchange = getIntegerInputInRange("> ", 1, 2);
-
-            std::cout << std::endl;
-
-            switch (choiceExchange) {
-            case 1: {
-                size_t queueSize = tileQueue.nextTiles().size();
-                size_t maxChoices = std::min(static_cast<size_t>(5), queueSize);
-
-                if (maxChoices > 0) {
-                    std::cout << "Choose a tile to take (1 - " << maxChoices << "), or 0 to cancel: " << std::endl;
-                    int choiceTileIndex = getIntegerInputInRange("> ", 0, static_cast<int>(maxChoices));
-
-                    if (choiceTileIndex == 0)
-                        std::cout << "Exchange cancelled. Keeping first tile." << std::endl;
-                    else {
-                        int tileIndex = choiceTileIndex - 1;
-                        tileQueue.pushBack(currentTile);
-                        currentTile = tileQueue.exchangeTile(tileIndex);
-                        player.useCoupon();
-                        bDone = true; // We chose that player can only use one coupon per turn
-                    }
-                } else
-                    std::cout << "No tiles available in queue to exchange." << std::endl;
-                
-                std::cout << std::endl;
-                break;
-            }
-            case 2: {
-                // Making sure there are stones on the board
-                bool bExists = false;
-                for (size_t x = 0; x < board.getSize(); ++x) {
-                    for (size_t y = 0; y < board.getSize(); ++y) {
-                        if (board.getCell({x, y}).type == STONE) {
-                            bExists = true;
-                            break;
-                        }
-                    }
-                }
-
-                if (!bExists)
-                    std::cout << "No stone on the board to exchange." << std::endl;
-                else {
-                    std::pair<size_t, size_t> coords = getCoordinatesInput(board.getSize());
-                    const Cell &cell = board.getCell(coords);
-
-                    if (cell.type == STONE) {
-                        board.setCell(coords, EMPTY, nullptr);
-                        player.useCoupon();
-                        bDone = true; // We chose that player can only use one coupon per turn
-                        std::cout << "Stone successfully removed at ("
-                                  << coords.first << ", " << coords.second
-                                  << ")." << std::endl;
-                        break;
-                    } else
-                        std::cout << "No stone found at ("
-                                  << coords.first << ", " << coords.second
-                                  << "). Try again." << std::endl;
-                }
-
-                std::cout << std::endl;
-                break;
-            }
-            default:
-                break;
-            }
-            break;
+        if (board.countStealable(player) > 0) {
+            wait(ROB_TILE);
+            return;
         }
-        default:
-            break;
+
+        notify({"No enemy tiles available to steal."});
+    }
+
+    endTurn();
+}
+
+void Game::endTurn() {
+    currentTile.reset();
+
+    if (++currentPlayer < nbPlayers) {
+        beginTurn();
+        return;
+    }
+
+    currentPlayer = 0;
+    if (++currentRound <= maxRounds) {
+        beginTurn();
+        return;
+    }
+
+    beginCouponPhase();
+}
+
+void Game::beginCouponPhase() {
+    // Find the next player with remaining coupons, starting from the current one
+    for (; currentPlayer < nbPlayers; ++currentPlayer) {
+        Player &player = players[currentPlayer];
+
+        if (player.getCoupons() == 0)
+            continue;
+
+        if (board.canPlaceTileAnywhere(Tile::fromId(STARTING_TILE_ID), player)) {
+            wait(PLACE_COUPON_TILE);
+            return;
         }
 
-        exchangeCoupons = player.getCoupons();
+        notify({player.getName(), " has no room left for remaining coupons."});
+        while (player.getCoupons() > 0)
+            player.useCoupon();
     }
 
-    if (board.canPlaceTileAnywhere(currentTile, player))
-        placingTile(player, currentTile, true, true);
+    wait(GAME_OVER);
 }
 
-void Game::applyStoneBonus(Player &player) {
-    std::pair<size_t, size_t> coords = {0, 0};
+// --- Decision handlers ---
 
-    while (true) {
-        coords = getCoordinatesInput(board.getSize());
+SubmitResult Game::setup(const Decision &decision) {
+    if (pending.type == CHOOSE_NAME) {
+        if (decision.text.empty())
+            return {false, "Name cannot be empty."};
 
-        if (board.getCell(coords).type == EMPTY)
-            break;
-        else
-            std::cout << "Cannot place stone tile at ("
-                      << coords.first << ", " << coords.second
-                      << "). Try again." << std::endl;
+        pendingName = decision.text;
+        wait(CHOOSE_COLOR, 1, static_cast<int>(availableColors.size()));
+        return {true, notices};
     }
 
-    board.setCell(coords, STONE, nullptr);
+    if (decision.choice < pending.min || decision.choice > pending.max)
+        return {false, "Invalid choice. Try again."};
 
-    player.useStoneBonus();
-    std::cout << "Stone bonus used successfully at (" << coords.first << " " << coords.second << ")" << std::endl
-              << std::endl;
+    auto it = availableColors.begin();
+    std::advance(it, decision.choice - 1);
+    PlayerColor color = *it;
+    availableColors.erase(it);
+
+    // Colors are shared once every one of them is taken
+    if (availableColors.empty())
+        availableColors = ALL_COLORS;
+
+    players.emplace_back(pendingName, color);
+    pendingName.clear();
+
+    if (++currentPlayer < nbPlayers) {
+        wait(CHOOSE_NAME);
+        return {true, notices};
+    }
+
+    reserveNotices();
+
+    currentPlayer = 0;
+    currentRound = 0;
+    beginTurn();
+    return {true, notices};
 }
 
-void Game::applyRobberyBonus(Player &player) {
-    std::pair<size_t, size_t> coords = {0, 0};
-    std::optional<Tile> stolenTile;
+SubmitResult Game::playTurn(const Decision &decision) {
+    Player &player = players[currentPlayer];
 
-    player.useRobberyBonus();
+    switch (pending.type) {
+    case PLACE_STARTING_TILE: {
+        Tile startingTile = Tile::fromId(STARTING_TILE_ID);
+        const auto &coords = decision.coords;
 
-    // Need to make sure there is a tile to steal before entering the loop.
-    // If none exist, player can't use bonus but still loses coupon.
-    bool bExists = false;
-    for (const PlacedTile &placedTile : board.getPlacedTiles()) {
-        if (placedTile.owner != &player && placedTile.bStealable) {
-            bExists = true;
-            break;
-        }
+        if (!board.canPlaceTile(coords, startingTile, player, true))
+            return reject({"Cannot place starting tile at (", std::to_string(coords.first), ", ", std::to_string(coords.second), "). Try again."});
+
+        board.placeTile(coords, startingTile, &player, false);
+        endTurn();
+        return {true, notices};
     }
+    case TAKE_OR_EXCHANGE:
+        if (decision.choice == 1) {
+            beginPlacing(*currentTile, true, true);
+            return {true, notices};
+        }
+        if (decision.choice == 2) {
+            wait(EXCHANGE_KIND, 0, 2);
+            return {true, notices};
+        }
+        return {false, "Invalid choice. Try again."};
+    case EXCHANGE_KIND:
+        if (decision.choice == 0) {
+            wait(TAKE_OR_EXCHANGE, 1, 2);
+            return {true, notices};
+        }
+        if (decision.choice == 1) {
+            size_t maxChoices = std::min(static_cast<size_t>(5), tileQueue.nextTiles().size());
+            if (maxChoices == 0)
+                return {false, "No tiles available in queue to exchange."};
 
-    if (!bExists) {
-        std::cout << "No enemy tiles available to steal." << std::endl
-                  << std::endl;
-        return;
+            wait(EXCHANGE_TILE, 0, static_cast<int>(maxChoices));
+            return {true, notices};
+        }
+        if (decision.choice == 2) {
+            // Making sure there are stones on the board
+            if (board.countCells(STONE) == 0)
+                return {false, "No stone on the board to exchange."};
+
+            wait(REMOVE_STONE);
+            return {true, notices};
+        }
+        return {false, "Invalid choice. Try again."};
+    case EXCHANGE_TILE:
+        if (decision.choice < pending.min || decision.choice > pending.max)
+            return {false, "Invalid choice. Try again."};
+
+        if (decision.choice == 0) {
+            notify({"Exchange cancelled. Keeping first tile."});
+            wait(TAKE_OR_EXCHANGE, 1, 2);
+            return {true, notices};
+        }
+
+        tileQueue.pushBack(*currentTile);
+        currentTile = tileQueue.exchangeTile(decision.choice - 1);
+        player.useCoupon();
+        beginPlacing(*currentTile, true, true); // We chose that player can only use one coupon per turn
+        return {true, notices};
+    case REMOVE_STONE: {
+        const auto &coords = decision.coords;
+
+        if (coords.first >= board.getSize() || coords.second >= board.getSize()
+            || board.getCell(coords).type != STONE)
+            return reject({"No stone found at (", std::to_string(coords.first), ", ", std::to_string(coords.second), "). Try again."});
+
+        board.setCell(coords, EMPTY, nullptr);
+        player.useCoupon();
+        notify({"Stone successfully removed at (", std::to_string(coords.first), ", ", std::to_string(coords.second), ")."});
+        beginPlacing(*currentTile, true, true); // We chose that player can only use one coupon per turn
+        return {true, notices};
     }
+    default:
+        return {false, "Unexpected decision."};
+    }
+}
 
-    while (true) {
-        coords = getCoordinatesInput(board.getSize());
-        stolenTile = board.stealTile(coords, &player);
+SubmitResult Game::placingTile(const Decision &decision) {
+    Player &player = players[currentPlayer];
 
-        if (stolenTile.has_value())
-            break;
-        else
-            std::cout << "Cannot rob tile at ("
-                      << coords.first << ", " << coords.second
-                      << "). Try again." << std::endl;
+    if (pending.type == ORIENT_TILE) {
+        switch (decision.choice) {
+        case 1:
+            // Avoid waiting for coordinates that can never be valid
+            if (!board.canPlaceTileAnywhere(*currentTile, player))
+                return {false, "Tile cannot be placed anywhere in this orientation."};
+
+            wait(PLACE_TILE);
+            return {true, notices};
+        case 2:
+            currentTile->rotateClockwise();
+            return {true, notices};
+        case 3:
+            currentTile->flipHorizontal();
+            return {true, notices};
+        default:
+            return {false, "Invalid choice. Try again."};
+        }
     }
-    
-    placingTile(player, stolenTile.value(), true, false);
 
-    std::cout << "Robbery bonus used successfully at ("
-              << coords.first << " " << coords.second
-              << ")" << std::endl
-              << std::endl;
+    const auto &coords = decision.coords;
+    if (!board.canPlaceTile(coords, *currentTile, player, false))
+        return reject({"Cannot place tile at (", std::to_string(coords.first), ", ", std::to_string(coords.second), "). Try again."});
+
+    board.placeTile(coords, *currentTile, &player, bStealable);
+    currentTile.reset();
+    resolveBonuses();
+    return {true, notices};
+}
+
+SubmitResult Game::applyStoneBonus(const Decision &decision) {
+    const auto &coords = decision.coords;
+
+    if (coords.first >= board.getSize() || coords.second >= board.getSize()
+        || board.getCell(coords).type != EMPTY)
+        return reject({"Cannot place stone tile at (", std::to_string(coords.first), ", ", std::to_string(coords.second), "). Try again."});
+
+    board.setCell(coords, STONE, nullptr);
+    players[currentPlayer].useStoneBonus();
+    notify({"Stone bonus used successfully at (", std::to_string(coords.first), ", ", std::to_string(coords.second), ")."});
+
+    resolveBonuses();
+    return {true, notices};
+}
+
+SubmitResult Game::applyRobberyBonus(const Decision &decision) {
+    const auto &coords = decision.coords;
+
+    if (coords.first >= board.getSize() || coords.second >= board.getSize())
+        return {false, "Coordinates out of range. Try again."};
+
+    std::optional<Tile> stolenTile = board.stealTile(coords, &players[currentPlayer]);
+    if (!stolenTile.has_value())
+        return reject({"Cannot rob tile at (", std::to_string(coords.first), ", ", std::to_string(coords.second), "). Try again."});
+
+    notify({"Robbery bonus used successfully at (", std::to_string(coords.first), ", ", std::to_string(coords.second), ")."});
+    beginPlacing(stolenTile.value(), true, false);
+    return {true, notices};
 }
 
-void Game::exchangeRemainingCoupons(Player &player) {
-    size_t coupons = player.getCoupons();
+SubmitResult Game::exchangeRemainingCoupons(const Decision &decision) {
+    Player &player = players[currentPlayer];
+    Tile lastTile = Tile::fromId(STARTING_TILE_ID);
+    const auto &coords = decision.coords;
+
+    if (!board.canPlaceTile(coords, lastTile, player, false))
+        return reject({"Cannot place grass tile at (", std::to_string(coords.first), ", ", std::to_string(coords.second), "). Try again."});
+
+    board.placeTile(coords, lastTile, &player, false);
+    player.useCoupon();
+
+    beginCouponPhase();
+    return {true, notices};
+}
+
+// --- Terminal front-end ---
+
+void Game::display(const Player &player, const Tile &tile, bool bDisplayQueue) const {
+    clearTerminal();
+    std::cout << colorize(player.getColor()) << player.getName() << resetColor << " - Round " << currentRound << ":" << std::endl
+              << std::endl;
+
+    std::cout << "Current Tile:" << std::endl;
+    tile.print();
+    std::cout << std::endl;
 
-    while (coupons > 0) {
+    if (bDisplayQueue) {
+        std::cout << "Next Tiles:" << std::endl;
+        tileQueue.printExchangeQueue(tileQueue.nextTiles());
+        std::cout << std::endl;
+    }
+
+    board.display();
+}
+
+void Game::prompt() const {
+    switch (pending.type) {
+    case CHOOSE_NAME:
+        clearTerminal();
+        std::cout << "Player " << (pending.playerIndex + 1) << " - Choose your name: ";
+        break;
+    case CHOOSE_COLOR: {
+        std::cout << std::endl << "Choose your color: " << std::endl;
+        size_t index = 1;
+        for (auto c : availableColors)
+            std::cout << index++ << ". " << colorize(c) << playerColorToString(c) << resetColor << std::endl;
+        break;
+    }
+    case PLACE_STARTING_TILE: {
+        const Player &player = players[pending.playerIndex];
+        clearTerminal();
+        board.display();
+        std::cout << colorize(player.getColor()) << player.getName() << resetColor << " - Starting location:" << std::endl
+                  << std::endl;
+        break;
+    }
+    case TAKE_OR_EXCHANGE:
+        display(players[pending.playerIndex], *currentTile, true);
+        std::cout << "1 - Take Tile" << std::endl;
+        std::cout << "2 - Exchange (" << players[pending.playerIndex].getCoupons() << " available)" << std::endl;
+        break;
+    case EXCHANGE_KIND:
+        display(players[pending.playerIndex], *currentTile, true);
+        std::cout << "1 - Exchange a tile from the queue" << std::endl;
+        std::cout << "2 - Remove a stone from the board" << std::endl;
+        std::cout << "0 - Back" << std::endl;
+        break;
+    case EXCHANGE_TILE:
+        display(players[pending.playerIndex], *currentTile, true);
+        std::cout << "Choose a tile to take (1 - " << pending.max << "), or 0 to cancel: " << std::endl;
+        break;
+    case REMOVE_STONE:
+        display(players[pending.playerIndex], *currentTile, true);
+        std::cout << "Choose a stone to remove." << std::endl;
+        break;
+    case ORIENT_TILE:
+        display(players[pending.playerIndex], *currentTile, bDisplayQueue);
+        std::cout << "1 - Place Tile" << std::endl;
+        std::cout << "2 - Rotate Tile" << std::endl;
+        std::cout << "3 - Flip Tile" << std::endl;
+        break;
+    case PLACE_TILE:
+        display(players[pending.playerIndex], *currentTile, bDisplayQueue);
+        break;
+    case PLACE_STONE:
+        clearTerminal();
+        board.display();
+        std::cout << "You have " << players[pending.playerIndex].getStoneBonus()
+                  << " pending stone bonus to use immediately." << std::endl;
+        break;
+    case ROB_TILE:
+        clearTerminal();
+        board.display();
+        std::cout << "You have a pending robbery bonus to use immediately." << std::endl;
+        break;
+    case PLACE_COUPON_TILE: {
+        const Player &player = players[pending.playerIndex];
         clearTerminal();
         board.display();
+        std::cout << colorize(player.getColor()) << player.getName() << resetColor << " - " << player.getCoupons()
+                  << " exchange coupons remaining:" << std::endl
+                  << std::endl;
+        if (bHints) {
+            Arena::Scope scope(board.getScratch());
+            CouponPlan plan = solveCoupons(board, player, player.getCoupons());
+            if (!plan.placements.empty())
+                std::cout << "Hint: " << plan.placements.front().first << " " << plan.placements.front().second << " leads to a "
+                          << plan.square << "x" << plan.square << " square" << (plan.bOptimal ? "" : " at least") << std::endl
+                          << std::endl;
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
 
-        Tile lastTile = Tile(STARTING_TILE);
+Decision Game::readDecision() const {
+    Decision decision{pending.type};
+
+    switch (pending.type) {
+    case CHOOSE_NAME:
+        std::getline(std::cin >> std::ws, decision.text);
+        if (decision.text.empty())
+            checkEndOfInput();
+        break;
+    case CHOOSE_COLOR:
+    case TAKE_OR_EXCHANGE:
+    case EXCHANGE_KIND:
+    case EXCHANGE_TILE:
+    case ORIENT_TILE:
+        decision.choice = getIntegerInputInRange("> ", pending.min, pending.max);
+        std::cout << std::endl;
+        break;
+    default:
+        decision.coords = getCoordinatesInput(board.getSize());
+        break;
+    }
 
-        std::cout << colorize(player.getColor()) << player.getName() << resetColor << " - " << coupons << " exchange coupons remaining:" << std::endl
-                  << std::endl;
+    return decision;
+}
 
-        std::pair<size_t, size_t> coords = {0, 0};
-        while (true) {
-            coords = getCoordinatesInput(board.getSize());
-            bool canPlace = board.canPlaceTile(coords, lastTile, player, false);
-            if (canPlace)
-                break;
-            std::cout << "Cannot place grass tile at ("
-                      << coords.first << ", " << coords.second
-                      << "). Try again." << std::endl
-                      << std::endl;
+void Game::play() {
+    std::string notice;
+    bool bRedraw = true;
+
+    while (!isOver()) {
+        if (bRedraw) {
+            prompt();
+            if (!notice.empty())
+                std::cout << notice << std::endl << std::endl;
         }
 
-        board.placeTile(coords, lastTile, &player, false);
-        player.useCoupon();
-        coupons = player.getCoupons();
+        SubmitResult result = submit(readDecision());
+
+        // A rejected decision keeps the current screen, only the reason is printed
+        bRedraw = result.bAccepted;
+        notice = result.message;
+        if (!result.bAccepted) {
+            countInvalidInput();
+            std::cout << result.message << std::endl << std::endl;
+        }
     }
+
+    const Player &winner = determineWinner();
+
+    clearTerminal();
+    board.display();
+
+    if (!notice.empty())
+        std::cout << notice << std::endl << std::endl;
+
+    std::cout << colorize(winner.getColor()) << winner.getName() << resetColor << " wins the game." << std::endl;
+    std::cout << "Thank you for playing !"  << std::endl;
 }
 
 const Player& Game::determineWinner() const {
@@ -369,38 +804,12 @@ const Player& Game::determineWinner() const {
         throw std::runtime_error("No player in the game");
 
     const Player *winner = &players[0];
-    std::pair<size_t, size_t> toBeat = {0, 0}; // Holds largest square number and grass in territory count 
+    std::pair<size_t, size_t> toBeat = {0, 0}; // Holds largest square number and grass in territory count
     for (const Player &player : players) {
-        size_t boardSize = board.getSize();
-
-        if (boardSize == 0)
-            throw std::runtime_error("Invalid board size");
-
-        // Creates a 2D vector table of zeroes. table[x][y] stores the size of the largest square whose bottom right corner is (x, y)
-        std::vector<std::vector<size_t>> table(boardSize, std::vector<size_t>(boardSize, 0));
-
-        size_t largestSquare = 0;
-        size_t bestX = 0;
-        size_t bestY = 0;
-
-        for (size_t x = 0; x < boardSize; ++x) {
-            for (size_t y = 0; y < boardSize; ++y) {
-                const Cell &cell = board.getCell({x, y});
-
-                if (cell.owner == &player) {
-                    if (x == 0 || y == 0)
-                        table[x][y] = 1;
-                    else
-                        table[x][y] = 1 + std::min({table[x - 1][y], table[x][y - 1], table[x - 1][y - 1]});
-
-                    if (table[x][y] > largestSquare){
-                        largestSquare = table[x][y];
-                        bestX = x;
-                        bestY = y;
-                    }
-                }
-            }
-        }
+        Square square = board.largestSquare(player);
+        size_t largestSquare = square.side;
+        size_t bestX = square.corner.first;
+        size_t bestY = square.corner.second;
 
         size_t grassCount = 0;
         size_t startX = bestX - largestSquare + 1;
@@ -425,4 +834,4 @@ const Player& Game::determineWinner() const {
     }
 
     return *winner;
-}
\ No newline at end of file
+}
@@ -1,17 +1,117 @@
 #include "utils.hpp"
 #include "game.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
-#include <limits>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
 
-int main(void) {
+// Stream buffer dropping everything written to it, like /dev/null on every platform.
+class NullBuffer : public std::streambuf {
+  protected:
+    int overflow(int c) override { return traits_type::not_eof(c); }
+    std::streamsize xsputn(const char *, std::streamsize count) override { return count; }
+};
+
+// One game through the terminal front-end, from the number of players to the winner.
+static void playTerminalGame(bool bHints, std::optional<uint64_t> seed) {
     clearTerminal();
 
     std::cout << "Welcome to The Devil's Plan!" << std::endl;
 
-    int nbPlayers = getIntegerInputInRange("Please enter number of players (2 - 9): ", 2, 9);
-    Game game(static_cast<size_t>(nbPlayers)); // Safe to cast after validation
+    int nbPlayers = getIntegerInputInRange("Please enter number of players (" + std::to_string(Game::minPlayers) + " - "
+                                               + std::to_string(Game::maxPlayers) + "): ",
+                                           Game::minPlayers, Game::maxPlayers);
+    // Safe to cast after validation
+    Game game = seed ? Game(static_cast<size_t>(nbPlayers), *seed) : Game(static_cast<size_t>(nbPlayers));
 
+    game.setHints(bHints);
     game.play();
+}
+
+/**
+Scripted mode : every game reads its inputs from the script, as typed at the keyboard.
+The front-end runs as usual but writes to a null stream, only the report is printed.
+*/
+static int playScript(const std::string &path, size_t nbGames, bool bHints, std::optional<uint64_t> seed) {
+    std::string script;
+    if (path == "-") {
+        script.assign(std::istreambuf_iterator<char>(std::cin), std::istreambuf_iterator<char>());
+    } else {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            std::cerr << "Cannot open " << path << "." << std::endl;
+            return 1;
+        }
+        script.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    std::ostream report(std::cout.rdbuf());
+    NullBuffer null;
+    std::cout.rdbuf(&null);
+    std::streambuf *keyboard = std::cin.rdbuf();
+
+    size_t nbCompleted = 0;
+    std::string error;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t g = 0; g < nbGames && error.empty(); ++g) {
+        std::istringstream input(script);
+        std::cin.rdbuf(input.rdbuf());
+        std::cin.clear();
+        try {
+            playTerminalGame(bHints, seed);
+            ++nbCompleted;
+        } catch (const std::runtime_error &e) {
+            error = "Game " + std::to_string(g + 1) + ": " + e.what();
+        }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cin.rdbuf(keyboard);
+    std::cout.rdbuf(report.rdbuf());
+
+    if (!error.empty())
+        report << error << std::endl;
+    report << nbCompleted << " games in " << elapsed.count() << " s (" << nbCompleted / elapsed.count() << " games/s)" << std::endl;
+    report << getNbInvalidInputs() << " invalid inputs" << std::endl;
+    return error.empty() ? 0 : 2;
+}
+
+int main(int argc, char **argv) {
+    bool bHints = false;
+    std::string scriptPath;
+    size_t nbGames = 1;
+    std::optional<uint64_t> seed;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--hints")
+            bHints = true;
+        else if (arg == "--script" && i + 1 < argc)
+            scriptPath = argv[++i];
+        else if (arg == "--games" && i + 1 < argc)
+            nbGames = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--seed" && i + 1 < argc)
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--hints] [--seed S] [--script FILE|- [--games N]]" << std::endl;
+            return 1;
+        }
+    }
+
+    if (!scriptPath.empty())
+        return playScript(scriptPath, nbGames, bHints, seed);
+
+    try {
+        playTerminalGame(bHints, seed);
+    } catch (const std::runtime_error &e) {
+        std::cout << std::endl << e.what() << std::endl;
+        return 1;
+    }
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,130 @@
+#include "opening_book.hpp"
+#include "tile_shapes.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+// Bijective mix of 64 bits, so that sums of mixed cells rarely collide.
+static uint64_t mix(uint64_t value) {
+    value += 0x9E3779B97F4A7C15ULL;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+}
+
+std::pair<size_t, size_t> applySymmetry(uint8_t symmetry, std::pair<size_t, size_t> coords, size_t size) {
+    auto [x, y] = coords;
+    if (symmetry & 4)
+        std::swap(x, y);
+    if (symmetry & 1)
+        x = size - 1 - x;
+    if (symmetry & 2)
+        y = size - 1 - y;
+    return {x, y};
+}
+
+std::pair<size_t, size_t> invertSymmetry(uint8_t symmetry, std::pair<size_t, size_t> coords, size_t size) {
+    auto [x, y] = coords;
+    if (symmetry & 2)
+        y = size - 1 - y;
+    if (symmetry & 1)
+        x = size - 1 - x;
+    if (symmetry & 4)
+        std::swap(x, y);
+    return {x, y};
+}
+
+BookKey bookKey(const Board &board, const Player &player) {
+    const size_t size = board.getSize();
+
+    // Each cell adds its mix to the key of every symmetry, so the order of the cells does not matter
+    std::array<uint64_t, 8> keys;
+    keys.fill(mix(size));
+    for (size_t x = 0; x < size; ++x) {
+        for (size_t y = 0; y < size; ++y) {
+            const Cell &cell = board.getCell({x, y});
+            if (cell.type == EMPTY || cell.owner == &player)
+                continue;
+
+            uint64_t kind = static_cast<uint64_t>(cell.type);
+            for (uint8_t symmetry = 0; symmetry < 8; ++symmetry) {
+                auto [i, j] = applySymmetry(symmetry, {x, y}, size);
+                keys[symmetry] += mix((i * size + j) << 3 | kind);
+            }
+        }
+    }
+
+    auto smallest = std::min_element(keys.begin(), keys.end());
+    return {*smallest, static_cast<uint8_t>(smallest - keys.begin())};
+}
+
+void writeOpeningBook(const std::string &path, std::vector<BookEntry> entries) {
+    std::stable_sort(entries.begin(), entries.end(), [](const BookEntry &a, const BookEntry &b) { return a.key < b.key; });
+
+    // Keep the last entry of each key
+    std::vector<BookEntry> unique;
+    for (const BookEntry &entry : entries) {
+        if (!unique.empty() && unique.back().key == entry.key)
+            unique.back() = entry;
+        else
+            unique.push_back(entry);
+    }
+
+    BookHeader header{};
+    std::memcpy(header.magic, "LGB1", 4);
+    header.version = BOOK_VERSION;
+    header.nbEntries = static_cast<uint32_t>(unique.size());
+
+    // Written next to the previous one then renamed over it, the book may be mapped meanwhile
+    std::string temporary = path + ".tmp";
+    std::FILE *file = std::fopen(temporary.c_str(), "wb");
+    if (!file)
+        throw std::runtime_error("Cannot write opening book " + temporary);
+    bool bWritten = std::fwrite(&header, sizeof(header), 1, file) == 1
+                    && std::fwrite(unique.data(), sizeof(BookEntry), unique.size(), file) == unique.size();
+    bWritten = std::fclose(file) == 0 && bWritten;
+    if (!bWritten)
+        throw std::runtime_error("Cannot write opening book " + temporary);
+
+    if (!replaceFile(temporary, path))
+        throw std::runtime_error("Cannot replace opening book " + path);
+}
+
+OpeningBook::OpeningBook(const std::string &path) : file(path) {
+    BookHeader header;
+    if (file.getSize() < sizeof(header))
+        throw std::runtime_error("Opening book " + path + " is truncated");
+    std::memcpy(&header, file.getData(), sizeof(header));
+
+    if (std::memcmp(header.magic, "LGB1", 4) != 0)
+        throw std::runtime_error(path + " is not an opening book");
+    if (header.version != BOOK_VERSION)
+        throw std::runtime_error("Opening book " + path + " has version " + std::to_string(header.version));
+    if (file.getSize() != sizeof(header) + size_t(header.nbEntries) * sizeof(BookEntry))
+        throw std::runtime_error("Opening book " + path + " is truncated");
+
+    // Mapped files start on a page, and the header keeps entries aligned
+    entries = reinterpret_cast<const BookEntry *>(file.getData() + sizeof(header));
+    nbEntries = header.nbEntries;
+}
+
+std::optional<std::pair<size_t, size_t>> OpeningBook::lookup(const Board &board, const Player &player) const {
+    BookKey key = bookKey(board, player);
+
+    const BookEntry *last = entries + nbEntries;
+    const BookEntry *entry = std::lower_bound(entries, last, key.key, [](const BookEntry &e, uint64_t k) { return e.key < k; });
+
+    // Keys may collide, the location must still be legal on this board
+    if (entry != last && entry->key == key.key && entry->x < board.getSize() && entry->y < board.getSize()) {
+        std::pair<size_t, size_t> coords = invertSymmetry(key.symmetry, {entry->x, entry->y}, board.getSize());
+        if (board.canPlaceTile(coords, Tile::fromId(STARTING_TILE_ID), player, true)) {
+            ++nbHits;
+            return coords;
+        }
+    }
+
+    ++nbMisses;
+    return std::nullopt;
+}
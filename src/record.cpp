@@ -0,0 +1,99 @@
+#include "record.hpp"
+#include "game.hpp"
+#include <cstring>
+#include <stdexcept>
+
+RecordWriter::RecordWriter(const std::string &path) : buffer(1 << 16) {
+    file = std::fopen(path.c_str(), "ab");
+    if (!file)
+        throw std::runtime_error("Cannot open record file " + path);
+    std::setvbuf(file, buffer.data(), _IOFBF, buffer.size());
+}
+
+RecordWriter::~RecordWriter() {
+    std::fclose(file);
+}
+
+void RecordWriter::write(const Game &game, const std::vector<RecordEntry> &entries) {
+    const std::vector<Player> &players = game.getPlayers();
+    const std::vector<Bonus> &bonuses = game.getBoard().getBonusLayout();
+
+    size_t recordSize = sizeof(RecordHeader)
+                        + players.size() * sizeof(RecordPlayer)
+                        + bonuses.size() * sizeof(RecordBonus)
+                        + entries.size() * sizeof(RecordEntry);
+    recordSize = (recordSize + 7) & ~size_t(7);
+
+    staging.assign(recordSize, 0);
+    char *out = staging.data();
+
+    RecordHeader header{};
+    std::memcpy(header.magic, "LGR1", 4);
+    header.version = RECORD_VERSION;
+    header.nbPlayers = static_cast<uint8_t>(players.size());
+    header.boardSize = static_cast<uint16_t>(game.getBoard().getSize());
+    header.seed = game.getSeed();
+    header.nbEntries = static_cast<uint32_t>(entries.size());
+    header.nbBonuses = static_cast<uint16_t>(bonuses.size());
+    header.recordSize = static_cast<uint32_t>(recordSize);
+    std::memcpy(out, &header, sizeof(header));
+    out += sizeof(header);
+
+    for (const Player &player : players) {
+        RecordPlayer recordPlayer{};
+        std::strncpy(recordPlayer.name, player.getName().c_str(), sizeof(recordPlayer.name) - 1);
+        recordPlayer.color = static_cast<uint8_t>(player.getColor());
+        std::memcpy(out, &recordPlayer, sizeof(recordPlayer));
+        out += sizeof(recordPlayer);
+    }
+
+    for (const Bonus &bonus : bonuses) {
+        RecordBonus recordBonus{};
+        recordBonus.x = static_cast<uint16_t>(bonus.coords.first);
+        recordBonus.y = static_cast<uint16_t>(bonus.coords.second);
+        recordBonus.type = static_cast<uint8_t>(bonus.type);
+        std::memcpy(out, &recordBonus, sizeof(recordBonus));
+        out += sizeof(recordBonus);
+    }
+
+    if (!entries.empty())
+        std::memcpy(out, entries.data(), entries.size() * sizeof(RecordEntry));
+
+    if (std::fwrite(staging.data(), 1, staging.size(), file) != staging.size())
+        throw std::runtime_error("Cannot write game record");
+}
+
+void RecordWriter::flush() {
+    std::fflush(file);
+}
+
+bool RecordReader::next(RecordView &view) {
+    const char *data = file.getData();
+    size_t size = file.getSize();
+
+    if (offset >= size)
+        return false;
+
+    if (size - offset < sizeof(RecordHeader))
+        throw std::runtime_error("Truncated game record");
+
+    const char *record = data + offset;
+    const RecordHeader *header = reinterpret_cast<const RecordHeader *>(record);
+    if (std::memcmp(header->magic, "LGR1", 4) != 0 || header->version != RECORD_VERSION)
+        throw std::runtime_error("Not a game record");
+
+    size_t expected = sizeof(RecordHeader)
+                      + header->nbPlayers * sizeof(RecordPlayer)
+                      + header->nbBonuses * sizeof(RecordBonus)
+                      + header->nbEntries * sizeof(RecordEntry);
+    if (header->recordSize < expected || header->recordSize > size - offset)
+        throw std::runtime_error("Truncated game record");
+
+    view.header = header;
+    view.players = reinterpret_cast<const RecordPlayer *>(record + sizeof(RecordHeader));
+    view.bonuses = reinterpret_cast<const RecordBonus *>(view.players + header->nbPlayers);
+    view.entries = reinterpret_cast<const RecordEntry *>(view.bonuses + header->nbBonuses);
+
+    offset += header->recordSize;
+    return true;
+}
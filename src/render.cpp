@@ -0,0 +1,354 @@
+#include "render.hpp"
+#include "game.hpp"
+#include "utils.hpp"
+#include <optional>
+#include <sstream>
+#include <string>
+
+static std::string bonusName(CellType type) {
+    switch (type) {
+        case BONUS_EXCHANGE: return "exchange bonus";
+        case BONUS_STONE: return "stone bonus";
+        case BONUS_ROBBERY: return "robbery bonus";
+        default: return "cell";
+    }
+}
+
+RenderPipeline::RenderPipeline(std::ostream *screen, std::ostream *log, size_t capacity) : ring(capacity), screen(screen), log(log) {
+    output = std::thread(&RenderPipeline::run, this);
+}
+
+RenderPipeline::~RenderPipeline() {
+    close();
+}
+
+// --- Game thread ---
+
+void RenderPipeline::handOver() {
+    size_t nbHanded = 0;
+    while (nbHanded < overflow.size() && ring.tryPush(overflow[nbHanded]))
+        ++nbHanded;
+    overflow.erase(overflow.begin(), overflow.begin() + static_cast<std::ptrdiff_t>(nbHanded));
+}
+
+void RenderPipeline::publish(const RenderEvent &event) {
+    // Events stay in order : once one waits in overflow, the next ones wait behind it
+    handOver();
+    bool bBoardEvent = event.kind == RenderEvent::RESET || event.kind == RenderEvent::CELL || event.kind == RenderEvent::FRAME;
+    if (bBoardEvent && !bSyncing) {
+        if (!bResync && overflow.empty() && ring.tryPush(event)) {
+            bFrameOwed &= event.kind != RenderEvent::FRAME;
+            return;
+        }
+        // Cells and frames are not kept : the board is sent again as a whole at the next frame
+        bResync = true;
+        if (event.kind == RenderEvent::FRAME)
+            skipFrame(event);
+        return;
+    }
+
+    bFrameOwed &= event.kind != RenderEvent::FRAME;
+    if (!bBoardEvent && !log && event.kind != RenderEvent::PLAYER)
+        return; // Only the log reads the other events
+    if (overflow.empty() && ring.tryPush(event))
+        return;
+    overflow.push_back(event);
+}
+
+void RenderPipeline::skipFrame(const RenderEvent &frame) {
+    bFrameOwed = true;
+    if (!log) {
+        ++nbDropped;
+        return;
+    }
+    // The log still gets its line
+    RenderEvent logged = frame;
+    logged.other = RenderEvent::LOG_ONLY;
+    if (overflow.empty() && ring.tryPush(logged))
+        return;
+    overflow.push_back(logged);
+}
+
+void RenderPipeline::publishBoard() {
+    const Board &board = game->getBoard();
+    publish({RenderEvent::RESET, 0, RenderEvent::NO_PLAYER, 0, static_cast<uint32_t>(board.getSize()), 0});
+    for (size_t x = 0; x < board.getSize(); ++x) {
+        for (size_t y = 0; y < board.getSize(); ++y) {
+            const Cell &cell = board.getCell({x, y});
+            if (cell.type != EMPTY)
+                publishCell({x, y}, cell.type, cell.owner);
+        }
+    }
+}
+
+uint16_t RenderPipeline::indexOf(const Player *player) {
+    if (!player)
+        return RenderEvent::NO_PLAYER;
+
+    size_t index = static_cast<size_t>(player - game->getPlayers().data());
+    if (index >= bAnnounced.size())
+        bAnnounced.resize(index + 1, false);
+    if (!bAnnounced[index]) {
+        bAnnounced[index] = true;
+        publish({RenderEvent::PLAYER, static_cast<uint8_t>(player->getColor()), static_cast<uint16_t>(index), 0, 0, 0});
+    }
+    return static_cast<uint16_t>(index);
+}
+
+void RenderPipeline::publishCell(std::pair<size_t, size_t> coords, CellType type, const Player *owner) {
+    publish({RenderEvent::CELL, static_cast<uint8_t>(type), indexOf(owner), 0, static_cast<uint32_t>(coords.first),
+             static_cast<uint32_t>(coords.second)});
+}
+
+void RenderPipeline::resync(const std::optional<RenderEvent> &frame) {
+    bResync = false;
+    bSyncing = true;
+    publishBoard();
+    if (frame)
+        publish(*frame);
+    bSyncing = false;
+}
+
+void RenderPipeline::watch(Game &watched) {
+    game = &watched;
+    watched.attachBoardObserver(*this);
+    // Without a log, a resent board, its frame and the colors of the players are all that may wait in overflow
+    size_t boardSize = watched.getBoard().getSize();
+    overflow.reserve(boardSize * boardSize + Game::maxPlayers + 2);
+    publishBoard();
+}
+
+void RenderPipeline::frame() {
+    const PendingDecision &pending = game->pendingDecision();
+    // Players choosing their name and color are not created yet
+    uint16_t player = RenderEvent::NO_PLAYER;
+    if (pending.type != GAME_OVER && pending.playerIndex < game->getPlayers().size())
+        player = indexOf(&game->getPlayers()[pending.playerIndex]);
+    lastFrame = RenderEvent{RenderEvent::FRAME, static_cast<uint8_t>(pending.type), player, 0, static_cast<uint32_t>(game->getCurrentRound()), 0};
+
+    // A board out of sync is only sent again once overflow is empty, so that one board at most waits in it
+    handOver();
+    if (bResync && overflow.empty())
+        resync(lastFrame);
+    else
+        publish(*lastFrame);
+
+    // The output thread only sleeps once it has drawn every frame, so it is woken up for new frames only
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (bIdle.load(std::memory_order_relaxed)) {
+        wakeups.fetch_add(1);
+        wakeups.notify_one();
+    }
+}
+
+void RenderPipeline::close() {
+    if (!output.joinable())
+        return;
+
+    // Closing is the only time the game thread waits, for the events kept aside and a board out of sync
+    while (!overflow.empty() || bResync) {
+        handOver();
+        if (bResync && overflow.empty()) {
+            // The last frame is drawn with the board, and no longer counted as skipped
+            std::optional<RenderEvent> redrawn;
+            if (bFrameOwed && lastFrame) {
+                redrawn = lastFrame;
+                if (log)
+                    redrawn->other = RenderEvent::DRAW_ONLY;
+                else
+                    --nbDropped;
+            }
+            resync(redrawn);
+        }
+        wakeups.fetch_add(1);
+        wakeups.notify_one();
+        std::this_thread::yield();
+    }
+
+    bStopping = true;
+    wakeups.fetch_add(1);
+    wakeups.notify_one();
+    output.join();
+}
+
+void RenderPipeline::onCellsCovered(const CellsCovered &event) {
+    for (const auto &coords : event.cells)
+        publishCell(coords, GRASS, event.player);
+    publish({RenderEvent::COVER, 0, indexOf(event.player), 0, static_cast<uint32_t>(event.tileIndex), static_cast<uint32_t>(event.cells.size())});
+}
+
+void RenderPipeline::onBonusCaptured(const BonusCaptured &event) {
+    publishCell(event.coords, GRASS, event.player);
+    publish({RenderEvent::CAPTURE, static_cast<uint8_t>(event.bonus), indexOf(event.player), 0, static_cast<uint32_t>(event.coords.first),
+             static_cast<uint32_t>(event.coords.second)});
+}
+
+void RenderPipeline::onStonePlaced(const StonePlaced &event) {
+    publishCell(event.coords, STONE, nullptr);
+    publish({RenderEvent::STONE, 1, RenderEvent::NO_PLAYER, 0, static_cast<uint32_t>(event.coords.first), static_cast<uint32_t>(event.coords.second)});
+}
+
+void RenderPipeline::onStoneRemoved(const StoneRemoved &event) {
+    publishCell(event.coords, EMPTY, nullptr);
+    publish({RenderEvent::STONE, 0, RenderEvent::NO_PLAYER, 0, static_cast<uint32_t>(event.coords.first), static_cast<uint32_t>(event.coords.second)});
+}
+
+void RenderPipeline::onTileStolen(const TileStolen &event) {
+    for (const auto &coords : event.cells)
+        publishCell(coords, EMPTY, nullptr);
+    publish({RenderEvent::STEAL, 0, indexOf(event.thief), indexOf(event.victim), 0, static_cast<uint32_t>(event.cells.size())});
+}
+
+void RenderPipeline::onCellChanged(const CellChanged &event) {
+    publishCell(event.coords, event.type, event.owner);
+}
+
+void RenderPipeline::onBoardReset(const BoardReset &) {
+    publishBoard();
+}
+
+// --- Output thread ---
+
+void RenderPipeline::run() {
+    std::optional<RenderEvent> pendingFrame;
+    bool bAtFrame = false; // A frame is only drawn once every event of its decision is applied
+    RenderEvent event;
+
+    while (true) {
+        while (ring.tryPop(event)) {
+            if (event.kind == RenderEvent::FRAME && event.other == RenderEvent::LOG_ONLY) {
+                // Sent while the board was out of sync
+                ++nbSkipped;
+                bAtFrame = false;
+            } else if (event.kind == RenderEvent::FRAME) {
+                if (pendingFrame)
+                    ++nbSkipped;
+                if (event.other == RenderEvent::DRAW_ONLY)
+                    --nbSkipped;
+                pendingFrame = event;
+                bAtFrame = true;
+            } else {
+                bAtFrame = false;
+            }
+            apply(event);
+        }
+
+        if (pendingFrame && bAtFrame) {
+            draw(*pendingFrame);
+            ++nbFrames;
+            pendingFrame.reset();
+        }
+
+        // Sleep until the next frame, unless events came in meanwhile
+        bIdle.store(true);
+        uint32_t seen = wakeups.load();
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool bEmpty = ring.empty();
+        if (bEmpty && bStopping.load())
+            break;
+        if (bEmpty)
+            wakeups.wait(seen);
+        bIdle.store(false);
+    }
+
+    if (pendingFrame) {
+        draw(*pendingFrame);
+        ++nbFrames;
+    }
+    if (log)
+        log->flush();
+}
+
+void RenderPipeline::apply(const RenderEvent &event) {
+    auto name = [](uint16_t player) { return "Player " + std::to_string(player + 1); };
+    auto at = [](uint32_t x, uint32_t y) { return "(" + std::to_string(x) + ", " + std::to_string(y) + ")"; };
+
+    switch (event.kind) {
+    case RenderEvent::RESET:
+        size = event.x;
+        cells.assign(size * size, {EMPTY, RenderEvent::NO_PLAYER});
+        break;
+    case RenderEvent::PLAYER:
+        if (event.player >= colors.size())
+            colors.resize(event.player + 1, PURPLE);
+        colors[event.player] = static_cast<PlayerColor>(event.type);
+        if (log)
+            *log << name(event.player) << " is " << playerColorToString(colors[event.player]) << "\n";
+        break;
+    case RenderEvent::CELL:
+        cells[event.x * size + event.y] = {event.type, event.player};
+        break;
+    case RenderEvent::COVER:
+        if (log)
+            *log << name(event.player) << " places tile " << event.x << " (" << event.y << " cells)\n";
+        break;
+    case RenderEvent::CAPTURE:
+        if (log)
+            *log << name(event.player) << " captures the " << bonusName(static_cast<CellType>(event.type)) << " at " << at(event.x, event.y) << "\n";
+        break;
+    case RenderEvent::STONE:
+        if (log)
+            *log << (event.type ? "Stone placed at " : "Stone removed at ") << at(event.x, event.y) << "\n";
+        break;
+    case RenderEvent::STEAL:
+        if (log)
+            *log << name(event.player) << " steals " << event.y << " cells from " << name(event.other) << "\n";
+        break;
+    case RenderEvent::FRAME:
+        if (event.other == RenderEvent::DRAW_ONLY)
+            break;
+        if (log && event.player != RenderEvent::NO_PLAYER)
+            *log << "Round " << event.x << " - " << name(event.player) << ": " << decisionTypeToString(static_cast<DecisionType>(event.type)) << "\n";
+        else if (log && event.type == GAME_OVER)
+            *log << "Game over\n";
+        break;
+    }
+}
+
+void RenderPipeline::draw(const RenderEvent &frame) const {
+    if (!screen)
+        return;
+
+    // The whole frame is written at once, so that the terminal never shows half of it
+    std::ostringstream out;
+    out << "\033[2J\033[H";
+    if (frame.type == GAME_OVER)
+        out << "Game over";
+    else
+        out << "Round " << frame.x;
+    if (frame.player != RenderEvent::NO_PLAYER && frame.player < colors.size())
+        out << " - " << colorize(colors[frame.player]) << "Player " << (frame.player + 1) << resetColor << ": "
+            << decisionTypeToString(static_cast<DecisionType>(frame.type));
+    out << "\n\n";
+
+    for (size_t x = 0; x < size; ++x) {
+        for (size_t y = 0; y < size; ++y) {
+            auto [type, owner] = cells[x * size + y];
+            switch (type) {
+            case GRASS:
+                if (owner < colors.size())
+                    out << colorize(colors[owner]);
+                out << "██" << resetColor;
+                break;
+            case STONE:
+                out << "\033[37m██" << resetColor;
+                break;
+            case BONUS_EXCHANGE:
+                out << "Ｅ";
+                break;
+            case BONUS_STONE:
+                out << "Ｓ";
+                break;
+            case BONUS_ROBBERY:
+                out << "Ｒ";
+                break;
+            default:
+                out << "・";
+                break;
+            }
+        }
+        out << "\n";
+    }
+
+    *screen << out.str() << std::flush;
+}
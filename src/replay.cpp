@@ -0,0 +1,79 @@
+#include "replay.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+std::unique_ptr<Game> replayStart(const RecordView &view) {
+    const RecordHeader &header = *view.header;
+    auto game = std::make_unique<Game>(header.nbPlayers, header.seed, header.boardSize);
+
+    // Colors are chosen by their rank among the colors still available
+    for (size_t p = 0; p < header.nbPlayers; ++p) {
+        const RecordPlayer &player = view.players[p];
+        game->submit(Decision{CHOOSE_NAME, 0, {0, 0}, std::string(player.name, strnlen(player.name, sizeof(player.name)))});
+
+        const std::set<PlayerColor> &colors = game->getAvailableColors();
+        auto it = colors.find(static_cast<PlayerColor>(player.color));
+        if (it == colors.end())
+            throw std::runtime_error("color of player " + std::to_string(p + 1) + " unavailable");
+        if (!game->submit(Decision{CHOOSE_COLOR, static_cast<int>(std::distance(colors.begin(), it)) + 1}).bAccepted)
+            throw std::runtime_error("color of player " + std::to_string(p + 1) + " rejected");
+    }
+
+    return game;
+}
+
+ReplayCursor::ReplayCursor(const RecordView &view, size_t interval) : view(view), interval(interval == 0 ? 1 : interval) {
+    game = replayStart(view);
+    keyframes.push_back(std::make_unique<const Game>(*game));
+}
+
+void ReplayCursor::detachBoardObserver() {
+    if (observer)
+        game->detachBoardObserver(observer);
+    observer = nullptr;
+    follow = nullptr;
+}
+
+void ReplayCursor::stepForward() {
+    const RecordEntry &entry = view.entries[position];
+    SubmitResult result = game->submit(toDecision(entry));
+    if (!result.bAccepted)
+        throw std::runtime_error("entry " + std::to_string(position) + " rejected: " + std::string(result.message));
+    ++position;
+
+    if (position % interval == 0 && position / interval == keyframes.size())
+        keyframes.push_back(std::make_unique<const Game>(*game));
+}
+
+void ReplayCursor::seek(uint32_t target) {
+    target = std::min(target, getNbEntries());
+
+    // Going forward within reach of the current game is cheaper than restoring a keyframe
+    size_t keyframe = std::min(target / interval, keyframes.size() - 1);
+    if (target < position || keyframe * interval > position) {
+        game = std::make_unique<Game>(*keyframes[keyframe]);
+        position = static_cast<uint32_t>(keyframe * interval);
+        if (follow)
+            follow(*game);
+    }
+
+    while (position < target)
+        stepForward();
+}
+
+bool ReplayCursor::next() {
+    if (position == getNbEntries())
+        return false;
+    stepForward();
+    return true;
+}
+
+bool ReplayCursor::previous() {
+    if (position == 0)
+        return false;
+    seek(position - 1);
+    return true;
+}
@@ -0,0 +1,228 @@
+#include "scheduler.hpp"
+#include "game.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+// Bot decisions of a seat in one game, with room to spare
+static const size_t LATENCY_ROOM = 256;
+
+GameTask& GameTask::operator=(GameTask &&other) noexcept {
+    if (this != &other) {
+        if (handle)
+            handle.destroy();
+        handle = std::exchange(other.handle, nullptr);
+    }
+    return *this;
+}
+
+GameTask::~GameTask() {
+    if (handle)
+        handle.destroy();
+}
+
+void GameTask::rethrow() const {
+    if (handle && handle.promise().exception)
+        std::rethrow_exception(handle.promise().exception);
+}
+
+void Scheduler::start(const GameTask &task) {
+    // A game is queued once at a time, but games resumed by runReady stay queued while they post again
+    ++nbStarted;
+    if (ready.capacity() < 2 * nbStarted)
+        ready.reserve(4 * nbStarted);
+    {
+        std::lock_guard<std::mutex> lock(inboxMutex);
+        if (inbox.capacity() < nbStarted)
+            inbox.reserve(2 * nbStarted);
+    }
+    post(task.getHandle());
+}
+
+void Scheduler::postFromThread(std::coroutine_handle<> handle) {
+    {
+        std::lock_guard<std::mutex> lock(inboxMutex);
+        inbox.push_back(handle);
+    }
+    inboxReady.notify_one();
+    if (wakeup)
+        wakeup();
+}
+
+void Scheduler::collect() {
+    std::lock_guard<std::mutex> lock(inboxMutex);
+    for (std::coroutine_handle<> handle : inbox)
+        ready.push_back(handle);
+    nbAway -= inbox.size();
+    inbox.clear();
+}
+
+size_t Scheduler::runReady() {
+    if (nbAway > 0)
+        collect();
+
+    // Coroutines posted while running wait for the next call
+    size_t count = ready.size();
+    for (size_t i = 0; i < count; ++i)
+        ready[i].resume();
+    ready.erase(ready.begin(), ready.begin() + static_cast<std::ptrdiff_t>(count));
+    return count;
+}
+
+void Scheduler::run() {
+    while (!ready.empty() || nbAway > 0) {
+        if (ready.empty()) {
+            std::unique_lock<std::mutex> lock(inboxMutex);
+            inboxReady.wait(lock, [this] { return !inbox.empty(); });
+        }
+        runReady();
+    }
+}
+
+DecisionPool::DecisionPool(size_t nbWorkers, size_t capacity) {
+    for (size_t i = 0; i < std::max<size_t>(nbWorkers, 1); ++i) {
+        queues.push_back(std::make_unique<Queue>());
+        queues.back()->jobs.reserve(capacity);
+    }
+    for (size_t i = 0; i < queues.size(); ++i)
+        workers.emplace_back([this, i] { work(i); });
+}
+
+DecisionPool::~DecisionPool() {
+    {
+        std::lock_guard<std::mutex> lock(idleMutex);
+        bStopping = true;
+    }
+    wake.notify_all();
+    for (std::thread &worker : workers)
+        worker.join();
+}
+
+void DecisionPool::submit(const Job &job) {
+    Queue &queue = *queues[nextQueue++ % queues.size()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.jobs.size() == queue.jobs.capacity() && queue.head > 0) {
+            queue.jobs.erase(queue.jobs.begin(), queue.jobs.begin() + static_cast<std::ptrdiff_t>(queue.head));
+            queue.head = 0;
+        }
+        queue.jobs.push_back(job);
+    }
+    {
+        // Counted under the idle lock, so that a worker about to sleep sees it
+        std::lock_guard<std::mutex> lock(idleMutex);
+        ++nbQueued;
+    }
+    wake.notify_one();
+}
+
+bool DecisionPool::take(size_t index, Job &job) {
+    for (size_t k = 0; k < queues.size(); ++k) {
+        Queue &queue = *queues[(index + k) % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.head == queue.jobs.size())
+            continue;
+
+        job = queue.jobs[queue.head++];
+        --nbQueued;
+        if (k > 0)
+            ++nbStolen;
+        return true;
+    }
+    return false;
+}
+
+void DecisionPool::work(size_t index) {
+    Job job;
+    while (true) {
+        if (!take(index, job)) {
+            std::unique_lock<std::mutex> lock(idleMutex);
+            wake.wait(lock, [this] { return bStopping || nbQueued > 0; });
+            if (bStopping && nbQueued == 0)
+                return;
+            continue;
+        }
+
+        if (job.deadline.passed())
+            ++nbLate;
+
+        // A failing bot answers with an empty decision, which the game rejects and reports on its own thread
+        try {
+            *job.decision = job.bot->decide(*job.game, job.deadline);
+        } catch (...) {
+            *job.decision = Decision{job.game->pendingDecision().type};
+        }
+        job.scheduler->postFromThread(job.handle);
+    }
+}
+
+Seat::Seat(Scheduler &scheduler, const Bot &bot) : scheduler(scheduler), bot(bot) {
+    latencies.reserve(LATENCY_ROOM);
+}
+
+void Seat::setBot(const Bot &newBot) {
+    bot = newBot;
+    latencies.reserve(LATENCY_ROOM);
+    if (waiting) {
+        requested = Deadline::Clock::now();
+        deliver(bot->decide(*waitingGame, scheduler.deadlineFrom(requested)));
+    }
+}
+
+void Seat::deliver(const Decision &newDecision) {
+    // Only a waiting game can take a decision
+    if (!waiting)
+        return;
+
+    decision = newDecision;
+    std::coroutine_handle<> handle = std::exchange(waiting, nullptr);
+    waitingGame = nullptr;
+    scheduler.post(handle);
+}
+
+void Seat::Awaiter::await_suspend(std::coroutine_handle<> handle) {
+    if (seat.bot) {
+        seat.requested = Deadline::Clock::now();
+        Deadline deadline = seat.scheduler.deadlineFrom(seat.requested);
+
+        if (DecisionPool *pool = seat.scheduler.getDecisionPool()) {
+            seat.scheduler.sendAway();
+            pool->submit({&*seat.bot, &game, deadline, &seat.decision, handle, &seat.scheduler});
+            return;
+        }
+
+        seat.decision = seat.bot->decide(game, deadline);
+        seat.scheduler.post(handle);
+        return;
+    }
+
+    seat.waiting = handle;
+    seat.waitingGame = &game;
+}
+
+Decision Seat::Awaiter::await_resume() {
+    Decision result = *seat.decision;
+    seat.decision.reset();
+
+    // Time to decide plus time waiting for the scheduler, as seen by the game
+    if (seat.bot) {
+        std::chrono::duration<double, std::micro> latency = Deadline::Clock::now() - seat.requested;
+        seat.latencies.push_back(latency.count());
+    }
+    return result;
+}
+
+GameTask playGame(Game &game, std::vector<Seat *> seats, SubmitCallback onSubmit) {
+    while (!game.isOver()) {
+        size_t index = game.pendingDecision().playerIndex;
+        Seat &seat = *seats[index];
+
+        Decision decision = co_await seat.decide(game);
+        SubmitResult result = game.submit(decision);
+
+        if (!result.bAccepted && seat.isBot())
+            throw std::logic_error("Bot decision rejected: " + std::string(result.message));
+
+        if (onSubmit)
+            onSubmit(index, result);
+    }
+}
@@ -0,0 +1,672 @@
+#include "server.hpp"
+#include "utils.hpp"
+
+#ifdef __linux__
+
+#include <arpa/inet.h>
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <iostream>
+#include <netinet/in.h>
+#include <stdexcept>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static std::string encodeBoard(const Game &game) {
+    const Board &board = game.getBoard();
+    std::string cells;
+    cells.reserve(board.getSize() * board.getSize() * cellCodeWidth(game.getNbPlayers()));
+
+    for (size_t x = 0; x < board.getSize(); ++x)
+        for (size_t y = 0; y < board.getSize(); ++y)
+            appendCellCode(cells, board.getCell({x, y}), game);
+
+    return cells;
+}
+
+static void setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags == -1 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) == -1)
+        throw std::runtime_error(std::string("Server: fcntl failed: ") + std::strerror(errno));
+}
+
+Server::~Server() {
+    for (auto &entry : connections)
+        ::close(entry.first);
+    if (listenFd != -1)
+        ::close(listenFd);
+    if (epollFd != -1)
+        ::close(epollFd);
+    if (wakeFd != -1)
+        ::close(wakeFd);
+    if (!unixPath.empty())
+        ::unlink(unixPath.c_str());
+}
+
+void Server::listenUnix(const std::string &path) {
+    sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path))
+        throw std::runtime_error("Server: socket path too long");
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd == -1)
+        throw std::runtime_error(std::string("Server: socket failed: ") + std::strerror(errno));
+
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    ::unlink(path.c_str());
+
+    if (bind(listenFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == -1)
+        throw std::runtime_error(std::string("Server: bind failed: ") + std::strerror(errno));
+
+    unixPath = path;
+}
+
+void Server::listenTcp(uint16_t port) {
+    listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listenFd == -1)
+        throw std::runtime_error(std::string("Server: socket failed: ") + std::strerror(errno));
+
+    int reuse = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (bind(listenFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == -1)
+        throw std::runtime_error(std::string("Server: bind failed: ") + std::strerror(errno));
+}
+
+void Server::run() {
+    if (listenFd == -1)
+        throw std::runtime_error("Server: not listening");
+
+    setNonBlocking(listenFd);
+    if (listen(listenFd, SOMAXCONN) == -1)
+        throw std::runtime_error(std::string("Server: listen failed: ") + std::strerror(errno));
+
+    epollFd = epoll_create1(0);
+    if (epollFd == -1)
+        throw std::runtime_error(std::string("Server: epoll_create1 failed: ") + std::strerror(errno));
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = listenFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event);
+
+    // Games handed back by decision threads wake the loop up
+    wakeFd = eventfd(0, EFD_NONBLOCK);
+    if (wakeFd == -1)
+        throw std::runtime_error(std::string("Server: eventfd failed: ") + std::strerror(errno));
+    event.data.fd = wakeFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+    scheduler.setWakeup([this] {
+        uint64_t one = 1;
+        ssize_t nbWritten = write(wakeFd, &one, sizeof(one));
+        (void)nbWritten; // A full counter already wakes the loop up
+    });
+
+    std::vector<epoll_event> events(256);
+    while (true) {
+        // Do not sleep while games are ready to move on
+        int timeout = scheduler.hasReady() ? 0 : -1;
+        int nbEvents = epoll_wait(epollFd, events.data(), static_cast<int>(events.size()), timeout);
+        if (nbEvents == -1) {
+            if (errno == EINTR)
+                continue;
+            throw std::runtime_error(std::string("Server: epoll_wait failed: ") + std::strerror(errno));
+        }
+
+        for (int i = 0; i < nbEvents; ++i) {
+            int fd = events[i].data.fd;
+
+            if (fd == listenFd) {
+                acceptConnections();
+                continue;
+            }
+            if (fd == wakeFd) {
+                uint64_t count;
+                ssize_t nbRead = read(wakeFd, &count, sizeof(count));
+                (void)nbRead;
+                continue;
+            }
+
+            auto it = connections.find(fd);
+            if (it == connections.end())
+                continue;
+
+            if (events[i].events & EPOLLIN)
+                receive(it->second);
+            if (events[i].events & EPOLLOUT)
+                flush(it->second);
+            if (events[i].events & (EPOLLHUP | EPOLLERR))
+                it->second.bClosing = true;
+        }
+
+        // Resume the games that received a decision, bots move one decision per iteration
+        scheduler.runReady();
+        dropFinishedTables();
+
+        // Replies and updates are queued while handling commands, then written in one go
+        std::vector<int> closing;
+        for (auto &entry : connections) {
+            if (!entry.second.out.empty())
+                flush(entry.second);
+            if (entry.second.bClosing)
+                closing.push_back(entry.first);
+        }
+        for (int fd : closing)
+            close(fd);
+    }
+}
+
+void Server::setDecisionPool(DecisionPool *pool, Deadline::Clock::duration budget) {
+    scheduler.setDecisionPool(pool);
+    scheduler.setBudget(budget);
+}
+
+void Server::watch(int fd, bool bWritable) {
+    epoll_event event{};
+    event.events = bWritable ? EPOLLIN | EPOLLOUT : EPOLLIN;
+    event.data.fd = fd;
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &event);
+}
+
+void Server::acceptConnections() {
+    while (true) {
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd == -1)
+            return; // EAGAIN : no more pending connections
+
+        setNonBlocking(fd);
+
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+
+        connections[fd].fd = fd;
+    }
+}
+
+void Server::receive(Connection &connection) {
+    char buffer[4096];
+
+    // One read per event : epoll reports the socket again while bytes are left, after the other connections
+    ssize_t nbRead = read(connection.fd, buffer, sizeof(buffer));
+    if (nbRead <= 0) {
+        if (nbRead == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+            connection.bClosing = true;
+        return;
+    }
+    connection.in.append(buffer, static_cast<size_t>(nbRead));
+
+    // Handle every complete line, keep the incomplete one for later
+    size_t start = 0;
+    size_t end;
+    while (!connection.bClosing && (end = connection.in.find('\n', start)) != std::string::npos) {
+        std::string line = connection.in.substr(start, end - start);
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        start = end + 1;
+
+        handleLine(connection, line);
+    }
+    connection.in.erase(0, start);
+
+    if (connection.in.size() > maxLineLength) {
+        send(connection.fd, "ERR 0 Line too long.");
+        connection.bClosing = true;
+    }
+}
+
+void Server::flush(Connection &connection) {
+    while (!connection.out.empty()) {
+        // Shared lines are written from where they are, several at a time
+        std::array<iovec, 64> chunks;
+        size_t nbChunks = 0;
+        for (auto it = connection.out.begin(); it != connection.out.end() && nbChunks < chunks.size(); ++it, ++nbChunks) {
+            size_t offset = nbChunks == 0 ? connection.outOffset : 0;
+            chunks[nbChunks].iov_base = const_cast<char *>((*it)->data() + offset);
+            chunks[nbChunks].iov_len = (*it)->size() - offset;
+        }
+        msghdr message{};
+        message.msg_iov = chunks.data();
+        message.msg_iovlen = nbChunks;
+
+        // MSG_NOSIGNAL : a client leaving must not kill the server with SIGPIPE
+        ssize_t nbWritten = sendmsg(connection.fd, &message, MSG_NOSIGNAL);
+        if (nbWritten > 0) {
+            size_t left = static_cast<size_t>(nbWritten);
+            while (left > 0) {
+                size_t rest = connection.out.front()->size() - connection.outOffset;
+                if (left < rest) {
+                    connection.outOffset += left;
+                    break;
+                }
+                left -= rest;
+                connection.out.pop_front();
+                connection.outOffset = 0;
+            }
+            continue;
+        }
+        if (nbWritten == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            // Wait until the socket can take more bytes
+            if (!connection.bWaitingWritable)
+                watch(connection.fd, true);
+            connection.bWaitingWritable = true;
+            return;
+        }
+        connection.bClosing = true;
+        return;
+    }
+
+    if (connection.bWaitingWritable)
+        watch(connection.fd, false);
+    connection.bWaitingWritable = false;
+}
+
+void Server::close(int fd) {
+    // Free any seat held by that connection, games keep waiting for a new player
+    for (uint32_t id : connections[fd].tables) {
+        auto it = tables.find(id);
+        if (it == tables.end())
+            continue;
+
+        Table &table = it->second;
+        for (int &seat : table.seatConnections)
+            if (seat == fd)
+                seat = -1;
+        std::erase(table.members, fd);
+        std::erase(table.spectators, fd);
+
+        // Finished games are dropped once nobody follows them anymore
+        if (table.members.empty() && table.spectators.empty() && table.game->isOver())
+            tables.erase(it);
+    }
+
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+    connections.erase(fd);
+}
+
+void Server::send(int fd, const std::string &line) {
+    share(fd, std::make_shared<const std::string>(line + "\n"));
+}
+
+void Server::share(int fd, const SharedLine &line) {
+    auto it = connections.find(fd);
+    if (it != connections.end())
+        it->second.out.push_back(line);
+}
+
+void Server::broadcast(const Table &table, const std::string &line) {
+    SharedLine shared = std::make_shared<const std::string>(line + "\n");
+    for (int fd : table.members)
+        share(fd, shared);
+    for (int fd : table.spectators)
+        share(fd, shared);
+}
+
+void Server::publish(uint32_t id, Table &table, const std::string &notices) {
+    const Game &game = *table.game;
+    std::string prefix = " " + std::to_string(id);
+
+    // Only send the cells that changed since the last update, as reported by the board
+    std::string changes;
+    size_t size = game.getBoard().getSize();
+    for (uint32_t cell : table.feed->changedCells()) {
+        changes += " " + std::to_string(cell / size) + "," + std::to_string(cell % size) + ",";
+        appendCellCode(changes, game.getBoard().getCell({cell / size, cell % size}), game);
+    }
+
+    if (!changes.empty()) {
+        SharedLine line = std::make_shared<const std::string>("CELLS" + prefix + changes + "\n");
+        for (int fd : table.members)
+            share(fd, line);
+    }
+
+    SharedLine delta = table.feed->update();
+    for (int fd : table.spectators)
+        share(fd, delta);
+
+    std::istringstream lines(notices);
+    std::string notice;
+    while (std::getline(lines, notice))
+        broadcast(table, "NOTICE" + prefix + " " + notice);
+
+    if (game.isOver()) {
+        const Player &winner = game.determineWinner();
+        size_t seat = static_cast<size_t>(&winner - game.getPlayers().data()) + 1;
+        broadcast(table, "OVER" + prefix + " " + std::to_string(seat) + " " + winner.getName());
+        return;
+    }
+
+    if (game.getCurrentTile().has_value()) {
+        const Shape &shape = game.getCurrentTile()->getShape();
+        std::string line = "TILE" + prefix + " " + std::to_string(shape.size());
+        for (const auto &row : shape) {
+            line += " ";
+            for (uint8_t cell : row)
+                line += cell ? '1' : '0';
+        }
+        broadcast(table, line);
+    }
+
+    const PendingDecision &pending = game.pendingDecision();
+    broadcast(table, "PENDING" + prefix + " " + std::to_string(pending.playerIndex + 1) + " "
+                         + decisionTypeToString(pending.type) + " " + std::to_string(pending.min) + " "
+                         + std::to_string(pending.max));
+}
+
+void Server::handleLine(Connection &connection, const std::string &line) {
+    std::istringstream args(line);
+    std::string command;
+    args >> command;
+
+    if (command.empty())
+        return;
+    if (command == "NEW")
+        createTable(connection, args);
+    else if (command == "JOIN")
+        joinTable(connection, args);
+    else if (command == "WATCH")
+        watchTable(connection, args);
+    else if (command == "BOT")
+        addBot(connection, args);
+    else if (command == "DECIDE")
+        decide(connection, args);
+    else if (command == "QUIT")
+        connection.bClosing = true;
+    else
+        send(connection.fd, "ERR 0 Unknown command.");
+}
+
+void Server::createTable(Connection &connection, std::istringstream &args) {
+    int nbPlayers = 0;
+    if (!(args >> nbPlayers) || nbPlayers < static_cast<int>(Game::minPlayers) || nbPlayers > static_cast<int>(Game::maxPlayers)) {
+        send(connection.fd, "ERR 0 Number of players must be between " + std::to_string(Game::minPlayers) + " and "
+                            + std::to_string(Game::maxPlayers) + ".");
+        return;
+    }
+
+    uint32_t id = nextTableId++;
+    openTable(id, std::make_unique<Game>(static_cast<size_t>(nbPlayers)));
+
+    send(connection.fd, "GAME " + std::to_string(id));
+}
+
+Table& Server::openTable(uint32_t id, std::unique_ptr<Game> game) {
+    Table &table = tables[id];
+    size_t nbPlayers = game->getNbPlayers();
+    table.game = std::move(game);
+    table.game->setRecorder(recorder);
+    table.seatConnections.assign(nbPlayers, -1);
+    table.feed = std::make_unique<SpectatorFeed>(id, *table.game);
+
+    std::vector<Seat *> seats;
+    for (size_t i = 0; i < nbPlayers; ++i) {
+        table.seats.push_back(std::make_unique<Seat>(scheduler));
+        seats.push_back(table.seats.back().get());
+    }
+
+    table.task = playGame(*table.game, seats, [this, id](size_t seat, const SubmitResult &result) {
+        onSubmit(id, seat, result);
+    });
+    scheduler.start(table.task);
+    return table;
+}
+
+std::string Server::checkpointPath(uint32_t id) const {
+    return checkpointDirectory + "/table-" + std::to_string(id) + ".lgs";
+}
+
+void Server::checkpoint(uint32_t id, const Table &table) {
+    // A failed save only loses resumability, the game goes on
+    try {
+        if (table.game->isOver())
+            std::filesystem::remove(checkpointPath(id));
+        else
+            table.game->save(checkpointPath(id));
+    } catch (const std::exception &e) {
+        std::cerr << "Checkpoint of game " << id << " failed: " << e.what() << std::endl;
+    }
+}
+
+size_t Server::resumeTables() {
+    size_t count = 0;
+
+    for (const auto &entry : std::filesystem::directory_iterator(checkpointDirectory)) {
+        std::string name = entry.path().filename().string();
+        if (name.rfind("table-", 0) != 0 || entry.path().extension() != ".lgs")
+            continue;
+
+        uint32_t id = static_cast<uint32_t>(std::strtoul(name.c_str() + 6, nullptr, 10));
+        if (id == 0 || tables.count(id))
+            continue;
+
+        try {
+            openTable(id, std::make_unique<Game>(Snapshot(entry.path().string())));
+            nextTableId = std::max(nextTableId, id + 1);
+            ++count;
+        } catch (const std::exception &e) {
+            std::cerr << "Cannot resume " << name << ": " << e.what() << std::endl;
+        }
+    }
+
+    return count;
+}
+
+void Server::joinTable(Connection &connection, std::istringstream &args) {
+    uint32_t id = 0;
+    args >> id;
+
+    auto it = tables.find(id);
+    if (it == tables.end()) {
+        send(connection.fd, "ERR " + std::to_string(id) + " No such game.");
+        return;
+    }
+    Table &table = it->second;
+
+    // Take the requested seat, or the first free one
+    int seat = 0;
+    if (args >> seat) {
+        if (seat < 1 || seat > static_cast<int>(table.seats.size()) || table.seatConnections[seat - 1] != -1
+            || table.seats[seat - 1]->isBot()) {
+            send(connection.fd, "ERR " + std::to_string(id) + " Seat not available.");
+            return;
+        }
+    } else {
+        for (size_t i = 0; i < table.seats.size() && seat == 0; ++i)
+            if (table.seatConnections[i] == -1 && !table.seats[i]->isBot())
+                seat = static_cast<int>(i) + 1;
+        if (seat == 0) {
+            send(connection.fd, "ERR " + std::to_string(id) + " Game is full.");
+            return;
+        }
+    }
+
+    table.seatConnections[seat - 1] = connection.fd;
+    bool bMember = false;
+    for (int fd : table.members)
+        bMember = bMember || fd == connection.fd;
+    if (!bMember) {
+        // A spectator taking a seat becomes a member
+        std::erase(table.spectators, connection.fd);
+        table.members.push_back(connection.fd);
+        if (std::find(connection.tables.begin(), connection.tables.end(), id) == connection.tables.end())
+            connection.tables.push_back(id);
+    }
+
+    size_t size = table.game->getBoard().getSize();
+    send(connection.fd, "JOINED " + std::to_string(id) + " " + std::to_string(seat));
+    send(connection.fd, "BOARD " + std::to_string(id) + " " + std::to_string(size) + " " + encodeBoard(*table.game));
+
+    const PendingDecision &pending = table.game->pendingDecision();
+    send(connection.fd, "PENDING " + std::to_string(id) + " " + std::to_string(pending.playerIndex + 1) + " "
+                            + decisionTypeToString(pending.type) + " " + std::to_string(pending.min) + " "
+                            + std::to_string(pending.max));
+}
+
+void Server::watchTable(Connection &connection, std::istringstream &args) {
+    uint32_t id = 0;
+    args >> id;
+
+    auto it = tables.find(id);
+    if (it == tables.end()) {
+        send(connection.fd, "ERR " + std::to_string(id) + " No such game.");
+        return;
+    }
+    Table &table = it->second;
+
+    // Members already receive every update of their table
+    if (std::find(table.spectators.begin(), table.spectators.end(), connection.fd) != table.spectators.end()
+        || std::find(table.members.begin(), table.members.end(), connection.fd) != table.members.end()) {
+        send(connection.fd, "ERR " + std::to_string(id) + " Already following this game.");
+        return;
+    }
+    table.spectators.push_back(connection.fd);
+    if (std::find(connection.tables.begin(), connection.tables.end(), id) == connection.tables.end())
+        connection.tables.push_back(id);
+
+    // The last keyframe and the deltas after it are already encoded, they are shared as they are
+    send(connection.fd, "WATCHING " + std::to_string(id));
+    for (const SharedLine &line : table.feed->catchUp())
+        share(connection.fd, line);
+
+    const Game &game = *table.game;
+    if (game.isOver()) {
+        const Player &winner = game.determineWinner();
+        size_t seat = static_cast<size_t>(&winner - game.getPlayers().data()) + 1;
+        send(connection.fd, "OVER " + std::to_string(id) + " " + std::to_string(seat) + " " + winner.getName());
+        return;
+    }
+    const PendingDecision &pending = game.pendingDecision();
+    send(connection.fd, "PENDING " + std::to_string(id) + " " + std::to_string(pending.playerIndex + 1) + " "
+                            + decisionTypeToString(pending.type) + " " + std::to_string(pending.min) + " "
+                            + std::to_string(pending.max));
+}
+
+void Server::addBot(Connection &connection, std::istringstream &args) {
+    uint32_t id = 0;
+    args >> id;
+
+    auto it = tables.find(id);
+    if (it == tables.end()) {
+        send(connection.fd, "ERR " + std::to_string(id) + " No such game.");
+        return;
+    }
+    Table &table = it->second;
+
+    // Take the requested seat, or the first free one
+    size_t seat = 0;
+    int requested = 0;
+    if (args >> requested) {
+        if (requested >= 1 && requested <= static_cast<int>(table.seats.size()))
+            seat = static_cast<size_t>(requested);
+    } else {
+        for (size_t i = 0; i < table.seats.size() && seat == 0; ++i)
+            if (table.seatConnections[i] == -1 && !table.seats[i]->isBot())
+                seat = i + 1;
+    }
+
+    if (seat == 0 || table.seatConnections[seat - 1] != -1 || table.seats[seat - 1]->isBot()) {
+        send(connection.fd, "ERR " + std::to_string(id) + " Seat not available.");
+        return;
+    }
+
+    table.seats[seat - 1]->setBot(Bot());
+    send(connection.fd, "OK " + std::to_string(id));
+}
+
+void Server::decide(Connection &connection, std::istringstream &args) {
+    uint32_t id = 0;
+    args >> id;
+
+    auto it = tables.find(id);
+    if (it == tables.end()) {
+        send(connection.fd, "ERR " + std::to_string(id) + " No such game.");
+        return;
+    }
+    Table &table = it->second;
+    Game &game = *table.game;
+    std::string prefix = " " + std::to_string(id);
+
+    const PendingDecision &pending = game.pendingDecision();
+    if (game.isOver() || table.seatConnections[pending.playerIndex] != connection.fd
+        || !table.seats[pending.playerIndex]->isWaiting()) {
+        send(connection.fd, "ERR" + prefix + " Not your turn.");
+        return;
+    }
+
+    Decision decision{pending.type};
+    bool bParsed = true;
+    switch (pending.type) {
+    case CHOOSE_NAME:
+        std::getline(args >> std::ws, decision.text);
+        break;
+    case CHOOSE_COLOR:
+    case TAKE_OR_EXCHANGE:
+    case EXCHANGE_KIND:
+    case EXCHANGE_TILE:
+    case ORIENT_TILE:
+        bParsed = static_cast<bool>(args >> decision.choice);
+        break;
+    default:
+        bParsed = static_cast<bool>(args >> decision.coords.first >> decision.coords.second);
+        break;
+    }
+
+    if (!bParsed) {
+        send(connection.fd, "ERR" + prefix + " Invalid input.");
+        return;
+    }
+
+    // The table's coroutine submits it when the scheduler resumes it
+    table.seats[pending.playerIndex]->deliver(decision);
+}
+
+void Server::onSubmit(uint32_t id, size_t seat, const SubmitResult &result) {
+    Table &table = tables.at(id);
+    std::string prefix = " " + std::to_string(id);
+    int fd = table.seatConnections[seat];
+
+    if (!result.bAccepted) {
+        if (fd != -1)
+            send(fd, "ERR" + prefix + " " + std::string(result.message));
+        return;
+    }
+
+    if (fd != -1)
+        send(fd, "OK" + prefix);
+    publish(id, table, std::string(result.message));
+
+    if (!checkpointDirectory.empty())
+        checkpoint(id, table);
+
+    if (table.game->isOver())
+        finishedTables.push_back(id);
+}
+
+void Server::dropFinishedTables() {
+    // Finished games nobody follows anymore, the others are dropped when their last member leaves
+    for (uint32_t id : finishedTables) {
+        auto it = tables.find(id);
+        if (it != tables.end() && it->second.members.empty() && it->second.spectators.empty() && it->second.task.done())
+            tables.erase(it);
+    }
+    finishedTables.clear();
+}
+
+#endif
@@ -0,0 +1,58 @@
+#include "snapshot.hpp"
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+static size_t align8(size_t offset) {
+    return (offset + 7) & ~size_t(7);
+}
+
+SnapshotLayout::SnapshotLayout(const SnapshotHeader &header) {
+    players = sizeof(SnapshotHeader);
+    cells = align8(players + header.nbSeated * sizeof(SnapshotPlayer));
+    placedTiles = align8(cells + size_t(header.boardSize) * header.boardSize * sizeof(SnapshotCell));
+    queueTiles = align8(placedTiles + header.nbPlacedTiles * sizeof(SnapshotTile));
+    entries = align8(queueTiles + header.nbQueueTiles * sizeof(SnapshotTile));
+    size = align8(entries + header.nbEntries * sizeof(RecordEntry));
+}
+
+uint32_t snapshotChecksum(const char *data, size_t size) {
+    uint32_t sum = 0;
+    for (size_t i = sizeof(SnapshotHeader); i < size; ++i)
+        sum += static_cast<uint8_t>(data[i]);
+    return sum;
+}
+
+void writeSnapshotFile(const std::string &path, const std::vector<char> &data) {
+    std::string temporary = path + ".tmp";
+
+    std::FILE *file = std::fopen(temporary.c_str(), "wb");
+    if (!file)
+        throw std::runtime_error("Cannot open snapshot file " + temporary);
+
+    bool bWritten = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+    bWritten = std::fclose(file) == 0 && bWritten;
+    if (!bWritten) {
+        std::remove(temporary.c_str());
+        throw std::runtime_error("Cannot write snapshot file " + temporary);
+    }
+
+    if (!replaceFile(temporary, path))
+        throw std::runtime_error("Cannot replace snapshot file " + path);
+}
+
+Snapshot::Snapshot(const std::string &path) : file(path) {
+    if (file.getSize() < sizeof(SnapshotHeader))
+        throw std::runtime_error("Not a game snapshot: " + path);
+
+    header = reinterpret_cast<const SnapshotHeader *>(file.getData());
+    if (std::memcmp(header->magic, "LGS1", 4) != 0)
+        throw std::runtime_error("Not a game snapshot: " + path);
+    if (header->version != SNAPSHOT_VERSION)
+        throw std::runtime_error("Unsupported snapshot version: " + path);
+
+    if (SnapshotLayout(*header).size != header->size || header->size != file.getSize())
+        throw std::runtime_error("Truncated game snapshot: " + path);
+    if (snapshotChecksum(file.getData(), file.getSize()) != header->checksum)
+        throw std::runtime_error("Corrupted game snapshot: " + path);
+}
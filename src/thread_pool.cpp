@@ -0,0 +1,108 @@
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <cstdlib>
+
+static thread_local bool bInsideTask = false;
+
+ThreadPool::ThreadPool(size_t nbWorkers) {
+    for (size_t i = 0; i < nbWorkers; ++i)
+        workers.emplace_back([this] { work(); });
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        bStopping = true;
+    }
+    wake.notify_all();
+    for (std::thread &worker : workers)
+        worker.join();
+}
+
+ThreadPool& ThreadPool::shared() {
+    // LAYINGRASS_THREADS overrides the number of cores
+    static ThreadPool pool([] {
+        const char *threads = std::getenv("LAYINGRASS_THREADS");
+        size_t nbThreads = threads ? std::strtoul(threads, nullptr, 10) : std::thread::hardware_concurrency();
+        return std::max<size_t>(1, nbThreads) - 1;
+    }());
+    return pool;
+}
+
+void ThreadPool::runTasks(const void *loopTask, Invoker loopInvoke, size_t loopSize) {
+    bInsideTask = true;
+    for (size_t i = nextTask++; i < loopSize; i = nextTask++) {
+        try {
+            loopInvoke(loopTask, i);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!error)
+                error = std::current_exception();
+        }
+    }
+    bInsideTask = false;
+}
+
+void ThreadPool::work() {
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true) {
+        wake.wait(lock, [&] { return bStopping || generation != seen; });
+        if (bStopping)
+            return;
+        seen = generation;
+
+        // The loop is copied while locked, a worker waking late finds it empty
+        const void *loopTask = task;
+        Invoker loopInvoke = invoke;
+        size_t loopSize = nbTasks;
+        if (!loopTask)
+            continue;
+
+        ++nbBusy;
+        lock.unlock();
+        runTasks(loopTask, loopInvoke, loopSize);
+        lock.lock();
+        if (--nbBusy == 0)
+            done.notify_one();
+    }
+}
+
+void ThreadPool::run(size_t count, const void *loopTask, Invoker loopInvoke) {
+    if (count == 0)
+        return;
+
+    // Nothing to share, or nested in a task: run in place
+    if (workers.empty() || count == 1 || bInsideTask) {
+        for (size_t i = 0; i < count; ++i)
+            loopInvoke(loopTask, i);
+        return;
+    }
+
+    std::lock_guard<std::mutex> loopLock(loopMutex);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        task = loopTask;
+        invoke = loopInvoke;
+        nbTasks = count;
+        nextTask = 0;
+        error = nullptr;
+        ++generation;
+    }
+    wake.notify_all();
+
+    runTasks(loopTask, loopInvoke, count);
+
+    std::exception_ptr loopError;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&] { return nbBusy == 0; });
+        task = nullptr;
+        nbTasks = 0;
+        loopError = error;
+    }
+
+    if (loopError)
+        std::rethrow_exception(loopError);
+}
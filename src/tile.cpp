@@ -1,6 +1,17 @@
 #include "tile.hpp"
 #include <algorithm>
 #include <iostream>
+#include <stdexcept>
+
+Tile Tile::fromId(uint8_t id, uint8_t orientation) {
+    if (id != STARTING_TILE_ID && id >= TILE_SHAPES.size())
+        throw std::out_of_range("Tile::fromId: unknown shape");
+
+    Tile tile(id);
+    tile.rotation = (orientation & 3) * 90;
+    tile.flipped = orientation & 4;
+    return tile;
+}
 
 Shape Tile::rotateShape(const Shape &shape) {
     size_t rows = shape.size();
@@ -15,17 +26,30 @@ Shape Tile::rotateShape(const Shape &shape) {
     return rotated;
 }
 
-Shape Tile::getShape() const {
-    Shape shape = baseShape;
-
-    for (int i = 0; i < rotation / 90; ++i)
-        shape = rotateShape(shape);
-
-    if (flipped)
-        for (auto &row : shape)
-            std::reverse(row.begin(), row.end());
+// The starting tile comes after TILE_SHAPES. Computed on first use, once for every thread.
+const std::vector<Shape>& Tile::orientedShapes() {
+    static const std::vector<Shape> shapes = [] {
+        std::vector<Shape> oriented;
+        for (size_t id = 0; id <= TILE_SHAPES.size(); ++id) {
+            const Shape &base = id < TILE_SHAPES.size() ? TILE_SHAPES[id] : STARTING_TILE;
+            for (uint8_t orientation = 0; orientation < 8; ++orientation) {
+                Shape shape = base;
+                for (int i = 0; i < (orientation & 3); ++i)
+                    shape = rotateShape(shape);
+                if (orientation & 4)
+                    for (auto &row : shape)
+                        std::reverse(row.begin(), row.end());
+                oriented.push_back(std::move(shape));
+            }
+        }
+        return oriented;
+    }();
+    return shapes;
+}
 
-    return shape;
+const Shape& Tile::getShape() const {
+    size_t index = id == STARTING_TILE_ID ? TILE_SHAPES.size() : id;
+    return orientedShapes()[8 * index + getOrientation()];
 }
 
 void Tile::print() const {
@@ -5,63 +5,79 @@
 #include <stdexcept>
 #include <iostream>
 
-TileQueue::TileQueue(size_t nbPlayers) {
+TileQueue::TileQueue(size_t nbPlayers, uint64_t seed) {
     size_t nbTiles = (nbPlayers * 32 + 1) / 3; // 32 / 3 = 10.67 tiles per player, + 1 for rounding
 
     // Make a shuffled list of indices to select random shapes
     std::vector<size_t> indices(TILE_SHAPES.size());
     std::iota(indices.begin(), indices.end(), 0); // Fills indices with 0..N-1
-    std::shuffle(indices.begin(), indices.end(), std::mt19937{std::random_device{}()});
+    std::seed_seq seq{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32), 1u};
+    std::mt19937 gen(seq);
+
+    // Large games go through the shapes again, each cycle in a new order
+    tiles.reserve(nbTiles);
+    while (tiles.size() < nbTiles) {
+        std::shuffle(indices.begin(), indices.end(), gen);
+        for (size_t i = 0; tiles.size() < nbTiles && i < indices.size(); ++i)
+            tiles.push_back(Tile::fromId(static_cast<uint8_t>(indices[i])));
+    }
+    reserveRoom();
+}
 
-    for (size_t i = 0; i < nbTiles && i < indices.size(); ++i)
-        tiles.emplace_back(Tile(TILE_SHAPES[indices[i]]));
+TileQueue::TileQueue(std::vector<Tile> tiles) : tiles(std::move(tiles)) {
+    reserveRoom();
+}
+
+TileQueue::TileQueue(const TileQueue &other) : tiles(other.tiles), head(other.head) {
+    tiles.reserve(other.tiles.capacity());
+}
+
+void TileQueue::reserveRoom() {
+    // A turn puts at most one tile back for each one it draws, the queue never holds more than one extra tile
+    tiles.reserve(2 * (tiles.size() + 1));
+}
+
+void TileQueue::compact() {
+    if (tiles.size() < tiles.capacity() || head == 0)
+        return;
+    tiles.erase(tiles.begin(), tiles.begin() + static_cast<std::ptrdiff_t>(head));
+    head = 0;
 }
 
 Tile TileQueue::drawTile() {
-    if (tiles.empty())
+    if (head == tiles.size())
         throw std::out_of_range("No more tiles to draw.");
 
-    Tile drawnTile = tiles.front();
-    tiles.pop_front();
-    return drawnTile;
+    return tiles[head++];
+}
+
+void TileQueue::pushBack(const Tile &tile) {
+    compact();
+    tiles.push_back(tile);
 }
 
 Tile TileQueue::exchangeTile(int index) {
     if (index < 0 ||
-        static_cast<size_t>(index) >= tiles.size()) // Casting to size_t for STL compatibility
+        static_cast<size_t>(index) >= tiles.size() - head) // Casting to size_t for STL compatibility
         throw std::out_of_range("Tile index out of range.");
 
-    // Move all tiles before the chosen one to the back of the deque
+    // Move all tiles before the chosen one to the back of the queue
     for (size_t i = 0; i < static_cast<size_t>(index); i++) {
-        tiles.push_back(tiles.front());
-        tiles.pop_front();
+        Tile front = tiles[head++];
+        pushBack(front);
     }
 
-    Tile chosen = tiles.front();
-    tiles.pop_front();
-
-    return chosen;
-}
-
-std::vector<std::reference_wrapper<const Tile>> TileQueue::nextTiles(size_t n) const {
-    std::vector<std::reference_wrapper<const Tile>> nextTiles;
-
-    size_t count = std::min(n, tiles.size()); // Ensure we don't exceed available tiles
-
-    for (size_t i = 0; i < count; ++i)
-        nextTiles.push_back(std::cref(tiles[i])); // Store constant references
-
-    return nextTiles;
+    return tiles[head++];
 }
 
-void TileQueue::printExchangeQueue(const std::vector<std::reference_wrapper<const Tile>> &tiles) const {
+void TileQueue::printExchangeQueue(std::span<const Tile> tiles) const {
     if (tiles.empty())
         return;
 
     // Determine the maximum height of the tiles to align them properly
     size_t maxHeight = 0;
     for (const auto &tile : tiles) {
-        const Shape &shape = tile.get().getShape();
+        const Shape &shape = tile.getShape();
         if (shape.size() > maxHeight)
             maxHeight = shape.size();
     }
@@ -69,7 +85,7 @@ void TileQueue::printExchangeQueue(const std::vector<std::reference_wrapper<cons
     // Print each row of the tiles
     for (size_t row = 0; row < maxHeight; ++row) {
         for (const auto &tile : tiles) {
-            const Shape &shape = tile.get().getShape();
+            const Shape &shape = tile.getShape();
             if (shape.empty())
                 continue;
 
@@ -1,5 +1,8 @@
 #include "utils.hpp"
+#include <algorithm>
+#include <cctype>
 #include <limits>
+#include <stdexcept>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -33,6 +36,25 @@ std::string playerColorToString(PlayerColor color) {
     }
 }
 
+std::string decisionTypeToString(DecisionType type) {
+    switch (type) {
+        case CHOOSE_NAME: return "CHOOSE_NAME";
+        case CHOOSE_COLOR: return "CHOOSE_COLOR";
+        case PLACE_STARTING_TILE: return "PLACE_STARTING_TILE";
+        case TAKE_OR_EXCHANGE: return "TAKE_OR_EXCHANGE";
+        case EXCHANGE_KIND: return "EXCHANGE_KIND";
+        case EXCHANGE_TILE: return "EXCHANGE_TILE";
+        case REMOVE_STONE: return "REMOVE_STONE";
+        case ORIENT_TILE: return "ORIENT_TILE";
+        case PLACE_TILE: return "PLACE_TILE";
+        case PLACE_STONE: return "PLACE_STONE";
+        case ROB_TILE: return "ROB_TILE";
+        case PLACE_COUPON_TILE: return "PLACE_COUPON_TILE";
+        case GAME_OVER: return "GAME_OVER";
+        default: return "UNKNOWN";
+    }
+}
+
 Colorize colorize(PlayerColor color) {
     return Colorize(color);
 }
@@ -66,6 +88,21 @@ std::ostream& operator<<(std::ostream& os, const Colorize& c) {
     }
 }
 
+static size_t nbInvalidInputs = 0;
+
+size_t getNbInvalidInputs() {
+    return nbInvalidInputs;
+}
+
+void countInvalidInput() {
+    ++nbInvalidInputs;
+}
+
+void checkEndOfInput() {
+    if (std::cin.eof())
+        throw std::runtime_error("End of input");
+}
+
 int letterToIndex(char c) {
     if (c >= 'A' && c <= 'Z')
         return c - 'A';           // A–Z → 0–25
@@ -74,13 +111,25 @@ int letterToIndex(char c) {
     return -1;
 }
 
+int coordinateToIndex(const std::string &input) {
+    if (input.size() == 1 && letterToIndex(input[0]) != -1)
+        return letterToIndex(input[0]);
+
+    // Boards larger than the alphabet are addressed with numbers
+    if (input.empty() || input.size() > 5 || !std::all_of(input.begin(), input.end(), ::isdigit))
+        return -1;
+    return std::stoi(input);
+}
+
 std::pair<size_t, size_t> getCoordinatesInput(size_t max) {
     while (true) {
         std::string rowInput, colInput;
         std::cout << "Enter coordinates (row column): ";
         std::cin >> rowInput >> colInput;
 
-        if (std::cin.fail() || rowInput.size() != 1 || colInput.size() != 1) {
+        if (std::cin.fail()) {
+            checkEndOfInput();
+            countInvalidInput();
             std::cin.clear();
             std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
             std::cout << "Invalid input. Try again." << std::endl
@@ -88,21 +137,24 @@ std::pair<size_t, size_t> getCoordinatesInput(size_t max) {
             continue;
         }
 
-        int x = letterToIndex(rowInput[0]);
-        int y = letterToIndex(colInput[0]);
+        int x = coordinateToIndex(rowInput);
+        int y = coordinateToIndex(colInput);
 
-        // On letterToIndex failure
+        // On coordinateToIndex failure
         if (x == -1 || y == -1) {
-            std::cout << "Coordinates must be letters (A–Z or a–d). Try again." << std::endl << std::endl;
+            countInvalidInput();
+            std::cout << "Coordinates must be letters (A–Z or a–z) or numbers. Try again." << std::endl << std::endl;
             continue;
         }
 
         if (x >= static_cast<int>(max) || y >= static_cast<int>(max)) {
+            countInvalidInput();
             std::cout << "Coordinates out of range. Try again." << std::endl << std::endl;
             continue;
         }
 
-        if (std::cin.peek() != '\n') {
+        if (std::cin.peek() != '\n' && !std::cin.eof()) {
+            countInvalidInput();
             std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
             std::cout << "Extra characters detected. Try again." << std::endl
                       << std::endl;
@@ -121,6 +173,8 @@ int getIntegerInputInRange(const std::string &prompt, int min, int max) {
         std::cin >> x;
 
         if (std::cin.fail() || x < min || x > max) {
+            checkEndOfInput();
+            countInvalidInput();
             std::cin.clear();
             std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
             std::cout << "Invalid input. Try again." << std::endl
@@ -128,7 +182,8 @@ int getIntegerInputInRange(const std::string &prompt, int min, int max) {
             continue;
         }
 
-        if (std::cin.peek() != '\n') {
+        if (std::cin.peek() != '\n' && !std::cin.eof()) {
+            countInvalidInput();
             std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
             std::cout << "Extra characters detected. Try again." << std::endl
                       << std::endl;
@@ -0,0 +1,348 @@
+#include "game.hpp"
+#include "record.hpp"
+#include "replay.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static const size_t MAX_ROUNDS = 16; // Rounds counted separately, later ones count as the last
+
+/**
+Statistics of a set of games, one per chunk of games so that threads never share one.
+*/
+struct Accumulator {
+    uint64_t nbGames = 0;
+    uint64_t nbEntries = 0;
+    uint64_t nbFailed = 0;
+
+    // Board size -> games, then for each cell the games where it is in the winner's largest square
+    std::map<size_t, std::vector<uint64_t>> heat;
+    std::map<size_t, uint64_t> gamesOfSize;
+
+    // Tile id -> placements, placements by the winner, cells still in the winner's largest square at the end
+    std::array<std::array<uint64_t, 3>, 256> tiles{};
+
+    // Bonus, round -> captures, captures by the winner
+    std::array<std::array<std::array<uint64_t, 2>, MAX_ROUNDS>, 3> captures{};
+
+    // Round -> exchanged tiles, removed stones, coupon tiles, any of them by the winner
+    std::array<std::array<uint64_t, 4>, MAX_ROUNDS> coupons{};
+
+    void merge(const Accumulator &other);
+};
+
+void Accumulator::merge(const Accumulator &other) {
+    nbGames += other.nbGames;
+    nbEntries += other.nbEntries;
+    nbFailed += other.nbFailed;
+    for (const auto &[size, counts] : other.heat) {
+        std::vector<uint64_t> &mine = heat[size];
+        mine.resize(counts.size(), 0);
+        for (size_t i = 0; i < counts.size(); ++i)
+            mine[i] += counts[i];
+    }
+    for (const auto &[size, count] : other.gamesOfSize)
+        gamesOfSize[size] += count;
+    for (size_t t = 0; t < tiles.size(); ++t)
+        for (size_t i = 0; i < tiles[t].size(); ++i)
+            tiles[t][i] += other.tiles[t][i];
+    for (size_t b = 0; b < captures.size(); ++b)
+        for (size_t r = 0; r < MAX_ROUNDS; ++r)
+            for (size_t i = 0; i < 2; ++i)
+                captures[b][r][i] += other.captures[b][r][i];
+    for (size_t r = 0; r < MAX_ROUNDS; ++r)
+        for (size_t i = 0; i < coupons[r].size(); ++i)
+            coupons[r][i] += other.coupons[r][i];
+}
+
+static size_t bonusIndex(CellType bonus) {
+    return bonus == BONUS_EXCHANGE ? 0 : bonus == BONUS_STONE ? 1 : 2;
+}
+
+/**
+Board events of one replayed game, kept until the winner is known.
+*/
+class GameEvents : public BoardObserver<GameEvents> {
+  public:
+    struct Cover {
+        uint8_t tileId;
+        size_t player;
+        std::vector<std::pair<size_t, size_t>> cells;
+        bool bStolen = false; // Its cells are no longer the placer's, even if covered again later
+    };
+    struct Capture {
+        size_t bonus;
+        size_t round;
+        size_t player;
+    };
+
+    const Game &game;
+    std::vector<Cover> covers;
+    std::vector<Capture> capturesOfGame;
+
+    GameEvents(const Game &game) : game(game) {}
+
+    size_t seatOf(const Player *player) const { return static_cast<size_t>(player - game.getPlayers().data()); }
+
+    void onCellsCovered(const CellsCovered &event) {
+        uint8_t tileId = game.getBoard().getPlacedTiles()[event.tileIndex].tile.getId();
+        covers.push_back({tileId, seatOf(event.player), {event.cells.begin(), event.cells.end()}});
+    }
+
+    void onTileStolen(const TileStolen &event) {
+        // The tile on a cell is the last cover of it
+        auto it = std::find_if(covers.rbegin(), covers.rend(), [&](const Cover &cover) {
+            return std::find(cover.cells.begin(), cover.cells.end(), event.cells.front()) != cover.cells.end();
+        });
+        if (it != covers.rend())
+            it->bStolen = true;
+    }
+
+    void onBonusCaptured(const BonusCaptured &event) {
+        capturesOfGame.push_back({bonusIndex(event.bonus), std::min(game.getCurrentRound(), MAX_ROUNDS - 1), seatOf(event.player)});
+    }
+};
+
+// Replay a record and add it to the accumulator, false if it cannot be replayed.
+static bool analyze(const RecordView &view, Accumulator &accumulator) {
+    std::unique_ptr<Game> start = replayStart(view);
+    Game &game = *start;
+    GameEvents events(game);
+    game.attachBoardObserver(events);
+
+    std::vector<std::pair<size_t, size_t>> couponUses; // Round and seat of each coupon used
+    std::vector<size_t> couponKinds;
+    for (uint32_t i = 0; i < view.header->nbEntries; ++i) {
+        const RecordEntry &entry = view.entries[i];
+        size_t round = std::min(game.getCurrentRound(), MAX_ROUNDS - 1);
+        if (!game.submit(toDecision(entry)).bAccepted)
+            return false;
+
+        // Choosing a tile of the queue or a stone uses the coupon, going back does not
+        bool bExchange = entry.type == EXCHANGE_TILE && entry.choice > 0;
+        if (bExchange || entry.type == REMOVE_STONE || entry.type == PLACE_COUPON_TILE) {
+            couponUses.push_back({round, entry.player});
+            couponKinds.push_back(bExchange ? 0 : entry.type == REMOVE_STONE ? 1 : 2);
+        }
+    }
+    game.detachBoardObserver(&events);
+    if (!game.isOver())
+        return false;
+
+    const Board &board = game.getBoard();
+    size_t size = board.getSize();
+    const Player &winnerPlayer = game.determineWinner();
+    size_t winner = events.seatOf(&winnerPlayer);
+    Square square = board.largestSquare(winnerPlayer);
+    auto inSquare = [&](std::pair<size_t, size_t> cell) {
+        return square.side > 0 && cell.first + square.side > square.corner.first && cell.first <= square.corner.first
+               && cell.second + square.side > square.corner.second && cell.second <= square.corner.second;
+    };
+
+    ++accumulator.nbGames;
+    accumulator.nbEntries += view.header->nbEntries;
+
+    std::vector<uint64_t> &heat = accumulator.heat[size];
+    heat.resize(size * size, 0);
+    ++accumulator.gamesOfSize[size];
+    for (size_t x = square.corner.first + 1 - square.side; square.side > 0 && x <= square.corner.first; ++x)
+        for (size_t y = square.corner.second + 1 - square.side; y <= square.corner.second; ++y)
+            ++heat[x * size + y];
+
+    for (const GameEvents::Cover &cover : events.covers) {
+        std::array<uint64_t, 3> &tile = accumulator.tiles[cover.tileId];
+        ++tile[0];
+        if (cover.player != winner)
+            continue;
+        ++tile[1];
+        // Cells of a stolen tile do not count, even when the winner covered them again with another tile
+        if (cover.bStolen)
+            continue;
+        for (const auto &cell : cover.cells)
+            if (inSquare(cell))
+                ++tile[2];
+    }
+
+    for (const GameEvents::Capture &capture : events.capturesOfGame) {
+        ++accumulator.captures[capture.bonus][capture.round][0];
+        if (capture.player == winner)
+            ++accumulator.captures[capture.bonus][capture.round][1];
+    }
+
+    for (size_t i = 0; i < couponUses.size(); ++i) {
+        ++accumulator.coupons[couponUses[i].first][couponKinds[i]];
+        if (couponUses[i].second == winner)
+            ++accumulator.coupons[couponUses[i].first][3];
+    }
+    return true;
+}
+
+/**
+Table of unsigned columns, written column after column.
+*/
+struct ColumnTable {
+    std::vector<std::string> names;
+    std::vector<std::vector<uint64_t>> columns;
+
+    ColumnTable(std::vector<std::string> columnNames) : names(std::move(columnNames)), columns(names.size()) {}
+
+    void addRow(const std::vector<uint64_t> &row) {
+        for (size_t i = 0; i < columns.size(); ++i)
+            columns[i].push_back(row[i]);
+    }
+
+    /**
+    Binary layout, little-endian as written by the host :
+        char magic[4] "LGC1", uint32_t nbColumns, uint64_t nbRows,
+        nbColumns names of 32 bytes (null-padded),
+        then each column as nbRows uint64_t.
+    Every column starts on a multiple of 8 bytes, so a reader maps the file and reads a column as an array.
+    */
+    void writeColumns(const std::string &path) const {
+        std::ofstream out(path, std::ios::binary);
+        uint32_t nbColumns = static_cast<uint32_t>(columns.size());
+        uint64_t nbRows = columns.empty() ? 0 : columns[0].size();
+        out.write("LGC1", 4);
+        out.write(reinterpret_cast<const char *>(&nbColumns), sizeof(nbColumns));
+        out.write(reinterpret_cast<const char *>(&nbRows), sizeof(nbRows));
+        for (const std::string &name : names) {
+            char padded[32] = {};
+            std::strncpy(padded, name.c_str(), sizeof(padded) - 1);
+            out.write(padded, sizeof(padded));
+        }
+        for (const std::vector<uint64_t> &column : columns)
+            out.write(reinterpret_cast<const char *>(column.data()), static_cast<std::streamsize>(column.size() * sizeof(uint64_t)));
+        if (!out)
+            throw std::runtime_error("Cannot write " + path);
+    }
+
+    void writeCsv(const std::string &path) const {
+        std::ofstream out(path);
+        for (size_t i = 0; i < names.size(); ++i)
+            out << (i ? "," : "") << names[i];
+        out << "\n";
+        for (size_t row = 0; !columns.empty() && row < columns[0].size(); ++row) {
+            for (size_t i = 0; i < columns.size(); ++i)
+                out << (i ? "," : "") << columns[i][row];
+            out << "\n";
+        }
+        if (!out)
+            throw std::runtime_error("Cannot write " + path);
+    }
+};
+
+/**
+Statistics over archived games.
+Records are replayed in parallel, each chunk of games into its own accumulator, merged once every game is done.
+Tables are written as columnar binary files, and as CSV on request.
+*/
+int main(int argc, char **argv) {
+    std::string path;
+    std::string outDir = ".";
+    bool bCsv = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--out" && i + 1 < argc)
+            outDir = argv[++i];
+        else if (arg == "--csv")
+            bCsv = true;
+        else if (path.empty() && arg[0] != '-')
+            path = arg;
+        else {
+            path.clear();
+            break;
+        }
+    }
+
+    if (path.empty()) {
+        std::cerr << "Usage: " << argv[0] << " FILE [--out DIR] [--csv]" << std::endl;
+        return 1;
+    }
+
+    try {
+        auto start = std::chrono::steady_clock::now();
+
+        RecordReader reader(path);
+        std::vector<RecordView> views;
+        RecordView view;
+        while (reader.next(view))
+            views.push_back(view);
+
+        // More chunks than threads, so that threads finishing early take the remaining ones
+        ThreadPool &pool = ThreadPool::shared();
+        size_t nbChunks = std::min(views.size(), pool.getNbThreads() * 8);
+        std::vector<Accumulator> accumulators(std::max<size_t>(nbChunks, 1));
+        pool.parallelFor(nbChunks, [&](size_t chunk) {
+            size_t first = chunk * views.size() / nbChunks;
+            size_t last = (chunk + 1) * views.size() / nbChunks;
+            for (size_t g = first; g < last; ++g) {
+                bool bReplayed = false;
+                try {
+                    bReplayed = analyze(views[g], accumulators[chunk]);
+                } catch (const std::runtime_error &) {
+                }
+                if (!bReplayed)
+                    ++accumulators[chunk].nbFailed;
+            }
+        });
+
+        Accumulator &total = accumulators[0];
+        for (size_t i = 1; i < accumulators.size(); ++i)
+            total.merge(accumulators[i]);
+
+        ColumnTable cells({"size", "x", "y", "games", "in_winning_square"});
+        for (const auto &[size, counts] : total.heat)
+            for (size_t i = 0; i < counts.size(); ++i)
+                cells.addRow({size, i / size, i % size, total.gamesOfSize[size], counts[i]});
+
+        ColumnTable tiles({"tile_id", "placements", "winner_placements", "cells_in_winning_square"});
+        for (size_t t = 0; t < total.tiles.size(); ++t)
+            if (total.tiles[t][0] > 0)
+                tiles.addRow({t, total.tiles[t][0], total.tiles[t][1], total.tiles[t][2]});
+
+        const std::array<CellType, 3> bonuses = {BONUS_EXCHANGE, BONUS_STONE, BONUS_ROBBERY};
+        ColumnTable captures({"bonus", "round", "captures", "winner_captures"});
+        for (size_t b = 0; b < bonuses.size(); ++b)
+            for (size_t r = 0; r < MAX_ROUNDS; ++r)
+                if (total.captures[b][r][0] > 0)
+                    captures.addRow({static_cast<uint64_t>(bonuses[b]), r, total.captures[b][r][0], total.captures[b][r][1]});
+
+        ColumnTable coupons({"round", "exchanged_tiles", "removed_stones", "coupon_tiles", "winner_uses"});
+        for (size_t r = 0; r < MAX_ROUNDS; ++r) {
+            const std::array<uint64_t, 4> &uses = total.coupons[r];
+            if (uses[0] + uses[1] + uses[2] > 0)
+                coupons.addRow({r, uses[0], uses[1], uses[2], uses[3]});
+        }
+
+        std::filesystem::create_directories(outDir);
+        const std::vector<std::pair<std::string, const ColumnTable *>> tables = {
+            {"cells", &cells}, {"tiles", &tiles}, {"captures", &captures}, {"coupons", &coupons}};
+        for (const auto &[name, table] : tables) {
+            table->writeColumns(outDir + "/" + name + ".lgc");
+            if (bCsv)
+                table->writeCsv(outDir + "/" + name + ".csv");
+        }
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << total.nbGames << " games, " << total.nbEntries << " decisions analyzed in " << elapsed.count() << " s on "
+                  << pool.getNbThreads() << " threads" << std::endl;
+        if (total.nbFailed > 0)
+            std::cout << total.nbFailed << " games could not be replayed" << std::endl;
+        return total.nbFailed == 0 ? 0 : 2;
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,110 @@
+#include "bot.hpp"
+#include "game.hpp"
+#include "opening_book.hpp"
+#include "thread_pool.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Starting tile locations chosen by a bot in the first round of a game, one entry per player.
+static std::vector<BookEntry> playOpening(uint64_t seed, size_t nbPlayers, size_t boardSize) {
+    Game game(nbPlayers, seed, boardSize);
+    Bot bot;
+    std::vector<BookEntry> entries;
+
+    // Names and colors come first
+    while (game.pendingDecision().type < PLACE_STARTING_TILE)
+        game.submit(bot.decide(game));
+
+    while (game.pendingDecision().type == PLACE_STARTING_TILE) {
+        const Board &board = game.getBoard();
+        const Player &player = game.getPlayers()[game.pendingDecision().playerIndex];
+        Decision decision = bot.decide(game);
+
+        // Stored in the frame of the canonical board, so that every symmetric board finds it
+        BookKey key = bookKey(board, player);
+        auto [x, y] = applySymmetry(key.symmetry, decision.coords, board.getSize());
+        entries.push_back({key.key, static_cast<uint16_t>(x), static_cast<uint16_t>(y), 0});
+
+        SubmitResult result = game.submit(decision);
+        if (!result.bAccepted)
+            throw std::runtime_error("Bot decision rejected: " + std::string(result.message));
+    }
+    return entries;
+}
+
+/**
+Builds an opening book from the first round of bot games on consecutive seeds.
+The bots search every starting location once here, games that use the book only hash the board.
+Entries of an existing book are kept, new positions are added to them.
+*/
+int main(int argc, char **argv) {
+    std::string outPath;
+    size_t nbGames = 1000;
+    size_t nbPlayers = 4;
+    uint64_t seed = 1;
+    size_t boardSize = 0; // Default size of the player count
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--out" && i + 1 < argc)
+            outPath = argv[++i];
+        else if (arg == "--games" && i + 1 < argc)
+            nbGames = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--players" && i + 1 < argc)
+            nbPlayers = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--seed" && i + 1 < argc)
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--size" && i + 1 < argc)
+            boardSize = std::strtoul(argv[++i], nullptr, 10);
+        else {
+            std::cerr << "Usage: " << argv[0] << " --out FILE [--games N] [--players N] [--seed S] [--size N]" << std::endl;
+            return 1;
+        }
+    }
+
+    if (outPath.empty()) {
+        std::cerr << "Usage: " << argv[0] << " --out FILE [--games N] [--players N] [--seed S] [--size N]" << std::endl;
+        return 1;
+    }
+    if (nbPlayers < Game::minPlayers || nbPlayers > Game::maxPlayers) {
+        std::cerr << "Number of players must be between " << Game::minPlayers << " and " << Game::maxPlayers << "." << std::endl;
+        return 1;
+    }
+    if (boardSize == 0)
+        boardSize = Board::defaultSize(nbPlayers);
+    if (boardSize < Board::minSize || boardSize > Board::maxSize) {
+        std::cerr << "Board size must be between " << Board::minSize << " and " << Board::maxSize << "." << std::endl;
+        return 1;
+    }
+
+    try {
+        std::vector<BookEntry> entries;
+        if (std::ifstream(outPath).good()) {
+            entries = OpeningBook(outPath).getEntries();
+            std::cout << "Extending " << outPath << " (" << entries.size() << " positions)" << std::endl;
+        }
+        size_t nbKept = entries.size();
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::vector<BookEntry>> openings(nbGames);
+        ThreadPool::shared().parallelFor(nbGames, [&](size_t g) { openings[g] = playOpening(seed + g, nbPlayers, boardSize); });
+        for (const std::vector<BookEntry> &opening : openings)
+            entries.insert(entries.end(), opening.begin(), opening.end());
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        writeOpeningBook(outPath, entries);
+        size_t nbEntries = OpeningBook(outPath).getNbEntries();
+        std::cout << nbGames << " openings in " << elapsed.count() << " s, " << nbEntries - std::min(nbEntries, nbKept)
+                  << " new positions, " << nbEntries << " in " << outPath << std::endl;
+    } catch (const std::runtime_error &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
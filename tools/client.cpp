@@ -0,0 +1,125 @@
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <netinet/in.h>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/**
+Scripted client for the server.
+Sends each command of the script (a file or standard input), waiting for the server reply to
+a command before sending the next one, and prints every line received on standard output.
+Empty lines and lines starting with '#' are skipped.
+*/
+
+// Close a socket that failed to connect, the caller still reports why.
+static int closeKeepingErrno(int fd) {
+    int error = errno;
+    close(fd);
+    errno = error;
+    return -1;
+}
+
+static int connectTo(const std::string &target) {
+    // A numeric target is a loopback TCP port, anything else is a Unix-domain socket path
+    if (target.find_first_not_of("0123456789") == std::string::npos) {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd == -1)
+            return -1;
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(std::atoi(target.c_str())));
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == -1)
+            return closeKeepingErrno(fd);
+        return fd;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1)
+        return -1;
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, target.c_str(), sizeof(address.sun_path) - 1);
+    if (connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == -1)
+        return closeKeepingErrno(fd);
+    return fd;
+}
+
+// Print received lines until a reply to the last command arrives, or the timeout expires.
+static bool receive(int fd, std::string &buffer, int timeoutMs, bool bWaitReply) {
+    pollfd pfd{fd, POLLIN, 0};
+
+    while (poll(&pfd, 1, timeoutMs) > 0) {
+        char chunk[4096];
+        ssize_t nbRead = read(fd, chunk, sizeof(chunk));
+        if (nbRead <= 0)
+            return false;
+        buffer.append(chunk, static_cast<size_t>(nbRead));
+
+        bool bReplied = false;
+        size_t end;
+        while ((end = buffer.find('\n')) != std::string::npos) {
+            std::string line = buffer.substr(0, end);
+            buffer.erase(0, end + 1);
+            std::cout << line << std::endl;
+
+            std::string command = line.substr(0, line.find(' '));
+            if (command == "OK" || command == "ERR" || command == "GAME" || command == "JOINED" || command == "WATCHING")
+                bReplied = true;
+        }
+
+        if (bWaitReply && bReplied)
+            return true;
+    }
+
+    return true;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <socket path | port> [script]" << std::endl;
+        return 1;
+    }
+
+    int fd = connectTo(argv[1]);
+    if (fd == -1) {
+        std::cerr << "Cannot connect to " << argv[1] << ": " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+
+    std::ifstream file;
+    if (argc > 2) {
+        file.open(argv[2]);
+        if (!file) {
+            std::cerr << "Cannot open " << argv[2] << std::endl;
+            return 1;
+        }
+    }
+    std::istream &script = argc > 2 ? file : std::cin;
+
+    std::string buffer;
+    std::string line;
+    while (std::getline(script, line)) {
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        line += '\n';
+        if (write(fd, line.data(), line.size()) != static_cast<ssize_t>(line.size()))
+            break;
+        if (!receive(fd, buffer, 2000, true))
+            break;
+    }
+
+    // Drain the last updates
+    receive(fd, buffer, 200, false);
+    close(fd);
+
+    return 0;
+}
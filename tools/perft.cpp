@@ -0,0 +1,385 @@
+#include "bot.hpp"
+#include "game.hpp"
+#include "snapshot.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+#include <vector>
+
+/**
+Move generators compared by the tool.
+INDEXED uses the board as the game does, REFERENCE checks every cell with canPlaceTile().
+*/
+enum class Generator { INDEXED, REFERENCE };
+
+/**
+Decisions submitted together, so that no generated sequence can loop.
+An orientation is reached with its rotations and flip followed by the choice to place the tile.
+*/
+struct Step {
+    std::vector<Decision> decisions;
+    std::string label;
+};
+
+/**
+Totals of a perft run, or of one of its subtrees.
+*/
+struct PerftCount {
+    uint64_t nodes = 0;     // Positions reached after the last turn, or at the end of the game
+    uint64_t decisions = 0; // Decisions submitted on the way
+    uint64_t rejected = 0;  // Generated decisions the game refused, always 0 unless a generator is wrong
+
+    void add(const PerftCount &other) {
+        nodes += other.nodes;
+        decisions += other.decisions;
+        rejected += other.rejected;
+    }
+};
+
+static std::string coordsLabel(std::pair<size_t, size_t> coords) {
+    return "(" + std::to_string(coords.first) + ", " + std::to_string(coords.second) + ")";
+}
+
+static Step coordsStep(DecisionType type, std::pair<size_t, size_t> coords, const std::string &name) {
+    return {{Decision{type, 0, coords}}, name + " " + coordsLabel(coords)};
+}
+
+// Every coordinates where a tile fits, from the indexed anchors or from a scan of the board.
+static std::vector<std::pair<size_t, size_t>> anchors(const Board &board, const Tile &tile, const Player &player, bool bIsStartingTile,
+                                                      Generator generator) {
+    if (generator == Generator::INDEXED && !bIsStartingTile)
+        return board.legalAnchors(tile.getShape(), player);
+
+    std::vector<std::pair<size_t, size_t>> result;
+    for (size_t x = 0; x < board.getSize(); ++x)
+        for (size_t y = 0; y < board.getSize(); ++y)
+            if (board.canPlaceTile({x, y}, tile, player, bIsStartingTile))
+                result.push_back({x, y});
+    return result;
+}
+
+// Cells of a type, from the census or from a scan of the board, in row order.
+static std::vector<std::pair<size_t, size_t>> cellsOfType(const Board &board, CellType type, Generator generator) {
+    std::vector<std::pair<size_t, size_t>> result;
+    if (generator == Generator::INDEXED) {
+        for (size_t i = 0; i < board.countCells(type); ++i)
+            result.push_back(board.cellOfType(type, i));
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    for (size_t x = 0; x < board.getSize(); ++x)
+        for (size_t y = 0; y < board.getSize(); ++y)
+            if (board.getCell({x, y}).type == type)
+                result.push_back({x, y});
+    return result;
+}
+
+// One cell of each tile the player can steal.
+static std::vector<std::pair<size_t, size_t>> robberyTargets(const Board &board, const Player &player, Generator generator) {
+    std::vector<std::pair<size_t, size_t>> result;
+    std::set<const PlacedTile *> seen;
+    for (size_t x = 0; x < board.getSize(); ++x) {
+        for (size_t y = 0; y < board.getSize(); ++y) {
+            const PlacedTile *placed = nullptr;
+            if (generator == Generator::INDEXED) {
+                placed = board.tileAtCell({x, y});
+            } else {
+                for (const PlacedTile &candidate : board.getPlacedTiles()) {
+                    const Shape &shape = candidate.tile.getShape();
+                    size_t i = x - candidate.coords.first, j = y - candidate.coords.second;
+                    if (i < shape.size() && j < shape[i].size() && shape[i][j])
+                        placed = &candidate;
+                }
+            }
+            if (placed && placed->bStealable && placed->owner != &player && seen.insert(placed).second)
+                result.push_back({x, y});
+        }
+    }
+    return result;
+}
+
+// Every step of the pending decision that moves the game forward.
+static std::vector<Step> legalSteps(const Game &game, Generator generator) {
+    const PendingDecision &pending = game.pendingDecision();
+    const Board &board = game.getBoard();
+    const Player &player = game.getPlayers()[pending.playerIndex];
+    std::vector<Step> steps;
+
+    switch (pending.type) {
+    case PLACE_STARTING_TILE:
+        for (const auto &coords : anchors(board, Tile::fromId(STARTING_TILE_ID), player, true, generator))
+            steps.push_back(coordsStep(PLACE_STARTING_TILE, coords, "start"));
+        break;
+    case TAKE_OR_EXCHANGE:
+        steps.push_back({{Decision{TAKE_OR_EXCHANGE, 1}}, "take"});
+        steps.push_back({{Decision{TAKE_OR_EXCHANGE, 2}}, "coupon"});
+        break;
+    case EXCHANGE_KIND:
+        // Going back would loop, the take is already generated
+        if (!game.getTileQueue().getTiles().empty())
+            steps.push_back({{Decision{EXCHANGE_KIND, 1}}, "queue"});
+        if (!cellsOfType(board, STONE, generator).empty())
+            steps.push_back({{Decision{EXCHANGE_KIND, 2}}, "unstone"});
+        break;
+    case EXCHANGE_TILE:
+        for (int choice = 1; choice <= pending.max; ++choice)
+            steps.push_back({{Decision{EXCHANGE_TILE, choice}}, "tile " + std::to_string(choice)});
+        break;
+    case REMOVE_STONE:
+        for (const auto &coords : cellsOfType(board, STONE, generator))
+            steps.push_back(coordsStep(REMOVE_STONE, coords, "remove"));
+        break;
+    case ORIENT_TILE: {
+        // Distinct shapes only, symmetric tiles have fewer than 8 orientations
+        std::set<Shape> shapes;
+        for (int flip = 0; flip < 2; ++flip) {
+            for (int r = 0; r < 4; ++r) {
+                Tile tile = *game.getCurrentTile();
+                Step step;
+                for (int i = 0; i < r; ++i) {
+                    tile.rotateClockwise();
+                    step.decisions.push_back(Decision{ORIENT_TILE, 2});
+                }
+                if (flip) {
+                    tile.flipHorizontal();
+                    step.decisions.push_back(Decision{ORIENT_TILE, 3});
+                }
+                step.decisions.push_back(Decision{ORIENT_TILE, 1});
+                step.label = "r" + std::to_string(r) + (flip ? "f" : "");
+
+                bool bPlaceable = generator == Generator::INDEXED ? board.canPlaceTileAnywhere(tile, player)
+                                                                  : !anchors(board, tile, player, false, generator).empty();
+                if (shapes.insert(tile.getShape()).second && bPlaceable)
+                    steps.push_back(step);
+            }
+        }
+        break;
+    }
+    case PLACE_TILE:
+        for (const auto &coords : anchors(board, *game.getCurrentTile(), player, false, generator))
+            steps.push_back(coordsStep(PLACE_TILE, coords, "at"));
+        break;
+    case PLACE_STONE:
+        for (const auto &coords : cellsOfType(board, EMPTY, generator))
+            steps.push_back(coordsStep(PLACE_STONE, coords, "stone"));
+        break;
+    case ROB_TILE:
+        for (const auto &coords : robberyTargets(board, player, generator))
+            steps.push_back(coordsStep(ROB_TILE, coords, "rob"));
+        break;
+    case PLACE_COUPON_TILE:
+        for (const auto &coords : anchors(board, Tile::fromId(STARTING_TILE_ID), player, false, generator))
+            steps.push_back(coordsStep(PLACE_COUPON_TILE, coords, "grass"));
+        break;
+    default:
+        break;
+    }
+    return steps;
+}
+
+/**
+Play every decision sequence of the turn in progress.
+The turn ends once another player has to decide or the game is over, onTurn() is then called on the position.
+*/
+template <typename F>
+static void forEachTurn(const Game &game, size_t mover, Generator generator, PerftCount &count, std::vector<const Step *> &path,
+                        F &&onTurn) {
+    if (game.isOver() || game.pendingDecision().playerIndex != mover) {
+        onTurn(game);
+        return;
+    }
+
+    for (const Step &step : legalSteps(game, generator)) {
+        Game next(game);
+        bool bAccepted = true;
+        for (const Decision &decision : step.decisions) {
+            ++count.decisions;
+            if (!next.submit(decision).bAccepted) {
+                bAccepted = false;
+                break;
+            }
+        }
+        if (!bAccepted) {
+            ++count.rejected;
+            continue;
+        }
+
+        path.push_back(&step);
+        forEachTurn(next, mover, generator, count, path, onTurn);
+        path.pop_back();
+    }
+}
+
+static void perft(const Game &game, size_t depth, Generator generator, PerftCount &count) {
+    if (depth == 0 || game.isOver()) {
+        ++count.nodes;
+        return;
+    }
+
+    std::vector<const Step *> path;
+    forEachTurn(game, game.pendingDecision().playerIndex, generator, count, path,
+                [&](const Game &next) { perft(next, depth - 1, generator, count); });
+}
+
+/**
+Perft with the turns of the first player counted one by one.
+Subtrees are split over the shared thread pool, each of them played again from its decisions.
+*/
+static std::map<std::string, PerftCount> divide(const Game &root, size_t depth, Generator generator, PerftCount &total) {
+    std::vector<Step> turns;
+    if (depth == 0 || root.isOver()) {
+        total.nodes = 1;
+        return {};
+    }
+
+    std::vector<const Step *> path;
+    forEachTurn(root, root.pendingDecision().playerIndex, generator, total, path, [&](const Game &) {
+        Step turn;
+        for (const Step *step : path) {
+            turn.decisions.insert(turn.decisions.end(), step->decisions.begin(), step->decisions.end());
+            turn.label += (turn.label.empty() ? "" : " ") + step->label;
+        }
+        turns.push_back(std::move(turn));
+    });
+
+    std::vector<PerftCount> counts(turns.size());
+    ThreadPool::shared().parallelFor(turns.size(), [&](size_t i) {
+        Game game(root);
+        for (const Decision &decision : turns[i].decisions)
+            game.submit(decision);
+        perft(game, depth - 1, generator, counts[i]);
+    });
+
+    std::map<std::string, PerftCount> result;
+    for (size_t i = 0; i < turns.size(); ++i) {
+        total.add(counts[i]);
+        result[turns[i].label].add(counts[i]);
+    }
+    return result;
+}
+
+/**
+Count every decision sequence from a position, turn by turn, as chess engines do to check their move generators.
+A turn covers the coupon choices, each orientation and anchor of the tile, and the bonuses it captures.
+The position is a seeded game advanced by bots, or a snapshot.
+*/
+int main(int argc, char **argv) {
+    size_t nbPlayers = 2;
+    uint64_t seed = 1;
+    size_t boardSize = 0; // Default size of the player count
+    size_t depth = 2;
+    size_t nbAdvance = 0;
+    std::string snapshotPath;
+    bool bVerify = false;
+    bool bDivide = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--players" && i + 1 < argc)
+            nbPlayers = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--seed" && i + 1 < argc)
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--size" && i + 1 < argc)
+            boardSize = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--depth" && i + 1 < argc)
+            depth = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--advance" && i + 1 < argc)
+            nbAdvance = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--snapshot" && i + 1 < argc)
+            snapshotPath = argv[++i];
+        else if (arg == "--verify")
+            bVerify = true;
+        else if (arg == "--divide")
+            bDivide = true;
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--players N] [--seed S] [--size N] [--snapshot FILE] [--advance TURNS]"
+                      << " [--depth D] [--divide] [--verify]" << std::endl;
+            return 1;
+        }
+    }
+
+    try {
+        std::optional<Game> root;
+        if (!snapshotPath.empty())
+            root.emplace(Snapshot(snapshotPath));
+        else
+            root.emplace(nbPlayers, seed, boardSize ? boardSize : Board::defaultSize(nbPlayers));
+
+        // Bots take the seats and play the first nbAdvance turns
+        Bot bot;
+        std::optional<size_t> mover;
+        size_t nbTurns = 0;
+        while (!root->isOver()) {
+            const PendingDecision &pending = root->pendingDecision();
+            if (pending.type != CHOOSE_NAME && pending.type != CHOOSE_COLOR) {
+                if (mover && pending.playerIndex != *mover)
+                    ++nbTurns;
+                if (nbTurns == nbAdvance)
+                    break;
+                mover = pending.playerIndex;
+            }
+            if (!root->submit(bot.decide(*root)).bAccepted)
+                throw std::runtime_error("Bot decision rejected while advancing");
+        }
+
+        const Game &game = *root;
+        std::cout << "Seed " << game.getSeed() << ", " << game.getNbPlayers() << " players, " << game.getBoard().getSize() << "x"
+                  << game.getBoard().getSize() << ", round " << game.getCurrentRound() << ", depth " << depth << ", "
+                  << ThreadPool::shared().getNbThreads() << " threads" << std::endl;
+
+        auto start = std::chrono::steady_clock::now();
+        PerftCount total;
+        std::map<std::string, PerftCount> branches = divide(game, depth, Generator::INDEXED, total);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        if (bDivide)
+            for (const auto &[label, count] : branches)
+                std::cout << label << ": " << count.nodes << std::endl;
+
+        std::cout << "Nodes: " << total.nodes << ", decisions: " << total.decisions << std::endl;
+        std::cout << std::fixed << std::setprecision(3) << "Time: " << elapsed.count() << " s, " << std::setprecision(0)
+                  << total.nodes / elapsed.count() << " nodes/s, " << total.decisions / elapsed.count() << " decisions/s" << std::endl;
+
+        bool bMatched = total.rejected == 0;
+        if (total.rejected)
+            std::cout << total.rejected << " generated decisions rejected by the game" << std::endl;
+
+        if (bVerify) {
+            start = std::chrono::steady_clock::now();
+            PerftCount reference;
+            std::map<std::string, PerftCount> referenceBranches = divide(game, depth, Generator::REFERENCE, reference);
+            elapsed = std::chrono::steady_clock::now() - start;
+
+            std::cout << "Reference nodes: " << reference.nodes << ", " << std::setprecision(3) << elapsed.count() << " s" << std::endl;
+            for (const auto &[label, count] : referenceBranches) {
+                auto it = branches.find(label);
+                if (it == branches.end() || it->second.nodes != count.nodes) {
+                    std::cout << "Divergence at " << label << ": " << (it == branches.end() ? 0 : it->second.nodes) << " instead of "
+                              << count.nodes << std::endl;
+                    bMatched = false;
+                }
+            }
+            for (const auto &[label, count] : branches) {
+                if (!referenceBranches.count(label)) {
+                    std::cout << "Divergence at " << label << ": " << count.nodes << " instead of 0" << std::endl;
+                    bMatched = false;
+                }
+            }
+            bMatched = bMatched && reference.nodes == total.nodes && reference.rejected == 0;
+            std::cout << (bMatched ? "Counts match" : "MISMATCH") << std::endl;
+        }
+
+        return bMatched ? 0 : 2;
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,255 @@
+#include "game.hpp"
+#include "record.hpp"
+#include "replay.hpp"
+#include "utils.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+// Replay one record through a fresh game, returns an error message or an empty string.
+static std::string replay(const RecordView &view, std::string &winner) {
+    const RecordHeader &header = *view.header;
+    std::unique_ptr<Game> start;
+    try {
+        start = replayStart(view);
+    } catch (const std::runtime_error &e) {
+        return e.what();
+    }
+    Game &game = *start;
+
+    const std::vector<Bonus> &layout = game.getBoard().getBonusLayout();
+    if (layout.size() != header.nbBonuses)
+        return "bonus count differs";
+    for (size_t i = 0; i < layout.size(); ++i) {
+        const RecordBonus &bonus = view.bonuses[i];
+        if (layout[i].coords.first != bonus.x || layout[i].coords.second != bonus.y || layout[i].type != bonus.type)
+            return "bonus layout differs";
+    }
+
+    for (uint32_t i = 0; i < header.nbEntries; ++i) {
+        const RecordEntry &entry = view.entries[i];
+        const PendingDecision &pending = game.pendingDecision();
+
+        if (pending.type != entry.type || pending.playerIndex != entry.player)
+            return "entry " + std::to_string(i) + " expected " + decisionTypeToString(pending.type);
+
+        const std::optional<Tile> &tile = game.getCurrentTile();
+        if ((tile ? tile->getId() : RECORD_NO_TILE) != entry.tileId)
+            return "entry " + std::to_string(i) + " tile differs";
+
+        SubmitResult result = game.submit(toDecision(entry));
+        if (!result.bAccepted)
+            return "entry " + std::to_string(i) + " rejected: " + std::string(result.message);
+    }
+
+    if (!game.isOver())
+        return "game is not over";
+
+    winner = game.determineWinner().getName();
+    return "";
+}
+
+// Write the text of a cell on screen, two columns wide.
+static void drawCell(std::ostream &out, const Cell &cell) {
+    switch (cell.type) {
+        case STONE: out << "\033[37m██\033[0m"; break;
+        case BONUS_EXCHANGE: out << "Ｅ"; break;
+        case BONUS_STONE: out << "Ｓ"; break;
+        case BONUS_ROBBERY: out << "Ｒ"; break;
+        case GRASS: out << colorize(cell.owner->getColor()) << cell.printSymbol << resetColor; break;
+        default: out << "・"; break;
+    }
+}
+
+/**
+Terminal view of a replay.
+Changed cells are collected from the board's events, as SpectatorFeed does, and only they are drawn again.
+The first frame and the frames after a keyframe restore draw the whole board.
+*/
+class ReplayScreen : public BoardObserver<ReplayScreen> {
+  private:
+    ReplayCursor &cursor;
+    size_t size;
+    std::vector<uint32_t> changed; // Cells changed since the last frame, x * size + y
+    std::vector<bool> bChanged;
+    bool bRedrawAll = true;
+
+    void mark(std::pair<size_t, size_t> coords) {
+        uint32_t cell = static_cast<uint32_t>(coords.first * size + coords.second);
+        if (bChanged[cell])
+            return;
+        bChanged[cell] = true;
+        changed.push_back(cell);
+    }
+
+  public:
+    ReplayScreen(ReplayCursor &cursor) : cursor(cursor), size(cursor.getGame().getBoard().getSize()) {
+        bChanged.assign(size * size, false);
+        cursor.attachBoardObserver(*this);
+    }
+    ~ReplayScreen() { cursor.detachBoardObserver(); }
+    ReplayScreen(const ReplayScreen &) = delete;
+    ReplayScreen& operator=(const ReplayScreen &) = delete;
+
+    void draw() {
+        const Game &game = cursor.getGame();
+        const Board &board = game.getBoard();
+        std::ostringstream out;
+
+        // Board from the third row of the terminal, two columns per cell
+        auto drawAt = [&](size_t x, size_t y) {
+            out << "\033[" << (x + 3) << ";" << (2 * y + 1) << "H";
+            drawCell(out, board.getCell({x, y}));
+        };
+        size_t nbDrawn = 0;
+        if (bRedrawAll) {
+            out << "\033[2J";
+            for (size_t x = 0; x < size; ++x)
+                for (size_t y = 0; y < size; ++y)
+                    drawAt(x, y);
+            nbDrawn = size * size;
+            bRedrawAll = false;
+        } else {
+            for (uint32_t cell : changed)
+                drawAt(cell / size, cell % size);
+            nbDrawn = changed.size();
+        }
+        for (uint32_t cell : changed)
+            bChanged[cell] = false;
+        changed.clear();
+
+        out << "\033[1;1H\033[K" << "Decision " << cursor.getPosition() << "/" << cursor.getNbEntries();
+        if (const RecordEntry *entry = cursor.lastEntry())
+            out << " - Player " << (entry->player + 1) << ": " << decisionTypeToString(static_cast<DecisionType>(entry->type));
+        out << " - Round " << game.getCurrentRound() << " (" << nbDrawn << " cells drawn)";
+        out << "\033[" << (size + 4) << ";1H\033[K" << "[Enter] next  p previous  g N go to  e end  q quit > ";
+        std::cout << out.str() << std::flush;
+    }
+
+    void onCellsCovered(const CellsCovered &event) {
+        for (const auto &coords : event.cells)
+            mark(coords);
+    }
+    void onBonusCaptured(const BonusCaptured &event) { mark(event.coords); }
+    void onStonePlaced(const StonePlaced &event) { mark(event.coords); }
+    void onStoneRemoved(const StoneRemoved &event) { mark(event.coords); }
+    void onTileStolen(const TileStolen &event) {
+        for (const auto &coords : event.cells)
+            mark(coords);
+    }
+    void onCellChanged(const CellChanged &event) { mark(event.coords); }
+    void onBoardReset(const BoardReset &) { bRedrawAll = true; }
+};
+
+// Step through one recorded game with commands read from standard input.
+static int view(RecordReader &reader, size_t game, size_t interval) {
+    RecordView record;
+    for (size_t g = 0; g <= game; ++g) {
+        if (!reader.next(record)) {
+            std::cerr << "No game " << game << " in the file" << std::endl;
+            return 1;
+        }
+    }
+
+    ReplayCursor cursor(record, interval);
+    ReplayScreen screen(cursor);
+    screen.draw();
+
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        std::istringstream command(line);
+        std::string action;
+        command >> action;
+
+        if (action.empty() || action == "n")
+            cursor.next();
+        else if (action == "p")
+            cursor.previous();
+        else if (action == "e")
+            cursor.seek(cursor.getNbEntries());
+        else if (action == "g") {
+            uint32_t target = 0;
+            command >> target;
+            cursor.seek(target);
+        } else if (action == "q")
+            break;
+        screen.draw();
+    }
+
+    std::cout << std::endl;
+    return 0;
+}
+
+/**
+Deterministic replay of recorded games.
+Every record is played again from its seed, and each decision must be accepted as it was.
+*/
+int main(int argc, char **argv) {
+    std::string path;
+    bool bVerbose = false;
+    long viewed = -1;
+    size_t interval = 32;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--verbose")
+            bVerbose = true;
+        else if (arg == "--view" && i + 1 < argc)
+            viewed = std::atol(argv[++i]);
+        else if (arg == "--interval" && i + 1 < argc)
+            interval = static_cast<size_t>(std::atol(argv[++i]));
+        else if (path.empty() && arg[0] != '-')
+            path = arg;
+        else {
+            path.clear();
+            break;
+        }
+    }
+
+    if (path.empty()) {
+        std::cerr << "Usage: " << argv[0] << " FILE [--verbose] [--view GAME] [--interval K]" << std::endl;
+        return 1;
+    }
+
+    try {
+        RecordReader reader(path);
+        if (viewed >= 0)
+            return view(reader, static_cast<size_t>(viewed), interval);
+        RecordView view;
+
+        // Plain iteration first, to measure the cost of reading alone
+        auto start = std::chrono::steady_clock::now();
+        size_t nbGames = 0, nbEntries = 0;
+        while (reader.next(view)) {
+            ++nbGames;
+            nbEntries += view.header->nbEntries;
+        }
+        std::chrono::duration<double> scanned = std::chrono::steady_clock::now() - start;
+
+        reader.rewind();
+        start = std::chrono::steady_clock::now();
+        size_t nbFailed = 0;
+        for (size_t g = 0; reader.next(view); ++g) {
+            std::string winner;
+            std::string error = replay(view, winner);
+            if (!error.empty()) {
+                ++nbFailed;
+                std::cerr << "Game " << g << " (seed " << view.header->seed << "): " << error << std::endl;
+            } else if (bVerbose) {
+                std::cout << "Game " << g << ": " << view.header->nbEntries << " decisions, " << winner << " wins" << std::endl;
+            }
+        }
+        std::chrono::duration<double> replayed = std::chrono::steady_clock::now() - start;
+
+        std::cout << nbGames << " games, " << nbEntries << " decisions" << std::endl;
+        std::cout << "Scanned in " << scanned.count() << " s, replayed in " << replayed.count() << " s" << std::endl;
+        std::cout << (nbGames - nbFailed) << " replayed, " << nbFailed << " failed" << std::endl;
+        return nbFailed == 0 ? 0 : 2;
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
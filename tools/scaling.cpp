@@ -0,0 +1,478 @@
+#include "board.hpp"
+#include "game.hpp"
+#include "thread_pool.hpp"
+#include "tile_queue.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+/**
+Time spent in one board operation, accumulated over a run.
+*/
+struct Timer {
+    double total = 0; // Microseconds
+    size_t calls = 0;
+
+    template <typename F>
+    auto measure(F &&f) {
+        auto start = Clock::now();
+        auto result = f();
+        total += std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+        ++calls;
+        return result;
+    }
+
+    double average() const { return calls ? total / calls : 0; }
+};
+
+// Every orientation of a tile, in the order the bot tries them.
+static std::vector<Tile> orientations(Tile tile) {
+    std::vector<Tile> result;
+    for (int flip = 0; flip < 2; ++flip) {
+        for (int r = 0; r < 4; ++r) {
+            result.push_back(tile);
+            tile.rotateClockwise();
+        }
+        tile.flipHorizontal();
+    }
+    return result;
+}
+
+// Reference scan of every cell of the board, as done before anchors were indexed.
+static std::vector<std::pair<size_t, size_t>> scanAnchors(const Board &board, const Shape &shape, const Player &player) {
+    std::vector<std::pair<size_t, size_t>> anchors;
+    for (size_t x = 0; x < board.getSize(); ++x)
+        for (size_t y = 0; y < board.getSize(); ++y)
+            if (board.canPlaceShape({x, y}, shape, player, false))
+                anchors.push_back({x, y});
+    return anchors;
+}
+
+// Reference largest square, the serial table over the whole board.
+static Square scanSquare(const Board &board, const Player &player) {
+    size_t size = board.getSize();
+    std::vector<size_t> previous(size, 0), current(size, 0);
+    Square best = {0, {0, 0}};
+
+    for (size_t x = 0; x < size; ++x) {
+        for (size_t y = 0; y < size; ++y) {
+            if (board.getCell({x, y}).owner != &player)
+                current[y] = 0;
+            else if (x == 0 || y == 0)
+                current[y] = 1;
+            else
+                current[y] = 1 + std::min({previous[y], current[y - 1], previous[y - 1]});
+
+            if (current[y] > best.side)
+                best = {current[y], {x, y}};
+        }
+        std::swap(previous, current);
+    }
+    return best;
+}
+
+// Census counts against a scan of the board and of the placed tiles.
+static bool censusMatches(const Board &board, const Player &player) {
+    std::array<size_t, NB_CELL_TYPES> counts{};
+    for (size_t x = 0; x < board.getSize(); ++x)
+        for (size_t y = 0; y < board.getSize(); ++y)
+            ++counts[board.getCell({x, y}).type];
+    for (size_t type = 0; type < NB_CELL_TYPES; ++type) {
+        if (board.countCells(static_cast<CellType>(type)) != counts[type])
+            return false;
+        for (size_t i = 0; i < counts[type]; ++i)
+            if (board.getCell(board.cellOfType(static_cast<CellType>(type), i)).type != type)
+                return false;
+    }
+
+    size_t nbStealable = 0;
+    for (const PlacedTile &placed : board.getPlacedTiles())
+        if (placed.bStealable && placed.owner != &player)
+            ++nbStealable;
+    return board.countStealable(player) == nbStealable;
+}
+
+// Components and bonus distances against flood fills of the whole board.
+static bool territoryMatches(const Board &board, const Player &player) {
+    const std::array<std::pair<int,int>,4> directions = {{{-1,0}, {1,0}, {0,-1}, {0,1}}};
+    size_t size = board.getSize();
+
+    std::vector<Component> expected;
+    std::vector<bool> visited(size * size, false);
+    for (size_t x = 0; x < size; ++x) {
+        for (size_t y = 0; y < size; ++y) {
+            if (visited[x * size + y] || board.getCell({x, y}).owner != &player)
+                continue;
+            Component component = {0, {x, y}, {x, y}};
+            std::vector<std::pair<size_t, size_t>> stack = {{x, y}};
+            visited[x * size + y] = true;
+            while (!stack.empty()) {
+                auto [cx, cy] = stack.back();
+                stack.pop_back();
+                ++component.area;
+                component.topLeft = {std::min(component.topLeft.first, cx), std::min(component.topLeft.second, cy)};
+                component.bottomRight = {std::max(component.bottomRight.first, cx), std::max(component.bottomRight.second, cy)};
+                for (const auto &dir : directions) {
+                    size_t nx = cx + dir.first, ny = cy + dir.second;
+                    if (nx < size && ny < size && !visited[nx * size + ny] && board.getCell({nx, ny}).owner == &player) {
+                        visited[nx * size + ny] = true;
+                        stack.push_back({nx, ny});
+                    }
+                }
+            }
+            expected.push_back(component);
+        }
+    }
+    std::sort(expected.begin(), expected.end(), [](const Component &a, const Component &b) {
+        return a.area != b.area ? a.area > b.area : a.topLeft < b.topLeft;
+    });
+
+    std::vector<Component> found = board.territoryComponents(player);
+    if (found.size() != expected.size())
+        return false;
+    for (size_t i = 0; i < found.size(); ++i)
+        if (found[i].area != expected[i].area || found[i].topLeft != expected[i].topLeft || found[i].bottomRight != expected[i].bottomRight)
+            return false;
+
+    // Each bonus searched on its own, through free cells up to the horizon
+    std::vector<BonusDistance> distances;
+    std::vector<bool> seen(size * size, false);
+    for (const Bonus &bonus : board.getBonusLayout()) {
+        if (board.getCell(bonus.coords).type != bonus.type)
+            continue;
+        std::vector<size_t> touched = {bonus.coords.first * size + bonus.coords.second};
+        std::vector<std::pair<size_t, size_t>> frontier = {bonus.coords};
+        seen[touched[0]] = true;
+        std::optional<size_t> reached;
+        for (size_t d = 0; !frontier.empty() && !reached && d < Board::bonusHorizon; ++d) {
+            std::vector<std::pair<size_t, size_t>> next;
+            for (auto [cx, cy] : frontier) {
+                for (const auto &dir : directions) {
+                    size_t nx = cx + dir.first, ny = cy + dir.second;
+                    if (nx >= size || ny >= size || seen[nx * size + ny])
+                        continue;
+                    const Cell &cell = board.getCell({nx, ny});
+                    if (cell.owner == &player)
+                        reached = d + 1;
+                    else if (!cell.owner && cell.type != STONE && cell.type != GRASS) {
+                        seen[nx * size + ny] = true;
+                        touched.push_back(nx * size + ny);
+                        next.push_back({nx, ny});
+                    }
+                }
+            }
+            frontier = std::move(next);
+        }
+        for (size_t cell : touched)
+            seen[cell] = false;
+        if (reached)
+            distances.push_back({bonus.coords, bonus.type, *reached});
+    }
+    std::sort(distances.begin(), distances.end(), [](const BonusDistance &a, const BonusDistance &b) {
+        return a.distance != b.distance ? a.distance < b.distance : a.coords < b.coords;
+    });
+
+    std::vector<BonusDistance> reported = board.bonusDistances(player);
+    if (reported.size() != distances.size())
+        return false;
+    for (size_t i = 0; i < reported.size(); ++i)
+        if (reported[i].coords != distances[i].coords || reported[i].distance != distances[i].distance)
+            return false;
+    return true;
+}
+
+// Robbery deltas against copies of the board where each tile is stolen.
+static bool robberiesMatch(const Board &board, Player &thief) {
+    std::span<const RobberyDelta> deltas = board.robberyDeltas(thief);
+    if (deltas.size() != board.countStealable(thief))
+        return false;
+
+    for (const RobberyDelta &delta : deltas) {
+        Board robbed(board);
+        size_t area = board.territory(*delta.victim).area;
+        if (!robbed.stealTile(delta.target, &thief))
+            return false;
+        if (robbed.largestSquare(*delta.victim).side != delta.squareAfter || board.largestSquare(*delta.victim).side != delta.squareBefore
+            || robbed.territory(*delta.victim).area + delta.cells != area)
+            return false;
+    }
+    return true;
+}
+
+// Largest square of own or free cells holding an own cell, within bonusHorizon of the territory, by trying every square.
+static size_t naivePotential(const Board &board, const Player &player) {
+    Component box = board.territory(player);
+    if (box.area == 0)
+        return 0;
+
+    size_t h = Board::bonusHorizon, size = board.getSize();
+    size_t x0 = box.topLeft.first > h ? box.topLeft.first - h : 0, x1 = std::min(size, box.bottomRight.first + h + 1);
+    size_t y0 = box.topLeft.second > h ? box.topLeft.second - h : 0, y1 = std::min(size, box.bottomRight.second + h + 1);
+    auto open = [&](size_t x, size_t y) {
+        const Cell &cell = board.getCell({x, y});
+        return cell.owner == &player || (cell.type != GRASS && cell.type != STONE);
+    };
+
+    size_t best = 0;
+    for (size_t x = x0; x < x1; ++x) {
+        for (size_t y = y0; y < y1; ++y) {
+            bool bOwn = false;
+            for (size_t side = 1; x + side <= x1 && y + side <= y1; ++side) {
+                bool bOpen = true;
+                for (size_t k = 0; k < side && bOpen; ++k) {
+                    bOpen = open(x + side - 1, y + k) && open(x + k, y + side - 1);
+                    bOwn = bOwn || board.getCell({x + side - 1, y + k}).owner == &player || board.getCell({x + k, y + side - 1}).owner == &player;
+                }
+                if (!bOpen)
+                    break;
+                if (bOwn)
+                    best = std::max(best, side);
+            }
+        }
+    }
+    return best;
+}
+
+// Stone impacts of a few random cells against boards where the stone is placed.
+static bool stonesMatch(const Board &board, const std::vector<Player> &players, const Player &player, std::span<const Tile> tiles,
+                        size_t seed) {
+    std::mt19937 gen(static_cast<uint32_t>(seed)); // Own generator, so that checks leave the game unchanged
+    std::span<const StoneImpact> impacts = board.stoneImpacts(player, tiles);
+    if (impacts.size() != board.countCells(EMPTY))
+        return false;
+
+    auto placements = [&](const Board &on, const Player &opponent) {
+        size_t count = 0;
+        for (const Tile &tile : tiles) {
+            std::vector<Shape> shapes;
+            for (const Tile &oriented : orientations(tile))
+                if (std::find(shapes.begin(), shapes.end(), oriented.getShape()) == shapes.end())
+                    shapes.push_back(oriented.getShape());
+            for (const Shape &shape : shapes)
+                count += on.legalAnchors(shape, opponent).size();
+        }
+        return count;
+    };
+
+    for (size_t sample = 0; sample < 4 && !impacts.empty(); ++sample) {
+        const StoneImpact &impact = impacts[gen() % impacts.size()];
+        Board stoned(board);
+        stoned.setCell(impact.coords, STONE, nullptr);
+
+        size_t removed = 0, loss = 0;
+        for (const Player &opponent : players) {
+            if (&opponent == &player || board.territory(opponent).area == 0)
+                continue;
+            removed += placements(board, opponent) - placements(stoned, opponent);
+            loss += naivePotential(board, opponent) - naivePotential(stoned, opponent);
+        }
+        if (removed != impact.placements || loss != impact.squareLoss)
+            return false;
+    }
+    return true;
+}
+
+/**
+Types and owners of the cells of a board, kept up to date from its events only.
+*/
+class CellMirror : public BoardObserver<CellMirror> {
+  private:
+    size_t size;
+    std::vector<std::pair<CellType, const Player *>> cells;
+
+    void set(std::pair<size_t, size_t> coords, CellType type, const Player *owner) { cells[coords.first * size + coords.second] = {type, owner}; }
+
+  public:
+    CellMirror(const Board &board) : size(board.getSize()) {
+        for (size_t x = 0; x < size; ++x)
+            for (size_t y = 0; y < size; ++y)
+                cells.push_back({board.getCell({x, y}).type, board.getCell({x, y}).owner});
+    }
+
+    void onCellsCovered(const CellsCovered &event) {
+        for (const auto &coords : event.cells)
+            set(coords, GRASS, event.player);
+    }
+    void onBonusCaptured(const BonusCaptured &event) { set(event.coords, GRASS, event.player); }
+    void onStonePlaced(const StonePlaced &event) { set(event.coords, STONE, nullptr); }
+    void onStoneRemoved(const StoneRemoved &event) { set(event.coords, EMPTY, nullptr); }
+    void onTileStolen(const TileStolen &event) {
+        for (const auto &coords : event.cells)
+            set(coords, EMPTY, nullptr);
+    }
+    void onCellChanged(const CellChanged &event) { set(event.coords, event.type, event.owner); }
+
+    bool matches(const Board &board) const {
+        for (size_t x = 0; x < size; ++x)
+            for (size_t y = 0; y < size; ++y)
+                if (cells[x * size + y] != std::make_pair(board.getCell({x, y}).type, static_cast<const Player *>(board.getCell({x, y}).owner)))
+                    return false;
+        return true;
+    }
+};
+
+/**
+Random legal play on one board size, with as many players as the size allows.
+Returns false if the indexed results differ from the reference.
+*/
+static bool run(size_t size, uint64_t seed, size_t sample) {
+    size_t nbPlayers = std::clamp<size_t>(size * size / 100, Game::minPlayers, Game::maxPlayers);
+
+    std::vector<Player> players;
+    players.reserve(nbPlayers); // Cells point to players
+    for (size_t p = 0; p < nbPlayers; ++p)
+        players.emplace_back("P" + std::to_string(p + 1), static_cast<PlayerColor>(p % 9));
+
+    Board board(size, nbPlayers, seed);
+    TileQueue queue(nbPlayers, seed);
+    std::mt19937 gen(static_cast<uint32_t>(seed));
+    CellMirror mirror(board);
+    board.attach(mirror);
+
+    // Starting tiles at random free spots
+    Tile startingTile = Tile::fromId(STARTING_TILE_ID);
+    for (Player &player : players) {
+        for (size_t attempt = 0; attempt < 1000; ++attempt) {
+            std::pair<size_t, size_t> coords{gen() % size, gen() % size};
+            if (board.canPlaceTile(coords, startingTile, player, true)) {
+                board.placeTile(coords, startingTile, &player, false);
+                break;
+            }
+        }
+    }
+
+    Timer anywhere, anchors, scan, place, square, rescore, reference, steal, analytics, deltas, stones;
+    size_t nbTurns = 0, nbMismatches = 0;
+
+    for (size_t round = 0; round < 9; ++round) {
+        for (Player &player : players) {
+            if (queue.getTiles().empty())
+                break;
+            Tile tile = queue.drawTile();
+            bool bSampled = nbTurns++ % sample == 0;
+
+            if (!anywhere.measure([&] { return board.canPlaceTileAnywhere(tile, player); }))
+                continue;
+
+            std::vector<std::pair<Tile, std::pair<size_t, size_t>>> moves;
+            for (const Tile &oriented : orientations(tile)) {
+                const Shape &shape = oriented.getShape();
+                auto found = anchors.measure([&] { return board.legalAnchors(shape, player); });
+                if (bSampled && scan.measure([&] { return scanAnchors(board, shape, player); }) != found)
+                    ++nbMismatches;
+                for (const auto &coords : found)
+                    moves.push_back({oriented, coords});
+            }
+
+            const auto &[chosen, coords] = moves[gen() % moves.size()];
+            place.measure([&] { board.placeTile(coords, chosen, &player, true); return 0; });
+
+            Square best = square.measure([&] { return board.largestSquare(player); });
+            analytics.measure([&] { return board.territory(player).area + board.bonusDistances(player).size(); });
+            deltas.measure([&] { return board.robberyDeltas(player).size(); });
+            std::span<const Tile> coming = queue.nextTiles();
+            stones.measure([&] { return board.stoneImpacts(player, coming).size(); });
+            if (bSampled) {
+                Board fresh(board); // Copies start without cached squares
+                Square full = rescore.measure([&] { return fresh.largestSquare(player); });
+                Square expected = reference.measure([&] { return scanSquare(board, player); });
+                if (expected.side != best.side || expected.corner != best.corner || full.side != best.side || full.corner != best.corner)
+                    ++nbMismatches;
+                if (!censusMatches(board, player))
+                    ++nbMismatches;
+                if (!territoryMatches(board, player))
+                    ++nbMismatches;
+                if (!mirror.matches(board))
+                    ++nbMismatches;
+                if (size <= 64 && !robberiesMatch(board, player))
+                    ++nbMismatches;
+                if (size <= 32 && !stonesMatch(board, players, player, coming, nbTurns))
+                    ++nbMismatches;
+            }
+
+            // A robbery now and then, on a random enemy tile
+            if (gen() % 8 == 0) {
+                std::optional<std::pair<size_t, size_t>> target = board.sampleStealable(player, gen);
+                if (target && !steal.measure([&] { return board.stealTile(*target, &player); }))
+                    ++nbMismatches;
+            }
+        }
+    }
+
+    std::ostringstream name;
+    name << size << "x" << size;
+    std::cout << std::left << std::setw(10) << name.str() << std::right
+              << std::setw(8) << nbPlayers << std::setw(8) << nbTurns << std::fixed << std::setprecision(1)
+              << std::setw(11) << anywhere.average()
+              << std::setw(11) << anchors.average() * 8
+              << std::setw(11) << scan.average() * 8
+              << std::setw(11) << place.average()
+              << std::setw(11) << square.average()
+              << std::setw(11) << rescore.average()
+              << std::setw(11) << reference.average()
+              << std::setw(11) << steal.average()
+              << std::setw(11) << analytics.average()
+              << std::setw(11) << deltas.average()
+              << std::setw(11) << stones.average()
+              << (nbMismatches ? "  MISMATCH" : "") << std::endl;
+
+    return nbMismatches == 0;
+}
+
+/**
+Cost of a turn as the board grows.
+Each size is played with random legal moves, and every operation is timed per turn in microseconds.
+On sampled turns, anchors, squares, the census, a copy of the cells kept from board events, components, bonus distances, robbery deltas (up to 64x64) and stone impacts (up to 32x32) are checked against serial scans of the whole board,
+and the largest square is computed again from scratch (rescore).
+*/
+int main(int argc, char **argv) {
+    std::vector<size_t> sizes{32, 64, 128, 256, 512};
+    uint64_t seed = 1;
+    size_t sample = 16;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--sizes" && i + 1 < argc) {
+            sizes.clear();
+            std::istringstream list(argv[++i]);
+            std::string item;
+            while (std::getline(list, item, ','))
+                sizes.push_back(std::strtoul(item.c_str(), nullptr, 10));
+        } else if (arg == "--seed" && i + 1 < argc)
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--sample" && i + 1 < argc)
+            sample = std::max<size_t>(1, std::strtoul(argv[++i], nullptr, 10));
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--sizes 32,64,...] [--seed S] [--sample N]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << ThreadPool::shared().getNbThreads() << " threads" << std::endl;
+    std::cout << std::left << std::setw(10) << "board" << std::right
+              << std::setw(8) << "players" << std::setw(8) << "turns"
+              << std::setw(11) << "anywhere" << std::setw(11) << "anchors" << std::setw(11) << "scan"
+              << std::setw(11) << "place" << std::setw(11) << "square" << std::setw(11) << "rescore" << std::setw(11) << "reference"
+              << std::setw(11) << "steal" << std::setw(11) << "analytics" << std::setw(11) << "deltas" << std::setw(11) << "stones" << std::endl;
+
+    bool bMatched = true;
+    try {
+        for (size_t size : sizes)
+            bMatched = run(size, seed, sample) && bMatched;
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return bMatched ? 0 : 2;
+}
@@ -0,0 +1,243 @@
+#include "game.hpp"
+#include "opening_book.hpp"
+#include "record.hpp"
+#include "render.hpp"
+#include "scheduler.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Heap allocations of the whole program, counted by the replaced operator new.
+static std::atomic<size_t> nbAllocations{0};
+
+void* operator new(size_t count) {
+    nbAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *memory = std::malloc(count ? count : 1))
+        return memory;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept { std::free(memory); }
+void operator delete(void *memory, size_t) noexcept { std::free(memory); }
+
+// Value below which a fraction of the values fall, values are reordered.
+static double percentile(std::vector<double> &values, double fraction) {
+    if (values.empty())
+        return 0;
+    size_t rank = std::min(values.size() - 1, static_cast<size_t>(fraction * static_cast<double>(values.size())));
+    std::nth_element(values.begin(), values.begin() + rank, values.end());
+    return values[rank];
+}
+
+/**
+Bot self-play on a single scheduler thread.
+Every game is a coroutine, the scheduler interleaves them one decision at a time.
+Bot decisions are taken on the scheduler thread, or on a pool of worker threads with --threads.
+*/
+int main(int argc, char **argv) {
+    size_t nbGames = 100;
+    size_t nbPlayers = 4;
+    std::optional<uint64_t> seed;
+    size_t boardSize = 0; // Default size of the player count
+    std::string recordPath;
+    bool bWatch = false;
+    std::string logPath;
+    size_t nbThreads = 0;
+    double budget = 0; // Milliseconds per bot decision, none when zero
+    std::string bookPath;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--games" && i + 1 < argc)
+            nbGames = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--players" && i + 1 < argc)
+            nbPlayers = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--seed" && i + 1 < argc)
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--size" && i + 1 < argc)
+            boardSize = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--record" && i + 1 < argc)
+            recordPath = argv[++i];
+        else if (arg == "--watch")
+            bWatch = true;
+        else if (arg == "--log" && i + 1 < argc)
+            logPath = argv[++i];
+        else if (arg == "--threads" && i + 1 < argc)
+            nbThreads = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--budget" && i + 1 < argc)
+            budget = std::strtod(argv[++i], nullptr);
+        else if (arg == "--book" && i + 1 < argc)
+            bookPath = argv[++i];
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--games N] [--players N] [--seed S] [--size N] [--record FILE] [--watch] [--log FILE]"
+                      << " [--threads N] [--budget MS] [--book FILE]"
+                      << std::endl;
+            return 1;
+        }
+    }
+
+    if (nbPlayers < Game::minPlayers || nbPlayers > Game::maxPlayers) {
+        std::cerr << "Number of players must be between " << Game::minPlayers << " and " << Game::maxPlayers << "." << std::endl;
+        return 1;
+    }
+    if (boardSize == 0)
+        boardSize = Board::defaultSize(nbPlayers);
+    if (boardSize < Board::minSize || boardSize > Board::maxSize) {
+        std::cerr << "Board size must be between " << Board::minSize << " and " << Board::maxSize << "." << std::endl;
+        return 1;
+    }
+
+    // Game g of a seeded run uses seed + g
+    std::unique_ptr<RecordWriter> recorder;
+    if (!recordPath.empty())
+        recorder = std::make_unique<RecordWriter>(recordPath);
+
+    // The first game can be drawn and logged by an output thread, the games never wait for it
+    std::ofstream logFile;
+    if (!logPath.empty()) {
+        logFile.open(logPath);
+        if (!logFile) {
+            std::cerr << "Cannot open " << logPath << "." << std::endl;
+            return 1;
+        }
+    }
+    std::unique_ptr<RenderPipeline> pipeline;
+    if (bWatch || logFile.is_open())
+        pipeline = std::make_unique<RenderPipeline>(bWatch ? &std::cout : nullptr, logFile.is_open() ? &logFile : nullptr);
+
+    // Every bot looks its starting tile up in the same book
+    std::unique_ptr<OpeningBook> book;
+    if (!bookPath.empty()) {
+        try {
+            book = std::make_unique<OpeningBook>(bookPath);
+        } catch (const std::runtime_error &e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+    }
+    Bot bot;
+    bot.setOpeningBook(book.get());
+
+    std::random_device device;
+    Scheduler scheduler;
+    std::unique_ptr<DecisionPool> pool;
+    if (nbThreads > 0) {
+        pool = std::make_unique<DecisionPool>(nbThreads, nbGames);
+        scheduler.setDecisionPool(pool.get());
+    }
+    scheduler.setBudget(std::chrono::duration_cast<Deadline::Clock::duration>(std::chrono::duration<double, std::milli>(budget)));
+    std::vector<std::unique_ptr<Game>> games;
+    std::vector<std::unique_ptr<Seat>> seats;
+    std::vector<GameTask> tasks;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t g = 0; g < nbGames; ++g) {
+        uint64_t gameSeed = seed ? *seed + g : (uint64_t(device()) << 32 | device());
+        games.push_back(std::make_unique<Game>(nbPlayers, gameSeed, boardSize));
+        games.back()->setRecorder(recorder.get());
+        // Names and colors are chosen right away, setting the game up before play is counted
+        while (games.back()->pendingDecision().type <= CHOOSE_COLOR)
+            games.back()->submit(bot.decide(*games.back()));
+
+        std::vector<Seat *> gameSeats;
+        for (size_t p = 0; p < nbPlayers; ++p) {
+            seats.push_back(std::make_unique<Seat>(scheduler, bot));
+            gameSeats.push_back(seats.back().get());
+        }
+
+        SubmitCallback onSubmit;
+        if (pipeline && g == 0) {
+            pipeline->watch(*games.back());
+            pipeline->frame();
+            onSubmit = [&pipeline](size_t, const SubmitResult &result) {
+                if (result.bAccepted)
+                    pipeline->frame();
+            };
+        }
+
+        tasks.push_back(playGame(*games.back(), gameSeats, onSubmit));
+        scheduler.start(tasks.back());
+    }
+
+    // Games are set up and the shared shape tables built, what is allocated from now on is allocated while playing
+    Tile::fromId(0).getShape();
+    size_t nbSetupAllocations = nbAllocations;
+    scheduler.run();
+    size_t nbPlayAllocations = nbAllocations - nbSetupAllocations;
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    if (pipeline)
+        pipeline->close();
+
+    std::vector<size_t> wins(nbPlayers, 0);
+    for (size_t g = 0; g < nbGames; ++g) {
+        tasks[g].rethrow();
+        const Player &winner = games[g]->determineWinner();
+        ++wins[static_cast<size_t>(&winner - games[g]->getPlayers().data())];
+    }
+
+    std::cout << nbGames << " games in " << elapsed.count() << " s ("
+              << nbGames / elapsed.count() << " games/s)" << std::endl;
+    for (size_t p = 0; p < nbPlayers; ++p)
+        std::cout << "Seat " << (p + 1) << ": " << wins[p] << " wins" << std::endl;
+
+    // Percentiles of each game, then over the games
+    std::vector<double> medians, tails, worst;
+    for (size_t g = 0; g < nbGames; ++g) {
+        std::vector<double> latencies;
+        for (size_t p = 0; p < nbPlayers; ++p) {
+            const std::vector<double> &seat = seats[g * nbPlayers + p]->getLatencies();
+            latencies.insert(latencies.end(), seat.begin(), seat.end());
+        }
+        medians.push_back(percentile(latencies, 0.5));
+        tails.push_back(percentile(latencies, 0.99));
+        worst.push_back(percentile(latencies, 1.0));
+    }
+    std::cout << "Decision latency per game (us): p50 " << percentile(medians, 0.5) << ", p99 " << percentile(tails, 0.5)
+              << " (worst game " << percentile(tails, 1.0) << "), max " << percentile(worst, 1.0) << std::endl;
+    // Phases are tenths of the board covered by grass
+    std::array<AnchorStats, NB_ANCHOR_PHASES> anchors{};
+    for (const auto &game : games) {
+        for (size_t phase = 0; phase < NB_ANCHOR_PHASES; ++phase) {
+            anchors[phase].candidates += game->getBoard().getAnchorStats()[phase].candidates;
+            anchors[phase].pruned += game->getBoard().getAnchorStats()[phase].pruned;
+        }
+    }
+    std::cout << "Anchors pruned by board covered:";
+    for (size_t phase = 0; phase < NB_ANCHOR_PHASES; ++phase)
+        if (anchors[phase].candidates > 0)
+            std::cout << " " << phase * 10 << "-" << (phase + 1) * 10 << "% " << std::fixed << std::setprecision(1)
+                      << 100.0 * static_cast<double>(anchors[phase].pruned) / static_cast<double>(anchors[phase].candidates) << "%"
+                      << std::defaultfloat << std::setprecision(6);
+    std::cout << std::endl;
+    std::cout << "Heap allocations while playing: " << nbPlayAllocations << " (" << nbPlayAllocations / std::max<size_t>(nbGames, 1)
+              << " per game)" << std::endl;
+    if (pool)
+        std::cout << pool->getNbWorkers() << " decision threads, " << pool->getNbStolen() << " decisions stolen, "
+                  << pool->getNbLate() << " started late" << std::endl;
+    if (book)
+        std::cout << "Opening book: " << book->getNbEntries() << " positions, " << book->getNbHits() << " hits, "
+                  << book->getNbMisses() << " misses" << std::endl;
+    if (pipeline)
+        std::cout << pipeline->getNbFrames() << " frames drawn, " << pipeline->getNbSkipped() << " skipped" << std::endl;
+
+    // Recording and drawing copy what they keep, plain play takes its memory when games are set up
+    if (nbPlayAllocations > 0 && !recorder && !pipeline) {
+        std::cerr << nbPlayAllocations << " heap allocations while playing, none expected." << std::endl;
+        return 1;
+    }
+    return 0;
+}
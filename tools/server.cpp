@@ -0,0 +1,70 @@
+#include "server.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+int main(int argc, char **argv) {
+    std::string unixPath = "/tmp/layingrass.sock";
+    int tcpPort = -1;
+    std::string recordPath;
+    std::string checkpointDirectory;
+    size_t nbBotThreads = 0;
+    double budget = 0; // Milliseconds per bot decision, none when zero
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--unix" && i + 1 < argc)
+            unixPath = argv[++i];
+        else if (arg == "--tcp" && i + 1 < argc)
+            tcpPort = std::atoi(argv[++i]);
+        else if (arg == "--record" && i + 1 < argc)
+            recordPath = argv[++i];
+        else if (arg == "--checkpoint" && i + 1 < argc)
+            checkpointDirectory = argv[++i];
+        else if (arg == "--bot-threads" && i + 1 < argc)
+            nbBotThreads = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--budget" && i + 1 < argc)
+            budget = std::strtod(argv[++i], nullptr);
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--unix PATH | --tcp PORT] [--record FILE] [--checkpoint DIR]"
+                      << " [--bot-threads N] [--budget MS]" << std::endl;
+            return 1;
+        }
+    }
+
+    try {
+        std::unique_ptr<RecordWriter> recorder;
+        if (!recordPath.empty())
+            recorder = std::make_unique<RecordWriter>(recordPath);
+
+        Server server;
+        server.setRecorder(recorder.get());
+
+        // Declared after the server, so that its threads stop while the games they decide for still exist
+        std::unique_ptr<DecisionPool> pool;
+        if (nbBotThreads > 0)
+            pool = std::make_unique<DecisionPool>(nbBotThreads);
+        server.setDecisionPool(pool.get(), std::chrono::duration_cast<Deadline::Clock::duration>(
+                                               std::chrono::duration<double, std::milli>(budget)));
+        if (!checkpointDirectory.empty()) {
+            server.setCheckpointDirectory(checkpointDirectory);
+            std::cout << "Resumed " << server.resumeTables() << " games from " << checkpointDirectory << std::endl;
+        }
+        if (tcpPort > 0) {
+            server.listenTcp(static_cast<uint16_t>(tcpPort));
+            std::cout << "Listening on 127.0.0.1:" << tcpPort << std::endl;
+        } else {
+            server.listenUnix(unixPath);
+            std::cout << "Listening on " << unixPath << std::endl;
+        }
+        server.run();
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
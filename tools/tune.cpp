@@ -0,0 +1,212 @@
+#include "bot.hpp"
+#include "game.hpp"
+#include "mapped_file.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using Parameters = std::array<double, 4>;
+
+static const std::array<const char *, 4> PARAMETER_NAMES = {"squarePotential", "frontier", "bonusProximity", "blocking"};
+
+static BotWeights toWeights(const Parameters &theta) {
+    return BotWeights{theta[0], theta[1], theta[2], theta[3]};
+}
+
+/**
+State of a tuning run, saved after every iteration so that an interrupted run resumes where it stopped.
+*/
+struct TuningState {
+    uint64_t seed = 1;
+    size_t nbPlayers = 4;
+    size_t nbGames = 64; // Games per candidate and iteration
+    size_t iteration = 0;
+    Parameters theta{};
+};
+
+static void saveState(const TuningState &state, const std::string &path) {
+    // Written next to the previous one then renamed over it, like snapshots
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary);
+        out.precision(17);
+        out << "seed " << state.seed << "\nplayers " << state.nbPlayers << "\ngames " << state.nbGames
+            << "\niteration " << state.iteration << "\n";
+        for (size_t i = 0; i < state.theta.size(); ++i)
+            out << PARAMETER_NAMES[i] << " " << state.theta[i] << "\n";
+        if (!out)
+            throw std::runtime_error("Cannot write checkpoint " + temporary);
+    }
+    if (!replaceFile(temporary, path))
+        throw std::runtime_error("Cannot replace checkpoint " + path);
+}
+
+static bool loadState(TuningState &state, const std::string &path) {
+    std::ifstream in(path);
+    if (!in)
+        return false;
+
+    std::string key;
+    while (in >> key) {
+        if (key == "seed")
+            in >> state.seed;
+        else if (key == "players")
+            in >> state.nbPlayers;
+        else if (key == "games")
+            in >> state.nbGames;
+        else if (key == "iteration")
+            in >> state.iteration;
+        else {
+            size_t i = 0;
+            while (i < PARAMETER_NAMES.size() && key != PARAMETER_NAMES[i])
+                ++i;
+            if (i == PARAMETER_NAMES.size() || !(in >> state.theta[i]))
+                throw std::runtime_error("Corrupted checkpoint " + path);
+        }
+    }
+    return true;
+}
+
+// Fitness of the candidate in one game against baseline bots : a win, plus its square against the best other one.
+static double playGame(uint64_t seed, size_t nbPlayers, size_t seat, const BotWeights &candidate) {
+    Game game(nbPlayers, seed);
+    Bot bot(candidate);
+    Bot baseline;
+
+    while (!game.isOver()) {
+        const Bot &player = game.pendingDecision().playerIndex == seat ? bot : baseline;
+        SubmitResult result = game.submit(player.decide(game));
+        if (!result.bAccepted)
+            throw std::runtime_error("Bot decision rejected: " + std::string(result.message));
+    }
+
+    const std::vector<Player> &players = game.getPlayers();
+    size_t own = game.getBoard().largestSquare(players[seat]).side;
+    size_t best = 0;
+    for (size_t p = 0; p < players.size(); ++p)
+        if (p != seat)
+            best = std::max(best, game.getBoard().largestSquare(players[p]).side);
+
+    double win = &game.determineWinner() == &players[seat] ? 1.0 : 0.0;
+    return win + 0.1 * (static_cast<double>(own) - static_cast<double>(best));
+}
+
+/**
+Tuning of the bot weights with SPSA (simultaneous perturbation stochastic approximation).
+Each iteration moves every weight at once by +c or -c at random, and plays both candidates against bots with the
+default weights on the same seeds, so both meet the same bonus layouts and tile queues from the same seat.
+The difference of their fitness estimates the gradient. Games are spread over the shared thread pool.
+*/
+int main(int argc, char **argv) {
+    TuningState state;
+    size_t nbIterations = 50;
+    std::string checkpointPath;
+    double a = 0.2;  // Step size
+    double c = 0.15; // Perturbation size
+    double A = 5;    // Steps are smaller over the first iterations, while gradients are the noisiest
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--iterations" && i + 1 < argc)
+            nbIterations = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--games" && i + 1 < argc)
+            state.nbGames = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--players" && i + 1 < argc)
+            state.nbPlayers = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--seed" && i + 1 < argc)
+            state.seed = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--checkpoint" && i + 1 < argc)
+            checkpointPath = argv[++i];
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--iterations N] [--games N] [--players N] [--seed S] [--checkpoint FILE]" << std::endl;
+            return 1;
+        }
+    }
+
+    BotWeights defaults;
+    state.theta = {defaults.squarePotential, defaults.frontier, defaults.bonusProximity, defaults.blocking};
+
+    try {
+        // An existing checkpoint wins over the options, the run goes on with its own settings
+        if (!checkpointPath.empty() && loadState(state, checkpointPath))
+            std::cout << "Resuming from iteration " << state.iteration << std::endl;
+
+        if (state.nbPlayers < Game::minPlayers || state.nbPlayers > Game::maxPlayers || state.nbGames == 0) {
+            std::cerr << "Number of players must be between " << Game::minPlayers << " and " << Game::maxPlayers
+                      << ", with at least one game." << std::endl;
+            return 1;
+        }
+
+        ThreadPool &pool = ThreadPool::shared();
+        std::cout << "Tuning on " << pool.getNbThreads() << " threads, " << 2 * state.nbGames << " games per iteration"
+                  << std::endl;
+
+        std::vector<double> fitness(2 * state.nbGames);
+        for (; state.iteration < nbIterations; ++state.iteration) {
+            auto start = std::chrono::steady_clock::now();
+            size_t k = state.iteration;
+            double ak = a / std::pow(k + 1 + A, 0.602);
+            double ck = c / std::pow(k + 1, 0.101);
+
+            // The perturbation and the seeds only depend on the iteration, so a resumed run plays the same games
+            std::mt19937_64 rng(state.seed ^ (0x9E3779B97F4A7C15ULL * (k + 1)));
+            Parameters delta, plus, minus;
+            for (size_t i = 0; i < delta.size(); ++i) {
+                delta[i] = rng() & 1 ? 1.0 : -1.0;
+                plus[i] = std::max(0.0, state.theta[i] + ck * delta[i]);
+                minus[i] = std::max(0.0, state.theta[i] - ck * delta[i]);
+            }
+            uint64_t firstSeed = rng();
+
+            // Game g of both candidates share the seed and the seat
+            pool.parallelFor(2 * state.nbGames, [&](size_t task) {
+                size_t g = task / 2;
+                const Parameters &candidate = task % 2 == 0 ? plus : minus;
+                fitness[task] = playGame(firstSeed + g, state.nbPlayers, g % state.nbPlayers, toWeights(candidate));
+            });
+
+            double sumPlus = 0, sumMinus = 0;
+            for (size_t g = 0; g < state.nbGames; ++g) {
+                sumPlus += fitness[2 * g];
+                sumMinus += fitness[2 * g + 1];
+            }
+            double difference = (sumPlus - sumMinus) / static_cast<double>(state.nbGames);
+
+            for (size_t i = 0; i < state.theta.size(); ++i)
+                state.theta[i] = std::max(0.0, state.theta[i] + ak * difference / (2 * ck * delta[i]));
+
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            std::cout << "Iteration " << (k + 1) << ": +" << sumPlus / state.nbGames << " -" << sumMinus / state.nbGames
+                      << " in " << elapsed.count() << " s, weights";
+            for (double weight : state.theta)
+                std::cout << " " << weight;
+            std::cout << std::endl;
+
+            if (!checkpointPath.empty()) {
+                TuningState saved = state;
+                ++saved.iteration;
+                saveState(saved, checkpointPath);
+            }
+        }
+
+        std::cout << "BotWeights{";
+        for (size_t i = 0; i < state.theta.size(); ++i)
+            std::cout << (i ? ", " : "") << state.theta[i];
+        std::cout << "}" << std::endl;
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}